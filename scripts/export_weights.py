@@ -1,8 +1,11 @@
 import torch
 import torch.nn as nn
 import numpy as np
+import argparse
+import struct
 import sys
 import os
+import zlib
 
 # Add parent directory to path to import model
 sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
@@ -47,72 +50,150 @@ def fuse_conv_bn_relu(conv, bn):
 
     return w_fused, b_fused
 
-def export_to_binary(model, output_path):
-    print(f"Exporting model to {output_path}...")
-    
-    with open(output_path, 'wb') as f:
-        # Helper to write tensor
-        def write_tensor(name, tensor):
-            data = tensor.cpu().numpy().astype(np.float32)
-            print(f"Writing {name}: shape={data.shape}, size={data.size}")
-            # Write dims count
-            f.write(np.array([len(data.shape)], dtype=np.int32).tobytes())
-            # Write dims
-            f.write(np.array(data.shape, dtype=np.int32).tobytes())
-            # Write data
-            f.write(data.tobytes())
-
-        # 1. Input Block
-        w, b = fuse_conv_bn_relu(model.conv_input, model.bn_input)
-        write_tensor("input_conv_w", w)
-        write_tensor("input_conv_b", b)
-
-        # 2. ResBlocks
-        for i, block in enumerate(model.res_blocks):
-            # Conv1
-            w1, b1 = fuse_conv_bn_relu(block.conv1, block.bn1)
-            write_tensor(f"res{i}_conv1_w", w1)
-            write_tensor(f"res{i}_conv1_b", b1)
-            
-            # Conv2
-            w2, b2 = fuse_conv_bn_relu(block.conv2, block.bn2)
-            write_tensor(f"res{i}_conv2_w", w2)
-            write_tensor(f"res{i}_conv2_b", b2)
-
-        # 3. Move Head
-        w_move, b_move = fuse_conv_bn_relu(model.move_conv, model.move_bn)
-        write_tensor("move_head_conv_w", w_move)
-        write_tensor("move_head_conv_b", b_move)
-        
-        write_tensor("move_head_fc_w", model.move_fc.weight.detach())
-        write_tensor("move_head_fc_b", model.move_fc.bias.detach())
-
-        # 4. Tile Head
-        w_tile, b_tile = fuse_conv_bn_relu(model.tile_conv, model.tile_bn)
-        write_tensor("tile_head_conv_w", w_tile)
-        write_tensor("tile_head_conv_b", b_tile)
+# Model file format, version 1 (see wasm/model_file.h; keep the two in sync).
+# Little-endian:
+#   header   magic "CTRSTNN\0", version, alignment, arch field count,
+#            tensor count, file size, CRC-32 of everything after the header
+#   arch     int32 architecture parameters (ModelArch)
+#   table    per tensor: name[48], dtype, ndims, dims[4], offset, bytes
+#   data     each tensor at a multiple of ALIGN
+MAGIC = b"CTRSTNN\0"
+VERSION = 1
+ALIGN = 64
+NAME_LEN = 48
+MAX_DIMS = 4
+DTYPE_FLOAT32 = 0
+DTYPE_INT8 = 1
+HEADER = struct.Struct("<8sIIIIQII")
+ENTRY = struct.Struct("<%dsII%diQQ" % (NAME_LEN, MAX_DIMS))
+
+
+def quantize_rows(data):
+    """Symmetric per-row int8, as quant_weight_scale() in wasm/quant.h"""
+    rows = data.reshape(data.shape[0], -1)
+    max_abs = np.abs(rows).max(axis=1)
+    scales = np.where(max_abs > 0, max_abs / 127.0, 1.0).astype(np.float32)
+    q = np.rint(rows / scales[:, None]).clip(-127, 127).astype(np.int8)
+    return q.reshape(data.shape), scales
+
+
+def write_model_file(output_path, arch, tensors):
+    """tensors: list of (name, dtype, ndarray)"""
+    table = b""
+    blobs = []
+    offset = HEADER.size + 4 * len(arch) + ENTRY.size * len(tensors)
+    for name, dtype, data in tensors:
+        assert len(name) < NAME_LEN and 1 <= data.ndim <= MAX_DIMS
+        offset = (offset + ALIGN - 1) // ALIGN * ALIGN
+        raw = data.tobytes()
+        dims = list(data.shape) + [0] * (MAX_DIMS - data.ndim)
+        table += ENTRY.pack(name.encode(), dtype, data.ndim, *dims, offset, len(raw))
+        blobs.append((offset, raw))
+        offset += len(raw)
+
+    body = bytearray(offset - HEADER.size)
+    pos = 0
+    for section in (struct.pack("<%di" % len(arch), *arch), table):
+        body[pos:pos + len(section)] = section
+        pos += len(section)
+    for blob_offset, raw in blobs:
+        start = blob_offset - HEADER.size
+        body[start:start + len(raw)] = raw
+
+    header = HEADER.pack(MAGIC, VERSION, ALIGN, len(arch), len(tensors), offset, zlib.crc32(body), 0)
+    with open(output_path, "wb") as f:
+        f.write(header)
+        f.write(body)
+
+
+def export_to_binary(model, output_path, int8=False):
+    print(f"Exporting model to {output_path}{' (int8 weights)' if int8 else ''}...")
+    tensors = []
+
+    # Weights ("_w") are stored as per-row int8 plus "_scale" with int8=True;
+    # biases always stay float32
+    def write_tensor(name, tensor):
+        data = tensor.detach().cpu().numpy().astype(np.float32)
+        print(f"Writing {name}: shape={data.shape}, size={data.size}")
+        if int8 and name.endswith("_w"):
+            q, scales = quantize_rows(data)
+            tensors.append((name, DTYPE_INT8, q))
+            tensors.append((name + "_scale", DTYPE_FLOAT32, scales))
+        else:
+            tensors.append((name, DTYPE_FLOAT32, data))
+
+    # 1. Input Block
+    w, b = fuse_conv_bn_relu(model.conv_input, model.bn_input)
+    write_tensor("input_conv_w", w)
+    write_tensor("input_conv_b", b)
+
+    # 2. ResBlocks
+    for i, block in enumerate(model.res_blocks):
+        # Conv1
+        w1, b1 = fuse_conv_bn_relu(block.conv1, block.bn1)
+        write_tensor(f"res{i}_conv1_w", w1)
+        write_tensor(f"res{i}_conv1_b", b1)
         
-        write_tensor("tile_head_fc_w", model.tile_fc.weight.detach())
-        write_tensor("tile_head_fc_b", model.tile_fc.bias.detach())
+        # Conv2
+        w2, b2 = fuse_conv_bn_relu(block.conv2, block.bn2)
+        write_tensor(f"res{i}_conv2_w", w2)
+        write_tensor(f"res{i}_conv2_b", b2)
+
+    # 3. Move Head
+    w_move, b_move = fuse_conv_bn_relu(model.move_conv, model.move_bn)
+    write_tensor("move_head_conv_w", w_move)
+    write_tensor("move_head_conv_b", b_move)
+    
+    write_tensor("move_head_fc_w", model.move_fc.weight.detach())
+    write_tensor("move_head_fc_b", model.move_fc.bias.detach())
 
-        # 5. Value Head
-        w_val, b_val = fuse_conv_bn_relu(model.value_conv, model.value_bn)
-        write_tensor("val_head_conv_w", w_val)
-        write_tensor("val_head_conv_b", b_val)
-        
-        write_tensor("val_head_fc1_w", model.value_fc1.weight.detach())
-        write_tensor("val_head_fc1_b", model.value_fc1.bias.detach())
-        
-        write_tensor("val_head_fc2_w", model.value_fc2.weight.detach())
-        write_tensor("val_head_fc2_b", model.value_fc2.bias.detach())
+    # 4. Tile Head
+    w_tile, b_tile = fuse_conv_bn_relu(model.tile_conv, model.tile_bn)
+    write_tensor("tile_head_conv_w", w_tile)
+    write_tensor("tile_head_conv_b", b_tile)
+    
+    write_tensor("tile_head_fc_w", model.tile_fc.weight.detach())
+    write_tensor("tile_head_fc_b", model.tile_fc.bias.detach())
 
-    print("Export complete.")
+    # 5. Value Head
+    w_val, b_val = fuse_conv_bn_relu(model.value_conv, model.value_bn)
+    write_tensor("val_head_conv_w", w_val)
+    write_tensor("val_head_conv_b", b_val)
+    
+    write_tensor("val_head_fc1_w", model.value_fc1.weight.detach())
+    write_tensor("val_head_fc1_b", model.value_fc1.bias.detach())
+    
+    write_tensor("val_head_fc2_w", model.value_fc2.weight.detach())
+    write_tensor("val_head_fc2_b", model.value_fc2.bias.detach())
+
+    # Architecture section, in ModelArch field order
+    arch = [
+        model.board_size,
+        model.conv_input.in_channels,
+        model.conv_input.out_channels,
+        len(model.res_blocks),
+        model.move_conv.out_channels,
+        model.tile_conv.out_channels,
+        model.value_conv.out_channels,
+        model.value_fc1.out_features,
+        model.move_fc.out_features,
+        model.tile_fc.out_features,
+    ]
+    write_model_file(output_path, arch, tensors)
+    print(f"Export complete ({os.path.getsize(output_path) // 1024} KB).")
 
 if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Export a trained model for the C++/WASM engine")
+    parser.add_argument("--model", default="models/contrast_model_final.pth")
+    parser.add_argument("--output", default="wasm/model.bin")
+    parser.add_argument("--int8", action="store_true",
+                        help="store weights as per-row int8 (about 4x smaller download)")
+    args = parser.parse_args()
+
     device = torch.device('cpu')
     
     # Load Model
-    model_path = "models/contrast_model_final.pth"
+    model_path = args.model
     if not os.path.exists(model_path):
         print(f"Error: {model_path} not found")
         sys.exit(1)
@@ -123,7 +204,7 @@ if __name__ == "__main__":
     model.eval()
 
     # Create output directory
-    os.makedirs("wasm", exist_ok=True)
+    os.makedirs(os.path.dirname(args.output) or ".", exist_ok=True)
     
     # Export
-    export_to_binary(model, "wasm/model.bin")
+    export_to_binary(model, args.output, int8=args.int8)
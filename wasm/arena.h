@@ -0,0 +1,64 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
+
+// Bump allocator over one preallocated float buffer, for the scratch memory
+// of inference. Layers take what they need with alloc() and hand it back
+// with release(mark()) when they return, so the peak use of a forward pass
+// is known up front (see the *_workspace() functions) and the buffer is
+// sized once. Blocks are 64-byte aligned for the SIMD kernels.
+class Arena {
+public:
+    static constexpr size_t ALIGN_FLOATS = 16;
+
+    // Floats a block of n floats occupies
+    static size_t rounded(size_t n) { return (n + ALIGN_FLOATS - 1) / ALIGN_FLOATS * ALIGN_FLOATS; }
+
+    Arena() {}
+    explicit Arena(size_t floats) { reserve(floats); }
+
+    // Grows the buffer to at least `floats`. Invalidates every block, so only
+    // call it between passes.
+    void reserve(size_t floats) {
+        assert(top == 0);
+        if (floats <= cap) return;
+        storage.assign(floats + ALIGN_FLOATS, 0.0f);
+        size_t misalign = reinterpret_cast<uintptr_t>(storage.data()) / sizeof(float) % ALIGN_FLOATS;
+        base = storage.data() + (misalign ? ALIGN_FLOATS - misalign : 0);
+        cap = floats;
+    }
+
+    float* alloc(size_t n) {
+        size_t size = rounded(n);
+        assert(top + size <= cap && "arena sized too small for this pass");
+        float* p = base + top;
+        top += size;
+        if (top > peak) peak = top;
+        return p;
+    }
+
+    // Block of n elements of a type no wider than float (e.g. int16_t)
+    template <class T> T* alloc_as(size_t n) {
+        static_assert(sizeof(T) <= sizeof(float) && alignof(T) <= alignof(float), "arena holds floats");
+        return reinterpret_cast<T*>(alloc((n * sizeof(T) + sizeof(float) - 1) / sizeof(float)));
+    }
+
+    size_t mark() const { return top; }
+    void release(size_t m) { top = m; }
+
+    size_t capacity() const { return cap; }
+    size_t peak_use() const { return peak; }
+
+private:
+    std::vector<float> storage;
+    float* base = nullptr;
+    size_t cap = 0;
+    size_t top = 0;
+    size_t peak = 0;
+};
+
+#endif // ARENA_H
@@ -0,0 +1,591 @@
+#include "game.h"
+#include "mcts.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Native micro-benchmarks for the engine hot paths.
+// Usage: ./bench_main [section] [model.bin]   (default: all sections, wasm/model.bin)
+// Sections that need the network are skipped when the model cannot be loaded.
+
+using bench_clock = std::chrono::steady_clock;
+
+static double seconds_since(bench_clock::time_point t0) {
+    return std::chrono::duration<double>(bench_clock::now() - t0).count();
+}
+
+// Positions sampled from random playouts, so the mix of tiles and pieces is realistic
+static std::vector<ContrastGame> sample_positions(int count, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::vector<ContrastGame> out;
+    ContrastGame game;
+    while ((int)out.size() < count) {
+        if (game.game_over || game.move_count >= MAX_STEPS) game.reset();
+        out.push_back(game.copy());
+        auto actions = game.get_all_legal_actions();
+        game.step(actions[rng() % actions.size()]);
+    }
+    return out;
+}
+
+static void bench_movegen() {
+    const int positions = 20000;
+    const int rounds = 20;
+    auto games = sample_positions(positions, 7);
+
+    long long checksum = 0;
+    auto t0 = bench_clock::now();
+    for (int r = 0; r < rounds; ++r)
+        for (auto& g : games) checksum += g.scan_legal_actions().size();
+    double t_scan = seconds_since(t0);
+
+    long long checksum_bb = 0;
+    t0 = bench_clock::now();
+    for (int r = 0; r < rounds; ++r)
+        for (auto& g : games) checksum_bb += g.get_all_legal_actions().size();
+    double t_bb = seconds_since(t0);
+
+    double calls = (double)positions * rounds;
+    std::cout << "[movegen] array scan: " << t_scan / calls * 1e9 << " ns/call" << std::endl;
+    std::cout << "[movegen] bitboard:   " << t_bb / calls * 1e9 << " ns/call"
+              << "  (x" << t_scan / t_bb << ")" << std::endl;
+    if (checksum != checksum_bb) std::cout << "[movegen] WARNING: action counts differ" << std::endl;
+}
+
+static void bench_copy_step() {
+    const int positions = 20000;
+    const int rounds = 20;
+    auto games = sample_positions(positions, 11);
+    std::vector<int> first_action;
+    for (auto& g : games) {
+        auto actions = g.get_all_legal_actions();
+        first_action.push_back(actions.empty() ? -1 : actions[0]);
+    }
+
+    long long checksum = 0;
+    auto t0 = bench_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        for (int i = 0; i < positions; ++i) {
+            if (first_action[i] < 0) continue;
+            ContrastGame scratch = games[i].copy();
+            scratch.step(first_action[i]);
+            checksum += scratch.move_count;
+        }
+    }
+    double t = seconds_since(t0);
+    std::cout << "[copy] copy()+step(): " << t / ((double)positions * rounds) * 1e9 << " ns/call"
+              << "  (state " << sizeof(ContrastState) << " bytes, checksum " << checksum << ")" << std::endl;
+}
+
+// Per-layer convolution timings: direct loop vs im2col + GEMM, for each
+// layer shape of the network at batch 1 and 16. Random weights, no model needed.
+static void bench_conv() {
+    struct Layer { const char* name; int in_c, out_c, k, pad; };
+    const Layer layers[] = {
+        {"input 66->64 3x3", 66, 64, 3, 1},
+        {"res   64->64 3x3", 64, 64, 3, 1},
+        {"move  64->32 1x1", 64, 32, 1, 0},
+        {"tile  64->16 1x1", 64, 16, 1, 0},
+        {"value 64->4  1x1", 64, 4, 1, 0},
+    };
+    std::mt19937 rng(3);
+    std::normal_distribution<float> dist(0.0f, 0.1f);
+
+    for (const Layer& l : layers) {
+        Conv2d conv(l.in_c, l.out_c, l.k, 1, l.pad);
+        std::vector<float> w(l.out_c * l.in_c * l.k * l.k), b(l.out_c);
+        for (auto& x : w) x = dist(rng);
+        for (auto& x : b) x = dist(rng);
+        conv.load_weights(w, b);
+
+        for (int n : {1, 16}) {
+            Tensor x({n, l.in_c, 5, 5});
+            for (auto& v : x.data) v = dist(rng);
+            int reps = std::max(2, 2000 / n);
+
+            volatile float sink = 0.0f; // Keeps the outputs observable
+            auto t0 = bench_clock::now();
+            for (int r = 0; r < reps; ++r) sink = conv.forward_reference(x)[0];
+            double t_ref = seconds_since(t0) / reps;
+
+            t0 = bench_clock::now();
+            for (int r = 0; r < reps; ++r) sink = conv.forward(x)[0];
+            double t_gemm = seconds_since(t0) / reps;
+
+            std::cout << "[conv] " << l.name << " N=" << n << ": direct " << t_ref * 1e6 << " us, gemm "
+                      << t_gemm * 1e6 << " us  (x" << t_ref / t_gemm << ", checksum " << sink << ")" << std::endl;
+        }
+    }
+}
+
+// Each SIMD variant on the 800x625 move_fc product and, with a model, on a full forward pass
+static void bench_simd(ContrastDualPolicyNet* net) {
+    std::mt19937 rng(5);
+    std::normal_distribution<float> dist(0.0f, 0.1f);
+    Linear fc(32 * 5 * 5, 625);
+    std::vector<float> w(800 * 625), b(625);
+    for (auto& x : w) x = dist(rng);
+    for (auto& x : b) x = dist(rng);
+    fc.load_weights(w, b);
+    Tensor fc_in({1, 800});
+    for (auto& x : fc_in.data) x = dist(rng);
+
+    const SimdKernels* saved = &simd_kernels();
+    for (const SimdKernels* k : simd_available()) {
+        simd_set_kernels(k);
+        volatile float sink = 0.0f;
+
+        const int fc_reps = 2000;
+        auto t0 = bench_clock::now();
+        for (int r = 0; r < fc_reps; ++r) sink = fc.forward(fc_in)[0];
+        std::cout << "[simd] " << k->name << " move_fc: " << seconds_since(t0) / fc_reps * 1e6 << " us";
+
+        if (net) {
+            for (int n : {1, 16}) {
+                Tensor x({n, ENCODED_PLANES, 5, 5});
+                for (auto& v : x.data) v = (rng() & 1) ? 1.0f : 0.0f;
+                int reps = std::max(4, 200 / n);
+                ContrastDualPolicyNet::Output out;
+                net->forward(x.data.data(), n, out);
+                t0 = bench_clock::now();
+                for (int r = 0; r < reps; ++r) {
+                    net->forward(x.data.data(), n, out);
+                    sink = out.value;
+                }
+                std::cout << ", forward N=" << n << ": " << seconds_since(t0) / reps * 1e3 << " ms";
+            }
+        }
+        std::cout << "  (checksum " << sink << ")" << std::endl;
+    }
+    simd_set_kernels(saved);
+}
+
+// Backbone convolution algorithms: multiplies per forward pass, 64->64 layer
+// time and, with a model, whole forward-pass time for each
+static void bench_winograd(ContrastDualPolicyNet* net) {
+    struct Algo { const char* name; ConvAlgo algo; };
+    const Algo algos[] = {
+        {"gemm      ", CONV_GEMM},
+        {"F(2x2,3x3)", CONV_WINOGRAD_2X2},
+        {"F(4x4,3x3)", CONV_WINOGRAD_4X4},
+    };
+    std::mt19937 rng(13);
+    std::normal_distribution<float> dist(0.0f, 0.1f);
+    Conv2d conv(64, 64, 3, 1, 1);
+    std::vector<float> w(64 * 64 * 9), b(64);
+    for (auto& x : w) x = dist(rng);
+    for (auto& x : b) x = dist(rng);
+    conv.load_weights(w, b);
+
+    ContrastDualPolicyNet shape_only; // Same layer shapes as the model, for counting
+    ConvAlgo saved = net ? net->backbone_algo : CONV_GEMM;
+    for (const Algo& a : algos) {
+        shape_only.set_backbone_algorithm(a.algo);
+        long long mults = 0;
+        for (Conv2d* c : shape_only.backbone_convs()) mults += c->multiplies(1, 5, 5);
+        std::cout << "[winograd] " << a.name << ": " << mults / 1e6 << " M backbone multiplies/position";
+
+        conv.set_algorithm(a.algo);
+        volatile float sink = 0.0f;
+        for (int n : {1, 16}) {
+            Tensor x({n, 64, 5, 5}), y({n, 64, 5, 5});
+            for (auto& v : x.data) v = dist(rng);
+            Arena arena(conv.workspace(n, 5, 5));
+            int reps = std::max(4, 2000 / n);
+            auto t0 = bench_clock::now();
+            for (int r = 0; r < reps; ++r) {
+                conv.forward_into(x.data.data(), n, 5, 5, y.data.data(), arena);
+                sink = y[0];
+            }
+            std::cout << ", 64->64 N=" << n << ": " << seconds_since(t0) / reps * 1e6 << " us";
+        }
+
+        if (net) {
+            net->set_backbone_algorithm(a.algo);
+            Tensor x({1, ENCODED_PLANES, 5, 5});
+            for (auto& v : x.data) v = (rng() & 1) ? 1.0f : 0.0f;
+            const int reps = 200;
+            ContrastDualPolicyNet::Output out;
+            net->forward(x.data.data(), 1, out);
+            auto t0 = bench_clock::now();
+            for (int r = 0; r < reps; ++r) {
+                net->forward(x.data.data(), 1, out);
+                sink = out.value;
+            }
+            std::cout << ", forward: " << seconds_since(t0) / reps * 1e3 << " ms";
+        }
+        std::cout << "  (checksum " << sink << ")" << std::endl;
+    }
+    if (net) net->set_backbone_algorithm(saved);
+}
+
+// Forward time per architecture, on the compiled fast path and the generic
+// one: the shipped network, its half and double width variants (which have
+// fast paths) and a width without one. Random weights, so no model is needed.
+static void bench_arch() {
+    std::mt19937 rng(19);
+    std::normal_distribution<float> dist(0.0f, 0.05f);
+    std::vector<ModelArch> archs(4);
+    archs[1].filters = 32;
+    archs[2].filters = 128;
+    archs[3].filters = 48;
+    for (const ModelArch& arch : archs) {
+        ContrastDualPolicyNet net(arch);
+        for (const auto& l : net.named_layers()) {
+            std::vector<float> w(Parameter::count(l.conv ? l.conv->weight_shape() : l.fc->weight_shape()));
+            std::vector<float> b(l.conv ? l.conv->out_channels : l.fc->out_features);
+            for (auto& v : w) v = dist(rng);
+            for (auto& v : b) v = dist(rng);
+            if (l.conv) l.conv->load_weights(w, b);
+            else l.fc->load_weights(w, b);
+        }
+        std::cout << "[arch] " << arch.filters << " filters x " << arch.res_blocks << " blocks";
+        for (int n : {1, 8}) {
+            Tensor x({n, ENCODED_PLANES, 5, 5});
+            for (auto& v : x.data) v = (rng() & 1) ? 1.0f : 0.0f;
+            ContrastDualPolicyNet::Output out;
+            int reps = std::max(10, 200 / n);
+            // Interleaved rounds, best of each: timings on a shared machine are noisy
+            double best[2] = {1e9, 1e9};
+            for (int round = 0; round < 5; ++round) {
+                for (int fast = net.has_fast_path() ? 1 : 0; fast >= 0; --fast) {
+                    net.use_fast_path = fast;
+                    net.forward(x.data.data(), n, out);
+                    auto t0 = bench_clock::now();
+                    for (int r = 0; r < reps; ++r) net.forward(x.data.data(), n, out);
+                    best[fast] = std::min(best[fast], seconds_since(t0) / reps * 1e3);
+                }
+            }
+            std::cout << ", N=" << n << ": generic " << best[0] << " ms";
+            if (net.has_fast_path()) std::cout << ", fast " << best[1] << " ms (x" << best[0] / best[1] << ")";
+        }
+        std::cout << std::endl;
+    }
+}
+
+// Best time per call of `fixed` and `generic` over interleaved rounds, in us
+template <class Fixed, class Generic>
+static void time_pair(const char* label, int reps, Fixed fixed, Generic generic) {
+    double best[2] = {1e9, 1e9};
+    for (int round = 0; round < 5; ++round) {
+        for (int f = 1; f >= 0; --f) {
+            f ? fixed() : generic();
+            auto t0 = bench_clock::now();
+            for (int r = 0; r < reps; ++r) f ? fixed() : generic();
+            best[f] = std::min(best[f], seconds_since(t0) / reps * 1e6);
+        }
+    }
+    std::cout << "[geometry] " << label << ": generic " << best[0] << " us, 5x5 " << best[1] << " us (x"
+              << best[0] / best[1] << ")" << std::endl;
+}
+
+// Kernels specialized for the 5x5 board against their generic versions:
+// encoding, the lowering steps of each convolution path and whole layers
+static void bench_geometry() {
+    std::mt19937 rng(21);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+    volatile float sink = 0.0f;
+
+    std::vector<ContrastGame> games = sample_positions(256, 5);
+    std::vector<float> planes(ENCODED_STATE_SIZE);
+    time_pair("encode_state x256", 200,
+              [&] { for (auto& g : games) g.encode_state_into(planes.data()); sink = planes[0]; },
+              [&] { for (auto& g : games) g.encode_state_reference_into(planes.data()); sink = planes[0]; });
+
+    for (int n : {1, 8}) {
+        std::string suffix = " N=" + std::to_string(n);
+        Tensor x({n, 66, 5, 5});
+        for (auto& v : x.data) v = dist(rng);
+        std::vector<float> cols((size_t)66 * 9 * n * 25);
+        time_pair(("im2col 66ch 3x3" + suffix).c_str(), 2000 / n,
+                  [&] { im2col_same<3, 5, 5>(x.data.data(), n, 66, cols.data()); sink = cols[0]; },
+                  [&] { im2col(x.data.data(), n, 66, 5, 5, 3, 1, 1, 5, 5, cols.data()); sink = cols[0]; });
+
+        std::vector<int16_t> nhwc((size_t)n * 49 * 64), rows((size_t)n * 25 * quant_stride(64 * 9));
+        time_pair(("int8 lowering 64ch 3x3" + suffix).c_str(), 2000 / n,
+                  [&] {
+                      quantize_nhwc_padded<64, 5, 5>(x.data.data(), n, 64, 5, 5, 1, 0.01f, nhwc.data());
+                      im2row_nhwc_same<3, 5, 5, 64>(nhwc.data(), n, 64, rows.data(), quant_stride(64 * 9));
+                  },
+                  [&] {
+                      quantize_nhwc_padded(x.data.data(), n, 64, 5, 5, 1, 0.01f, nhwc.data());
+                      im2row_nhwc(nhwc.data(), n, 64, 7, 7, 3, 1, 5, 5, rows.data(), quant_stride(64 * 9));
+                  });
+
+        for (ConvAlgo algo : {CONV_WINOGRAD_2X2, CONV_WINOGRAD_4X4, CONV_GEMM}) {
+            Conv2d conv(64, 64, 3, 1, 1);
+            std::vector<float> w(64 * 64 * 9), b(64);
+            for (auto& v : w) v = dist(rng) - 0.5f;
+            conv.load_weights(w, b);
+            conv.set_algorithm(algo);
+            Tensor y({n, 64, 5, 5});
+            Arena arena(conv.workspace(n, 5, 5));
+            const char* name = algo == CONV_GEMM ? "gemm" : algo == CONV_WINOGRAD_2X2 ? "F(2x2)" : "F(4x4)";
+            time_pair((std::string("conv 64->64 ") + name + suffix).c_str(), 1000 / n,
+                      [&] { conv.forward_into<64, 64, 5, 5>(x.data.data(), n, 5, 5, y.data.data(), arena, true); },
+                      [&] { conv.forward_into<64, 64>(x.data.data(), n, 5, 5, y.data.data(), arena, true); });
+        }
+    }
+}
+
+// Positions from the first `moves` moves of random games, where both
+// players still hold tiles and the action lists are longest
+static std::vector<ContrastGame> sample_openings(int count, int moves, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::vector<ContrastGame> out;
+    while ((int)out.size() < count) {
+        ContrastGame game;
+        for (int m = 0; m < moves && !game.game_over && (int)out.size() < count; ++m) {
+            out.push_back(game.copy());
+            auto actions = game.get_all_legal_actions();
+            game.step(actions[rng() % actions.size()]);
+        }
+    }
+    return out;
+}
+
+// The non-network part of a node expansion next to the forward pass it
+// follows: move generation, priors from the network's logits (decode, flip,
+// softmax, sort), and make/unmake of every child as advance() and
+// principal_variation() do. The logits are real network outputs, computed
+// once up front.
+static void bench_expand(ContrastDualPolicyNet& net) {
+    const int positions = 400, rounds = 20;
+    MCTS mcts(&net);
+    ContrastDualPolicyNet::Output out;
+    Arena arena;
+    std::vector<float> planes(ENCODED_STATE_SIZE);
+    volatile float sink = 0.0f;
+
+    for (int set = 0; set < 2; ++set) {
+        auto games = set == 0 ? sample_positions(positions, 24) : sample_openings(positions, 8, 24);
+        const char* name = set == 0 ? "playouts" : "openings";
+        std::vector<float> move_logits((size_t)positions * 625), tile_logits((size_t)positions * NUM_TILES);
+        std::vector<ActionList> legal(positions);
+        auto t0 = bench_clock::now();
+        for (int i = 0; i < positions; ++i) {
+            games[i].encode_state_into(planes.data());
+            net.forward(planes.data(), 1, out, arena);
+            std::copy(out.move_logits.data.begin(), out.move_logits.data.end(), &move_logits[(size_t)i * 625]);
+            std::copy(out.tile_logits.data.begin(), out.tile_logits.data.end(), &tile_logits[(size_t)i * NUM_TILES]);
+            games[i].generate_legal_actions(legal[i]);
+        }
+        double t_net = seconds_since(t0) / positions;
+
+        long long actions = 0;
+        for (auto& l : legal) actions += l.size();
+        ActionList scratch;
+        t0 = bench_clock::now();
+        for (int r = 0; r < rounds; ++r)
+            for (auto& g : games) {
+                g.generate_legal_actions(scratch);
+                sink = scratch.size();
+            }
+        double t_gen = seconds_since(t0) / (positions * rounds);
+
+        // Priors under each softmax kernel, the active (best) one last
+        std::vector<Edge> edges(MAX_ACTIONS);
+        const SimdKernels* active = simd_active();
+        std::string variants;
+        double t_priors = 0.0;
+        auto kernels = simd_available();
+        std::reverse(kernels.begin(), kernels.end());
+        for (const SimdKernels* k : kernels) {
+            simd_set_kernels(k);
+            t0 = bench_clock::now();
+            for (int r = 0; r < rounds; ++r)
+                for (int i = 0; i < positions; ++i) {
+                    mcts.fill_edges(games[i], legal[i], &move_logits[(size_t)i * 625],
+                                    &tile_logits[(size_t)i * NUM_TILES], edges.data());
+                    sink = edges[0].prior;
+                }
+            t_priors = seconds_since(t0) / (positions * rounds);
+            variants += std::string(variants.empty() ? "" : ", ") + k->name + " " +
+                        std::to_string(t_priors * 1e6).substr(0, 5) + " us";
+        }
+        simd_set_kernels(active);
+
+        t0 = bench_clock::now();
+        for (int r = 0; r < rounds; ++r)
+            for (int i = 0; i < positions; ++i)
+                for (int a : legal[i]) {
+                    UndoRecord undo = games[i].make(a);
+                    games[i].unmake(undo);
+                }
+        double t_children = seconds_since(t0) / (positions * rounds);
+
+        double per_action = 1e9 / ((double)actions / positions);
+        std::cout << "[expand] " << name << ": " << (double)actions / positions << " actions, forward "
+                  << t_net * 1e6 << " us, movegen " << t_gen * 1e6 << " us, priors " << variants << " ("
+                  << t_priors * per_action << " ns/action), make/unmake " << t_children * per_action
+                  << " ns/action; non-network share " << 100.0 * (t_gen + t_priors) / (t_net + t_gen + t_priors)
+                  << "%  (checksum " << sink << ")" << std::endl;
+    }
+}
+
+// Time-budgeted search over the first moves of a game: simulations run per
+// budget and how many searches early stopping cut short
+static void bench_timed(ContrastDualPolicyNet& net) {
+    for (double budget : {50.0, 200.0, 1000.0}) {
+        MCTS mcts(&net);
+        mcts.rng.seed(11);
+        ContrastGame game;
+        int searches = 0, early = 0;
+        long long sims = 0;
+        double elapsed = 0.0;
+        for (int m = 0; m < 10 && !game.game_over; ++m) {
+            sims += mcts.search(game, SearchLimits::timed(budget));
+            elapsed += mcts.last_search.elapsed_ms;
+            early += mcts.last_search.stopped_early;
+            searches++;
+            game.step(mcts.get_best_action(game));
+            mcts.advance(game);
+        }
+        std::cout << "[timed] budget " << budget << " ms: " << (double)sims / searches << " simulations and "
+                  << elapsed / searches << " ms per move, " << early << "/" << searches << " stopped early"
+                  << std::endl;
+    }
+}
+
+// Short games from the opening, each on a fresh tree as separate analysis
+// runs would be, with and without the evaluation cache shared between them.
+// With root noise the games drift apart (self-play); without it they
+// replay the same line (re-analysis).
+static void bench_eval_cache(ContrastDualPolicyNet& net) {
+    const int games = 8, moves = 12, sims = 64;
+    EvalCache cache(8);
+    for (int variant = 0; variant < 4; ++variant) {
+        bool cached = variant & 1, noise = variant < 2;
+        MCTS mcts(&net);
+        mcts.rng.seed(3);
+        mcts.dirichlet_epsilon = noise ? 0.25f : 0.0f;
+        mcts.eval_cache = cached ? &cache : nullptr;
+        cache.clear();
+        auto t0 = bench_clock::now();
+        for (int g = 0; g < games; ++g) {
+            ContrastGame game;
+            mcts.clear();
+            for (int m = 0; m < moves && !game.game_over; ++m) {
+                mcts.search(game, sims);
+                game.step(mcts.get_best_action(game));
+                mcts.advance(game);
+            }
+        }
+        std::cout << "[cache] " << (noise ? "root noise" : "no noise  ") << (cached ? ", cached  " : ", uncached") << ": " << seconds_since(t0) / games * 1e3
+                  << " ms/game";
+        if (cached)
+            std::cout << ", " << cache.stats.hits << " hits of " << cache.stats.lookups << " lookups (hit rate "
+                      << cache.stats.hit_rate() << ")";
+        std::cout << std::endl;
+    }
+}
+
+// Nodes per second of the batched search at several batch sizes
+// AI moves of 200 visits against an opponent who thinks for a second, with
+// and without pondering meanwhile. Visits already at the root count towards
+// the 200, as in ai_think. The opponent plays either the reply the engine
+// expects (its most visited one) or a random legal move.
+static void bench_ponder(ContrastDualPolicyNet& net) {
+    const int visits = 200, moves = 8;
+    for (int variant = 0; variant < 4; ++variant) {
+        bool ponder = variant & 1, predictable = variant < 2;
+        MCTS mcts(&net);
+        mcts.rng.seed(5);
+        std::mt19937 rng(5);
+        ContrastGame game;
+        double think_ms = 0.0;
+        long long kept = 0;
+        int searches = 0;
+        for (int m = 0; m < moves && !game.game_over; ++m) {
+            auto t0 = bench_clock::now();
+            mcts.search(game, std::max(visits - mcts.get_root_visits(game), 0));
+            think_ms += seconds_since(t0) * 1000.0;
+            searches++;
+            game.step(mcts.get_best_action(game));
+            mcts.advance(game);
+            if (game.game_over)
+                break;
+
+            if (ponder)
+                mcts.start_pondering(game);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+            mcts.stop_pondering();
+            int reply = mcts.get_best_action(game);
+            if (!predictable || reply < 0) {
+                auto actions = game.get_all_legal_actions();
+                reply = actions[rng() % actions.size()];
+            }
+            game.step(reply);
+            mcts.advance(game);
+            kept += mcts.get_root_visits(game);
+        }
+        std::cout << "[ponder] " << (predictable ? "expected" : "random") << " replies, "
+                  << (ponder ? "pondering" : "idle     ") << ": " << think_ms / searches << " ms per AI move, "
+                  << (double)kept / searches << " visits kept" << std::endl;
+    }
+}
+
+static void bench_batch(ContrastDualPolicyNet& net) {
+    const int sims = 128;
+    for (int k : {1, 8, 16, 32}) {
+        MCTS mcts(&net);
+        mcts.batch_size = k;
+        ContrastGame game;
+        mcts.search(game, 1); // Root expansion outside the timing
+
+        auto t0 = bench_clock::now();
+        mcts.search(game, sims);
+        double t = seconds_since(t0);
+        std::cout << "[batch] K=" << k << ": " << sims / t << " sims/s  ("
+                  << mcts.tree.size() << " nodes)" << std::endl;
+    }
+}
+
+// Tree-parallel scaling: simulations per second for 1..32 search threads
+static void bench_threads(ContrastDualPolicyNet& net) {
+    const int sims = 256;
+    double base = 0.0;
+    for (int threads : {1, 2, 4, 8, 16, 32}) {
+        MCTS mcts(&net);
+        mcts.num_threads = threads;
+        ContrastGame game;
+        mcts.search(game, 1); // Root expansion outside the timing
+
+        auto t0 = bench_clock::now();
+        mcts.search(game, sims);
+        double rate = sims / seconds_since(t0);
+        if (threads == 1) base = rate;
+        std::cout << "[threads] " << threads << ": " << rate << " sims/s  (x" << rate / base << ", "
+                  << mcts.tree.size() << " nodes)" << std::endl;
+    }
+    std::cout << "[threads] hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+}
+
+int main(int argc, char** argv) {
+    std::string section = (argc > 1) ? argv[1] : "all";
+    std::string model_path = (argc > 2) ? argv[2] : "wasm/model.bin";
+    bool all = (section == "all");
+
+    ContrastDualPolicyNet net;
+    bool has_model = std::ifstream(model_path).good() && net.load_from_file(model_path);
+    if (!has_model) std::cout << "Model " << model_path << " not found, skipping model benchmarks" << std::endl;
+
+    if (all || section == "movegen") bench_movegen();
+    if (all || section == "copy") bench_copy_step();
+    if (all || section == "conv") bench_conv();
+    if (all || section == "simd") bench_simd(has_model ? &net : nullptr);
+    if (all || section == "winograd") bench_winograd(has_model ? &net : nullptr);
+    if (all || section == "arch") bench_arch();
+    if (all || section == "geometry") bench_geometry();
+    if (has_model && (all || section == "batch")) bench_batch(net);
+    if (has_model && (all || section == "threads")) bench_threads(net);
+    if (has_model && (all || section == "timed")) bench_timed(net);
+    if (has_model && (all || section == "cache")) bench_eval_cache(net);
+    if (has_model && (all || section == "ponder")) bench_ponder(net);
+    if (has_model && (all || section == "expand")) bench_expand(net);
+
+    return 0;
+}
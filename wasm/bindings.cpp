@@ -3,6 +3,7 @@
 #include "game.h"
 #include "mcts.h"
 #include "model.h"
+#include <cstddef>
 
 using namespace emscripten;
 
@@ -11,29 +12,130 @@ using namespace emscripten;
 ContrastDualPolicyNet* global_net = nullptr;
 ContrastGame* global_game = nullptr;
 MCTS* global_mcts = nullptr;
+EvalCache* global_eval_cache = nullptr; // Network evaluations kept across searches and games
 std::vector<ContrastGame> game_history; // For Undo
 
-// Init function
-void init_game(std::string model_path) {
+// Pondering: search the position while the human thinks about it. Builds
+// with threads run it on a background thread; the single-threaded wasm
+// build has the worker drive it in chunks through ponder(n).
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+const bool PONDER_THREAD = false;
+#else
+const bool PONDER_THREAD = true;
+#endif
+bool ponder_enabled = false;
+bool ponder_session = false; // The chunked session in progress is a ponder, not an AI move
+
+// Called first by everything below that touches the tree or the game
+void stop_ponder() {
+    if (!global_mcts) return;
+    global_mcts->stop_pondering();
+    if (ponder_session) global_mcts->end_search();
+    ponder_session = false;
+}
+
+// --- Packed state ---
+// The position as one fixed-layout block of wasm memory, rewritten after
+// every change to the game. JS reads it through a Uint8Array view from
+// get_state_view() (offsets from get_state_layout()) instead of an embind
+// call per field, and `version` tells it whether anything has changed since
+// its last read. It also lists every legal action, so the UI needs no
+// per-square queries. Little-endian, as wasm is.
+struct PackedState {
+    uint32_t version;     // Bumped by every publish_state()
+    uint16_t move_count;
+    uint16_t num_actions; // Entries of `actions` in use
+    int8_t pieces[25];    // Row-major, 0=Empty, 1=P1, 2=P2
+    int8_t tiles[25];     // 0=White, 1=Black, 2=Gray
+    int8_t tile_counts[4]; // P1_B, P1_G, P2_B, P2_G
+    int8_t current_player;
+    int8_t game_over;
+    int8_t winner;
+    int8_t reserved;
+    uint16_t actions[MAX_ACTIONS]; // Legal action hashes, in generation order
+};
+static_assert(NUM_MOVES * NUM_TILES <= 65536, "Action hashes must fit the uint16 list");
+static_assert(offsetof(PackedState, actions) % alignof(uint16_t) == 0, "JS reads the actions as a Uint16Array");
+
+PackedState packed_state = {};
+
+void publish_state() {
+    if (!global_game) return;
+    const ContrastGame& g = *global_game;
+    PackedState& s = packed_state;
+    s.version++;
+    s.move_count = g.move_count;
+    std::memcpy(s.pieces, g.pieces, sizeof(s.pieces));
+    std::memcpy(s.tiles, g.tiles, sizeof(s.tiles));
+    std::memcpy(s.tile_counts, g.tile_counts, sizeof(s.tile_counts));
+    s.current_player = g.current_player;
+    s.game_over = g.game_over;
+    s.winner = g.winner;
+
+    ActionList legal;
+    g.generate_legal_actions(legal);
+    s.num_actions = legal.size();
+    for (int i = 0; i < legal.size(); ++i) s.actions[i] = legal[i];
+}
+
+// A view of packed_state. It is detached (byteLength 0) once wasm memory
+// grows, after which JS fetches a new one.
+val get_state_view() {
+    return val(typed_memory_view(sizeof(PackedState), reinterpret_cast<const uint8_t*>(&packed_state)));
+}
+
+val get_state_layout() {
+    val res = val::object();
+    res.set("size", (int)sizeof(PackedState));
+    res.set("version", (int)offsetof(PackedState, version));
+    res.set("move_count", (int)offsetof(PackedState, move_count));
+    res.set("num_actions", (int)offsetof(PackedState, num_actions));
+    res.set("pieces", (int)offsetof(PackedState, pieces));
+    res.set("tiles", (int)offsetof(PackedState, tiles));
+    res.set("tile_counts", (int)offsetof(PackedState, tile_counts));
+    res.set("current_player", (int)offsetof(PackedState, current_player));
+    res.set("game_over", (int)offsetof(PackedState, game_over));
+    res.set("winner", (int)offsetof(PackedState, winner));
+    res.set("actions", (int)offsetof(PackedState, actions));
+    return res;
+}
+
+// Init function. Returns false if the model file is invalid or does not
+// match the network (the reason is printed to the console).
+bool init_game(std::string model_path) {
+    stop_ponder();
     if (global_net) delete global_net;
     if (global_game) delete global_game;
     if (global_mcts) delete global_mcts;
+    if (global_eval_cache) delete global_eval_cache;
     
     global_net = new ContrastDualPolicyNet();
-    global_net->load_from_file(model_path);
+    bool loaded = global_net->load_from_file(model_path);
+    if (loaded && !network_fits_game(global_net->arch())) {
+        std::cerr << "Model " << model_path << " (" << global_net->arch().describe()
+                  << ") does not fit this game's encoding" << std::endl;
+        loaded = false;
+    }
     
     global_game = new ContrastGame();
     global_mcts = new MCTS(global_net);
+    global_eval_cache = new EvalCache(8);
+    global_mcts->eval_cache = global_eval_cache;
     game_history.clear();
+    publish_state();
+    return loaded;
 }
 
 void reset_game(int human_player_id) {
+    stop_ponder();
     if (global_game) global_game->reset();
     game_history.clear();
+    if (global_game && global_mcts) global_mcts->advance(*global_game); // Also cancels a chunked search
+    publish_state();
 }
 
-// ... (get_state same as before) ...
-
+// The same fields as packed_state as a JS object, built field by field
+// (kept for the console and older callers; the worker reads the view)
 val get_state() {
     if (!global_game) return val::null();
     
@@ -76,12 +178,12 @@ val get_valid_moves(int x, int y) {
 // Step function wrapped
 val step(int action_hash) {
     if (!global_game) return val::object();
+    stop_ponder();
     
-    auto legal = global_game->get_all_legal_actions();
-    bool is_legal = false;
-    for(int a : legal) if(a == action_hash) is_legal = true;
+    ActionList legal;
+    global_game->generate_legal_actions(legal);
     
-    if(!is_legal) {
+    if(!legal.contains(action_hash)) {
         val res = val::object();
         res.set("success", false);
         res.set("error", "Illegal move");
@@ -92,6 +194,11 @@ val step(int action_hash) {
     game_history.push_back(global_game->copy());
     
     global_game->step(action_hash);
+    publish_state();
+    
+    // Reuse the played subtree for the next search (with what pondering
+    // found if this was the move it expected), free the rest
+    if (global_mcts) global_mcts->advance(*global_game);
     
     val res = val::object();
     res.set("success", true);
@@ -103,50 +210,233 @@ val step(int action_hash) {
 // Undo function
 bool undo() {
     if (!global_game || game_history.empty()) return false;
+    stop_ponder();
     
     *global_game = game_history.back();
     game_history.pop_back();
+    if (global_mcts) global_mcts->end_search(); // Its root is no longer the position
+    publish_state();
     
     // Also likely want to clear future history or relevant MCTS nodes?
     // MCTS nodes are hashed by state, so they are valid valid.
     return true;
 }
 
+// Best move and root value after the search just run, with what it did
+val search_result() {
+    const SearchReport& report = global_mcts->last_search;
+    val res = val::object();
+    res.set("action", global_mcts->get_best_action(*global_game));
+    res.set("value", global_mcts->get_root_value(*global_game));
+    res.set("simulations", report.simulations);
+    res.set("elapsed_ms", report.elapsed_ms);
+    res.set("stopped_early", report.stopped_early);
+    return res;
+}
+
+// --- Chunked search ---
+// begin_search() starts a search from the current position; every
+// continue_search(n) runs n more simulations on the same tree and reports
+// the best move so far, so the worker can stream progress between chunks and
+// drop a search that is no longer wanted. The search's limits are given to
+// begin_search(), and the progress says (`done`) when they are reached or
+// the best move is decided, as ai_think()/ai_think_time() would stop. step(), undo() and reset_game()
+// cancel the search in progress, and begin_search() stops pondering.
+
+const int PV_LENGTH = 8;
+
+// Best move, root value and principal variation of the search in progress
+val search_progress() {
+    const MCTS::SearchSession& session = global_mcts->session;
+    val res = search_result();
+    res.set("action", global_mcts->get_best_action(session.root));
+    res.set("value", global_mcts->get_root_value(session.root));
+    val pv = val::array();
+    for (int a : global_mcts->principal_variation(session.root, PV_LENGTH)) pv.call<void>("push", a);
+    res.set("pv", pv);
+    res.set("total_simulations", session.simulations);
+    res.set("total_elapsed_ms", session.elapsed_ms);
+    res.set("root_visits", global_mcts->get_root_visits(session.root));
+    res.set("done", global_mcts->session_done());
+    res.set("stopped_early", session.stopped_early);
+    return res;
+}
+
+// Searches for `simulations`, or for `time_ms` with early stopping when it
+// is positive. Returns false if there is nothing to search (no model, or no
+// legal move)
+bool begin_search(int simulations, double time_ms) {
+    if (!global_game || !global_mcts) return false;
+    stop_ponder();
+    if (ponder_enabled) simulations = std::max(simulations - global_mcts->get_root_visits(*global_game), 0);
+    SearchLimits limits = (time_ms > 0.0) ? SearchLimits::timed(time_ms) : SearchLimits::count(simulations);
+    return global_mcts->begin_search(*global_game, true, limits);
+}
+
+// Null if no search is in progress
+val continue_search(int simulations) {
+    if (!global_mcts || !global_mcts->session.active || ponder_session || global_mcts->is_pondering()) return val::null();
+
+    global_mcts->continue_search(simulations);
+    return search_progress();
+}
+
+// Ends the search and returns its result; the caller plays the move
+val finish_search() {
+    if (!global_mcts || !global_mcts->session.active || ponder_session || global_mcts->is_pondering()) return val::null();
+
+    val res = search_progress();
+    global_mcts->end_search();
+    return res;
+}
+
+// Also stops pondering
+void cancel_search() {
+    stop_ponder();
+    if (global_mcts) global_mcts->end_search();
+}
+
+// With pondering on, simulations already spent on the position count
+// towards `simulations`, so a well-pondered move comes back at once
 val ai_think(int simulations) {
     if (!global_game || !global_mcts) return val::null();
+    stop_ponder();
+    if (ponder_enabled) simulations = std::max(simulations - global_mcts->get_root_visits(*global_game), 0);
     
     global_mcts->search(*global_game, simulations);
-    int action = global_mcts->get_best_action(*global_game);
-    float value = global_mcts->get_root_value(*global_game);
+    return search_result();
+}
+
+// Searches for about `time_ms` milliseconds of wall-clock time, whatever the
+// device's speed, stopping sooner once the best move cannot change
+val ai_think_time(double time_ms) {
+    if (!global_game || !global_mcts) return val::null();
+    stop_ponder();
+
+    global_mcts->search(*global_game, SearchLimits::timed(time_ms));
+    return search_result();
+}
+
+// --- Pondering ---
+
+void set_ponder(bool on) {
+    ponder_enabled = on;
+    if (!on) stop_ponder();
+}
+
+// Starts pondering the current position, whoever is to move. Returns true if
+// the caller has to drive it with ponder(n) (no threads in this build).
+bool start_ponder() {
+    if (!ponder_enabled || !global_game || !global_mcts || global_game->game_over) return false;
+    stop_ponder();
+    if (PONDER_THREAD) {
+        global_mcts->start_pondering(*global_game);
+        return false;
+    }
+    ponder_session = global_mcts->begin_search(*global_game, false);
+    if (!ponder_session) global_mcts->end_search();
+    return ponder_session;
+}
+
+// Runs `simulations` more ponder simulations; false once there is nothing
+// left to ponder (stopped, limit reached, or a threaded build)
+bool ponder(int simulations) {
+    if (!ponder_session || !global_mcts->session.active) return false;
+    global_mcts->continue_search(std::min(simulations, global_mcts->ponder_limit - global_mcts->session.simulations));
+    return global_mcts->session.simulations < global_mcts->ponder_limit;
+}
+
+// Resize (and clear) the MCTS transposition table
+void set_tt_size(int megabytes) {
+    stop_ponder();
+    if (global_mcts) global_mcts->tree.resize(megabytes);
+}
+
+// Leaves evaluated per network call during search (1 = sequential)
+void set_batch_size(int batch_size) {
+    stop_ponder();
+    if (global_mcts) global_mcts->batch_size = std::max(1, batch_size);
+}
+
+// Switch the network to int8 inference (false: back to fp32). Unless the
+// model file carried activation scales (quant_main --save), the first call
+// calibrates them on positions from random playouts.
+bool set_int8(bool on) {
+    if (!global_net) return false;
+    stop_ponder();
+    if (on && !global_net->int8_calibrated()) {
+        const int positions = 256;
+        std::mt19937 rng(1);
+        std::vector<float> planes((size_t)positions * ENCODED_STATE_SIZE);
+        ContrastGame game;
+        for (int i = 0; i < positions; ++i) {
+            if (game.game_over || game.move_count >= MAX_STEPS) game.reset();
+            game.encode_state_into(&planes[(size_t)i * ENCODED_STATE_SIZE]);
+            auto actions = game.get_all_legal_actions();
+            game.step(actions[rng() % actions.size()]);
+        }
+        global_net->calibrate(planes.data(), positions);
+    }
+    bool ok = global_net->set_int8(on);
+    if (ok && global_eval_cache) global_eval_cache->clear(); // Cached outputs came from the other weights
+    return ok;
+}
+
+// Resize (and clear) the evaluation cache; 0 turns it off
+void set_eval_cache_size(int megabytes) {
+    if (!global_mcts) return;
+    stop_ponder();
+    if (global_eval_cache) delete global_eval_cache;
+    global_eval_cache = megabytes > 0 ? new EvalCache(megabytes) : nullptr;
+    global_mcts->eval_cache = global_eval_cache;
+}
+
+val get_eval_cache_stats() {
+    if (!global_eval_cache) return val::null();
+    const EvalCache& cache = *global_eval_cache;
+
+    val res = val::object();
+    res.set("capacity", (double)cache.capacity());
+    res.set("memory_bytes", (double)cache.memory_bytes());
+    res.set("lookups", (double)cache.stats.lookups);
+    res.set("hits", (double)cache.stats.hits);
+    res.set("misses", (double)cache.stats.misses());
+    res.set("hit_rate", cache.stats.hit_rate());
+    res.set("stores", (double)cache.stats.stores);
+    return res;
+}
+
+val get_tt_stats() {
+    if (!global_mcts) return val::null();
+    const TranspositionTable& tt = global_mcts->tree;
     
     val res = val::object();
-    res.set("action", action);
-    res.set("value", value);
+    res.set("nodes", (double)tt.size());
+    res.set("capacity", (double)tt.capacity());
+    res.set("occupancy", tt.occupancy());
+    res.set("memory_bytes", (double)tt.memory_bytes());
+    res.set("lookups", (double)tt.stats.lookups);
+    res.set("hits", (double)tt.stats.hits);
+    res.set("hit_rate", tt.stats.hit_rate());
+    res.set("evictions", (double)tt.stats.evictions);
+    res.set("collections", (double)tt.stats.collections);
     return res;
 }
 
 // Helper to decode action hash for JS
 val decode_action_js(int action_hash) {
     val res = val::object();
-    int move_idx = action_hash / 51;
-    int tile_idx = action_hash % 51;
-    
-    int from_idx = move_idx / 25;
-    int to_idx = move_idx % 25;
-    
-    res.set("from_x", from_idx % 5);
-    res.set("from_y", from_idx / 5);
-    res.set("to_x", to_idx % 5);
-    res.set("to_y", to_idx / 5);
-    
-    if (tile_idx > 0) {
-        int t_color = (tile_idx <= 25) ? 1 : 2; // Black=1, Gray=2
-        int t_loc = (tile_idx <= 25) ? (tile_idx-1) : (tile_idx-26);
-        res.set("tile_type", t_color);
-        res.set("tile_x", t_loc % 5);
-        res.set("tile_y", t_loc / 5);
-    } else {
-        res.set("tile_type", 0);
+    DecodedAction d = decode_action(action_hash);
+    
+    res.set("from_x", d.from % 5);
+    res.set("from_y", d.from / 5);
+    res.set("to_x", d.to % 5);
+    res.set("to_y", d.to / 5);
+    
+    res.set("tile_type", d.tile_color); // Black=1, Gray=2, none=0
+    if (d.tile_color != TILE_WHITE) {
+        res.set("tile_x", d.tile_square % 5);
+        res.set("tile_y", d.tile_square / 5);
     }
     
     return res;
@@ -156,9 +446,25 @@ EMSCRIPTEN_BINDINGS(contrast_module) {
     function("init_game", &init_game);
     function("reset_game", &reset_game);
     function("get_state", &get_state);
+    function("get_state_view", &get_state_view);
+    function("get_state_layout", &get_state_layout);
     function("get_valid_moves", &get_valid_moves);
     function("step", &step);
     function("undo", &undo);
     function("ai_think", &ai_think);
+    function("ai_think_time", &ai_think_time);
+    function("begin_search", &begin_search);
+    function("continue_search", &continue_search);
+    function("finish_search", &finish_search);
+    function("cancel_search", &cancel_search);
+    function("set_ponder", &set_ponder);
+    function("start_ponder", &start_ponder);
+    function("ponder", &ponder);
     function("decode_action", &decode_action_js);
+    function("set_tt_size", &set_tt_size);
+    function("get_tt_stats", &get_tt_stats);
+    function("set_batch_size", &set_batch_size);
+    function("set_int8", &set_int8);
+    function("set_eval_cache_size", &set_eval_cache_size);
+    function("get_eval_cache_stats", &get_eval_cache_stats);
 }
@@ -0,0 +1,196 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <cstdint>
+
+// Bitboard representation of the 5x5 board.
+// Bit i of every mask is square i = y * 5 + x, so iterating set bits from low
+// to high visits squares in the same row-major order as the array scans.
+
+constexpr uint32_t BB_BOARD = (1u << 25) - 1;
+constexpr uint32_t BB_ROW_TOP = 0x1Fu;          // y = 0 (P1 goal)
+constexpr uint32_t BB_ROW_BOTTOM = 0x1Fu << 20; // y = 4 (P2 goal)
+
+// Direction order matches ContrastGame::get_valid_moves:
+// White tiles use dirs [0, 4), black tiles [4, 8), gray tiles [0, 8).
+constexpr int BB_NUM_DIRS = 8;
+constexpr int BB_DIR_DX[BB_NUM_DIRS] = {0, 0, -1, 1, -1, 1, -1, 1};
+constexpr int BB_DIR_DY[BB_NUM_DIRS] = {-1, 1, 0, 0, -1, -1, 1, 1};
+
+// Upper bound on legal actions: 5 pieces x 8 directions x (1 + 25 black + 25 gray)
+constexpr int MAX_ACTIONS = 5 * 8 * 51;
+
+// Fixed-capacity action buffer, meant to live on the caller's stack.
+// Storage is left uninitialised; only [0, size()) is valid.
+struct ActionList
+{
+    int count = 0;
+    int data[MAX_ACTIONS];
+
+    void clear() { count = 0; }
+    void push_back(int a) { data[count++] = a; }
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+    int operator[](int i) const { return data[i]; }
+    bool contains(int a) const
+    {
+        for (int i = 0; i < count; ++i)
+            if (data[i] == a)
+                return true;
+        return false;
+    }
+    const int *begin() const { return data; }
+    const int *end() const { return data + count; }
+};
+
+struct Bitboards
+{
+    uint32_t pieces[2]; // [PlayerIdx]
+    uint32_t black;     // Black tiles
+    uint32_t gray;      // Gray tiles
+
+    uint32_t occupied() const { return pieces[0] | pieces[1]; }
+    uint32_t white() const { return BB_BOARD & ~(black | gray); }
+};
+
+inline uint32_t bb_bit(int sq) { return 1u << sq; }
+inline int bb_lowest(uint32_t m) { return __builtin_ctz(m); }
+inline int bb_highest(uint32_t m) { return 31 - __builtin_clz(m); }
+inline int bb_count(uint32_t m) { return __builtin_popcount(m); }
+
+// The board rotated 180 degrees (sq -> 24 - sq): the 25 bits reversed
+inline uint32_t bb_rotate180(uint32_t m)
+{
+    m = ((m >> 1) & 0x55555555u) | ((m & 0x55555555u) << 1);
+    m = ((m >> 2) & 0x33333333u) | ((m & 0x33333333u) << 2);
+    m = ((m >> 4) & 0x0F0F0F0Fu) | ((m & 0x0F0F0F0Fu) << 4);
+    m = ((m >> 8) & 0x00FF00FFu) | ((m & 0x00FF00FFu) << 8);
+    m = (m >> 16) | (m << 16);
+    return m >> 7;
+}
+
+// Per-square rays: ray[sq][d] holds every square strictly beyond sq in
+// direction d. A ray walks towards higher indices iff forward[d] is set.
+struct RayTable
+{
+    uint32_t ray[25][BB_NUM_DIRS];
+    bool forward[BB_NUM_DIRS];
+
+    constexpr RayTable() : ray{}, forward{}
+    {
+        for (int d = 0; d < BB_NUM_DIRS; ++d)
+            forward[d] = BB_DIR_DY[d] * 5 + BB_DIR_DX[d] > 0;
+
+        for (int sq = 0; sq < 25; ++sq)
+        {
+            for (int d = 0; d < BB_NUM_DIRS; ++d)
+            {
+                uint32_t m = 0;
+                int x = sq % 5 + BB_DIR_DX[d];
+                int y = sq / 5 + BB_DIR_DY[d];
+                while (x >= 0 && x < 5 && y >= 0 && y < 5)
+                {
+                    m |= 1u << (y * 5 + x);
+                    x += BB_DIR_DX[d];
+                    y += BB_DIR_DY[d];
+                }
+                ray[sq][d] = m;
+            }
+        }
+    }
+};
+
+inline constexpr RayTable BB_RAYS{};
+
+// Destination of the slide from sq in direction d, or -1.
+// The piece jumps over friends and stops on the first non-friendly square,
+// which must be empty.
+inline int bb_slide(int sq, int d, uint32_t own, uint32_t enemy)
+{
+    uint32_t stop = BB_RAYS.ray[sq][d] & ~own;
+    if (!stop)
+        return -1;
+    int to = BB_RAYS.forward[d] ? bb_lowest(stop) : bb_highest(stop);
+    return (enemy & bb_bit(to)) ? -1 : to;
+}
+
+inline void bb_dir_range(const Bitboards &bb, int sq, int &d_begin, int &d_end)
+{
+    uint32_t b = bb_bit(sq);
+    if (bb.black & b)
+    {
+        d_begin = 4;
+        d_end = 8;
+    }
+    else
+    {
+        d_begin = 0;
+        d_end = (bb.gray & b) ? 8 : 4;
+    }
+}
+
+// Legal actions for player p_idx (0 or 1), in the same order as the array
+// scan in ContrastGame::scan_legal_actions.
+inline void bb_generate_actions(const Bitboards &bb, int p_idx, bool has_black, bool has_gray,
+                                ActionList &actions)
+{
+    constexpr int num_tiles = 51;
+    uint32_t own = bb.pieces[p_idx];
+    uint32_t enemy = bb.pieces[p_idx ^ 1];
+    uint32_t white = bb.white();
+    uint32_t empty_white = white & ~(own | enemy);
+    bool can_place = has_black || has_gray;
+
+    for (uint32_t rest = own; rest; rest &= rest - 1)
+    {
+        int from = bb_lowest(rest);
+        int d_begin, d_end;
+        bb_dir_range(bb, from, d_begin, d_end);
+
+        // Leaving `from` frees it for a tile if it is white
+        uint32_t spots_base = empty_white | (white & bb_bit(from));
+
+        for (int d = d_begin; d < d_end; ++d)
+        {
+            int to = bb_slide(from, d, own, enemy);
+            if (to < 0)
+                continue;
+
+            int base_hash = (from * 25 + to) * num_tiles;
+            actions.push_back(base_hash);
+
+            if (!can_place)
+                continue;
+
+            for (uint32_t spots = spots_base & ~bb_bit(to); spots; spots &= spots - 1)
+            {
+                int spot = bb_lowest(spots);
+                if (has_black)
+                    actions.push_back(base_hash + 1 + spot);
+                if (has_gray)
+                    actions.push_back(base_hash + 26 + spot);
+            }
+        }
+    }
+}
+
+// True as soon as one piece of p_idx can move. Tile placement never matters:
+// every move is also legal without placing a tile.
+inline bool bb_has_any_move(const Bitboards &bb, int p_idx)
+{
+    uint32_t own = bb.pieces[p_idx];
+    uint32_t enemy = bb.pieces[p_idx ^ 1];
+
+    for (uint32_t rest = own; rest; rest &= rest - 1)
+    {
+        int from = bb_lowest(rest);
+        int d_begin, d_end;
+        bb_dir_range(bb, from, d_begin, d_end);
+        for (int d = d_begin; d < d_end; ++d)
+            if (bb_slide(from, d, own, enemy) >= 0)
+                return true;
+    }
+    return false;
+}
+
+#endif // BITBOARD_H
@@ -0,0 +1,182 @@
+#ifndef EVALCACHE_H
+#define EVALCACHE_H
+
+#include "game.h"
+#include "ttable.h"
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <memory>
+#include <algorithm>
+#include <iterator>
+
+// Network evaluations cached by position, across searches and games.
+//
+// MCTS only keeps nodes of the current tree, so a position reached again
+// after its node was collected or re-rooted away, or in the next game from
+// the same opening, would need another forward pass. The cache keeps what
+// the search needs from that pass: the value and the logits the priors are
+// built from. Priors over a legal action set factor into a move logit and a
+// tile logit, and every legal move appears once with no tile, so an entry
+// holds one logit per legal move plus the NUM_TILES tile logits, stored as
+// 16-bit fixed point relative to their maximum (the softmax ignores the
+// shift); priors come back within 1% of the uncached ones.
+//
+// Keys are ContrastGame::history_hash(), which covers everything in the
+// network input. The table is direct-mapped and always replaces. Slots are
+// guarded by a sequence number (a seqlock): a writer makes it odd, writes
+// and makes it even again, a reader retries nothing and treats an odd or
+// changed sequence as a miss. So probe() and store() never block and may be
+// called concurrently by search threads.
+
+constexpr int EVAL_CACHE_MAX_MOVES = BOARD_SIZE * BB_NUM_DIRS; // 5 pieces, one slide per direction
+constexpr float EVAL_CACHE_LOGIT_SCALE = 256.0f;               // Fixed point steps per logit
+
+struct EvalCacheStats
+{
+    uint64_t lookups = 0;
+    uint64_t hits = 0;
+    uint64_t stores = 0;
+    uint64_t busy = 0; // Stores dropped because another thread was writing the slot
+
+    uint64_t misses() const { return lookups - hits; }
+    double hit_rate() const { return lookups ? (double)hits / lookups : 0.0; }
+};
+
+class EvalCache
+{
+public:
+    EvalCacheStats stats;
+
+    explicit EvalCache(size_t megabytes = 8)
+    {
+        resize(megabytes);
+    }
+
+    void resize(size_t megabytes)
+    {
+        size_t bytes = std::max<size_t>(megabytes, 1) << 20;
+        num_slots = 1;
+        while (num_slots * 2 * sizeof(Slot) <= bytes)
+            num_slots <<= 1;
+        slots.reset(new Slot[num_slots]);
+        clear();
+    }
+
+    void clear()
+    {
+        std::memset(slots.get(), 0, num_slots * sizeof(Slot));
+        stats = EvalCacheStats();
+    }
+
+    size_t capacity() const { return num_slots; }
+    size_t memory_bytes() const { return num_slots * sizeof(Slot); }
+
+    // Looks up `key`. On a hit fills `value`, `tile_logits` (NUM_TILES) and
+    // the entries of `move_logits` (625) at the stored legal moves, the only
+    // ones the priors read.
+    bool probe(uint64_t key, float *move_logits, float *tile_logits, float &value)
+    {
+        add_relaxed(stats.lookups, 1);
+        Slot &slot = slot_of(key);
+        uint32_t seq = __atomic_load_n(&slot.sequence, __ATOMIC_ACQUIRE);
+        if ((seq & 1) || __atomic_load_n(&slot.key, __ATOMIC_RELAXED) != key)
+            return false;
+        uint32_t words[RECORD_WORDS];
+        for (int i = 0; i < RECORD_WORDS; ++i)
+            words[i] = __atomic_load_n(&slot.words[i], __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&slot.sequence, __ATOMIC_RELAXED) != seq)
+            return false;
+
+        Record r;
+        std::memcpy(&r, words, sizeof(r));
+        value = r.value;
+        for (uint32_t i = 0; i < r.num_moves; ++i)
+            move_logits[r.move_index[i]] = r.move_logit[i] / EVAL_CACHE_LOGIT_SCALE;
+        for (int t = 0; t < NUM_TILES; ++t)
+            tile_logits[t] = r.tile_logit[t] / EVAL_CACHE_LOGIT_SCALE;
+        add_relaxed(stats.hits, 1);
+        return true;
+    }
+
+    // Caches one network output row for the position with `legal_actions`.
+    // `flip` is set when the network saw the board rotated (P2 to move), as
+    // in MCTS::fill_edges().
+    void store(uint64_t key, const ActionList &legal_actions, bool flip,
+               const float *move_logits, const float *tile_logits, float value)
+    {
+        Record r;
+        r.value = value;
+        r.num_moves = 0;
+        float move_max = -1e30f, tile_max = -1e30f;
+        for (int a : legal_actions)
+        {
+            if (a % NUM_TILES != 0)
+                continue; // Tile variants of the move just added
+            if (r.num_moves == EVAL_CACHE_MAX_MOVES)
+                return;
+            int move_idx = (flip ? flip_action(a) : a) / NUM_TILES;
+            r.move_index[r.num_moves++] = (uint16_t)move_idx;
+            move_max = std::max(move_max, move_logits[move_idx]);
+        }
+        for (int t = 0; t < NUM_TILES; ++t)
+            tile_max = std::max(tile_max, tile_logits[t]);
+        for (uint32_t i = 0; i < r.num_moves; ++i)
+            r.move_logit[i] = to_fixed(move_logits[r.move_index[i]] - move_max);
+        for (int t = 0; t < NUM_TILES; ++t)
+            r.tile_logit[t] = to_fixed(tile_logits[t] - tile_max);
+        std::fill(r.tile_logit + NUM_TILES, std::end(r.tile_logit), (int16_t)0);
+        std::fill(r.move_logit + r.num_moves, std::end(r.move_logit), (int16_t)0);
+        std::fill(r.move_index + r.num_moves, std::end(r.move_index), (uint16_t)0);
+
+        Slot &slot = slot_of(key);
+        uint32_t seq = __atomic_load_n(&slot.sequence, __ATOMIC_RELAXED);
+        if ((seq & 1) || !__atomic_compare_exchange_n(&slot.sequence, &seq, seq + 1, false, __ATOMIC_ACQUIRE,
+                                                      __ATOMIC_RELAXED))
+        {
+            add_relaxed(stats.busy, 1);
+            return;
+        }
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        uint32_t words[RECORD_WORDS];
+        std::memcpy(words, &r, sizeof(r));
+        __atomic_store_n(&slot.key, key, __ATOMIC_RELAXED);
+        for (int i = 0; i < RECORD_WORDS; ++i)
+            __atomic_store_n(&slot.words[i], words[i], __ATOMIC_RELAXED);
+        __atomic_store_n(&slot.sequence, seq + 2, __ATOMIC_RELEASE);
+        add_relaxed(stats.stores, 1);
+    }
+
+private:
+    // One cached evaluation, copied in and out of a slot word by word
+    struct Record
+    {
+        float value;
+        uint32_t num_moves;
+        uint16_t move_index[EVAL_CACHE_MAX_MOVES]; // Network move index (from * 25 + to)
+        int16_t move_logit[EVAL_CACHE_MAX_MOVES];
+        int16_t tile_logit[(NUM_TILES + 1) / 2 * 2];
+    };
+    static_assert(sizeof(Record) % sizeof(uint32_t) == 0, "records are copied in 32-bit words");
+    static constexpr int RECORD_WORDS = sizeof(Record) / sizeof(uint32_t);
+
+    struct Slot
+    {
+        uint32_t sequence; // Odd while a writer fills the slot
+        uint64_t key;
+        uint32_t words[RECORD_WORDS];
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    size_t num_slots = 0;
+
+    Slot &slot_of(uint64_t key) { return slots[key & (num_slots - 1)]; }
+
+    static int16_t to_fixed(float relative_logit)
+    {
+        return (int16_t)std::lrint(std::max(relative_logit * EVAL_CACHE_LOGIT_SCALE, -32767.0f));
+    }
+};
+
+#endif // EVALCACHE_H
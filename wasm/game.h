@@ -2,10 +2,12 @@
 #define GAME_H
 
 #include "tensor.h"
+#include "bitboard.h"
+#include "zobrist.h"
 #include <vector>
-#include <deque>
-#include <set>
+#include <type_traits>
 #include <cstring>
+#include <cassert>
 #include <algorithm>
 #include <map>
 
@@ -22,36 +24,164 @@ constexpr int INITIAL_GRAY_TILES = 1;
 constexpr int HISTORY_SIZE = 8;
 constexpr int MAX_STEPS = 200;
 
+// Encoded NN input: 66 planes of 5x5
+constexpr int ENCODED_PLANES = 66;
+using EncodedLayout = NchwLayout<ENCODED_PLANES, BOARD_SIZE, BOARD_SIZE>;
+constexpr int ENCODED_STATE_SIZE = EncodedLayout::image;
+
 // Action Size
 constexpr int NUM_TILES = 51; // 1 (none) + 25 (black) + 25 (gray)
+constexpr int NUM_MOVES = BOARD_SIZE * BOARD_SIZE * BOARD_SIZE * BOARD_SIZE; // from * 25 + to
+
+// Action decoding. An action is move_idx * NUM_TILES + tile_idx; the split by
+// the constant NUM_TILES compiles to a multiply, and everything else is read
+// from per-move and per-tile tables (under 3 KB, so they stay in L1 where
+// tables over all 31875 actions would not). Rotating the board 180 degrees
+// maps a move to NUM_MOVES - 1 - move_idx and a tile to tile_flipped.
+struct ActionTables
+{
+    uint8_t move_from[NUM_MOVES];
+    uint8_t move_to[NUM_MOVES];
+    uint8_t tile_color[NUM_TILES];  // TILE_WHITE: no tile placed
+    uint8_t tile_square[NUM_TILES];
+    uint8_t tile_flipped[NUM_TILES]; // Same colour on square 24 - square
+    uint8_t tile_same[NUM_TILES];    // Identity, for branch-free gathers
+
+    constexpr ActionTables() : move_from{}, move_to{}, tile_color{}, tile_square{}, tile_flipped{}, tile_same{}
+    {
+        for (int m = 0; m < NUM_MOVES; ++m)
+        {
+            move_from[m] = m / 25;
+            move_to[m] = m % 25;
+        }
+        for (int t = 0; t < NUM_TILES; ++t)
+        {
+            int sq = t == 0 ? 0 : t <= 25 ? t - 1 : t - 26;
+            tile_color[t] = t == 0 ? TILE_WHITE : t <= 25 ? TILE_BLACK : TILE_GRAY;
+            tile_square[t] = sq;
+            tile_flipped[t] = t == 0 ? 0 : t - sq + (24 - sq);
+            tile_same[t] = t;
+        }
+    }
+};
+
+inline constexpr ActionTables ACTION_TABLES{};
+
+struct DecodedAction
+{
+    int from, to;   // Squares, y * 5 + x
+    int tile_color; // TILE_WHITE if no tile is placed
+    int tile_square;
+};
+
+inline DecodedAction decode_action(int action_hash)
+{
+    int move_idx = action_hash / NUM_TILES;
+    int tile_idx = action_hash - move_idx * NUM_TILES;
+    return {ACTION_TABLES.move_from[move_idx], ACTION_TABLES.move_to[move_idx], ACTION_TABLES.tile_color[tile_idx],
+            ACTION_TABLES.tile_square[tile_idx]};
+}
+
+// 0/1 floats of every 5-square board row, indexed by its bits
+struct RowPlanes
+{
+    float row[32][BOARD_SIZE];
+
+    constexpr RowPlanes() : row{}
+    {
+        for (int bits = 0; bits < 32; ++bits)
+            for (int x = 0; x < BOARD_SIZE; ++x)
+                row[bits][x] = (bits >> x) & 1 ? 1.0f : 0.0f;
+    }
+};
+
+inline constexpr RowPlanes BB_ROW_PLANES{};
 
+// Packed history entry. Trivially copyable so the ring below (and the whole
+// ContrastState) can be copied with a single memcpy.
 struct GameStateSnapshot
 {
-    std::vector<int8_t> pieces;      // 25
-    std::vector<int8_t> tiles;       // 25
-    std::vector<int8_t> tile_counts; // 4 (P1_B, P1_G, P2_B, P2_G)
+    Bitboards bb;
+    int8_t tile_counts[4]; // P1_B, P1_G, P2_B, P2_G
 
     bool operator==(const GameStateSnapshot &other) const
     {
-        return pieces == other.pieces && tiles == other.tiles && tile_counts == other.tile_counts;
+        return std::memcmp(this, &other, sizeof(GameStateSnapshot)) == 0;
     }
 };
 
-class ContrastGame
+// Fixed-size circular buffer of the last HISTORY_SIZE snapshots.
+// Index 0 is the latest, like the std::deque it replaces.
+struct HistoryRing
+{
+    GameStateSnapshot slots[HISTORY_SIZE];
+    int head;  // Slot of the latest snapshot
+    int count; // Valid snapshots, <= HISTORY_SIZE
+
+    void clear()
+    {
+        head = 0;
+        count = 0;
+    }
+
+    void push_front(const GameStateSnapshot &snap)
+    {
+        head = (head + 1) % HISTORY_SIZE;
+        slots[head] = snap;
+        if (count < HISTORY_SIZE)
+            ++count;
+    }
+
+    int size() const { return count; }
+    const GameStateSnapshot &operator[](int i) const { return slots[(head - i + HISTORY_SIZE) % HISTORY_SIZE]; }
+    const GameStateSnapshot &back() const { return (*this)[count - 1]; }
+};
+
+// Everything except the repetition table. Must stay trivially copyable:
+// MCTS copies it once per simulation.
+struct ContrastState
 {
-public:
     int8_t pieces[BOARD_SIZE][BOARD_SIZE]; // 0=Empty, 1=P1, 2=P2
     int8_t tiles[BOARD_SIZE][BOARD_SIZE];  // 0=White, 1=Black, 2=Gray
 
     // [PlayerIdx][Type] where PlayerIdx=0(P1), 1(P2); Type=0(Black), 1(Gray)
     int8_t tile_counts[2][2];
 
+    // Mirrors pieces/tiles as masks; kept in sync by reset() and step()
+    Bitboards bb;
+
+    // Zobrist key of pieces, tiles, tile stock and side to move; updated incrementally by step()
+    uint64_t zobrist;
+
     int current_player; // 1 or 2
     bool game_over;
     int winner; // 0, 1, 2
     int move_count;
 
-    std::deque<GameStateSnapshot> history;
+    HistoryRing history;
+};
+
+static_assert(std::is_trivially_copyable<ContrastState>::value, "ContrastState must stay memcpy-able");
+
+// Everything make() changes that cannot be recomputed from the action.
+// Pieces, tiles and tile stock are restored by replaying the action backwards.
+struct UndoRecord
+{
+    int action;
+    bool applied;             // False if make() was a no-op (game already over)
+    bool counted_repetition;  // make() bumped position_history[key after the move]
+    bool game_over;
+    int winner;
+    int move_count;
+    uint64_t zobrist;
+    int history_head;
+    int history_count;
+    GameStateSnapshot evicted; // Ring slot overwritten by save_history()
+};
+
+class ContrastGame : public ContrastState
+{
+public:
     std::map<uint64_t, int> position_history; // Hash -> count
 
     ContrastGame()
@@ -59,6 +189,8 @@ public:
         reset();
     }
 
+    explicit ContrastGame(const ContrastState &state) : ContrastState(state) {}
+
     void reset()
     {
         std::memset(pieces, 0, sizeof(pieces));
@@ -80,68 +212,145 @@ public:
         winner = 0;
         move_count = 0;
 
+        sync_derived_state();
+
         history.clear();
         position_history.clear();
         save_history();
     }
 
+    // Rebuild the masks and the hash from the arrays (after editing them directly)
+    void sync_derived_state()
+    {
+        bb = {};
+        for (int i = 0; i < 25; ++i)
+        {
+            int p = pieces[i / 5][i % 5];
+            int t = tiles[i / 5][i % 5];
+            if (p != 0)
+                bb.pieces[p - 1] |= bb_bit(i);
+            if (t == TILE_BLACK)
+                bb.black |= bb_bit(i);
+            else if (t == TILE_GRAY)
+                bb.gray |= bb_bit(i);
+        }
+        zobrist = compute_zobrist();
+    }
+
+    // Full recompute of the Zobrist key from the arrays
+    uint64_t compute_zobrist() const
+    {
+        uint64_t h = 0;
+        for (int i = 0; i < 25; ++i)
+        {
+            int p = pieces[i / 5][i % 5];
+            int t = tiles[i / 5][i % 5];
+            if (p != 0)
+                h ^= ZOBRIST.piece[p - 1][i];
+            if (t != TILE_WHITE)
+                h ^= ZOBRIST.tile[t - 1][i];
+        }
+        for (int p = 0; p < 2; ++p)
+            for (int c = 0; c < 2; ++c)
+                h ^= ZOBRIST.stock[p][c][tile_counts[p][c]];
+        if (current_player == P2)
+            h ^= ZOBRIST.side;
+        return h;
+    }
+
     void save_history()
     {
         GameStateSnapshot snap;
-        snap.pieces.resize(25);
-        snap.tiles.resize(25);
-        snap.tile_counts.resize(4);
-
-        std::memcpy(snap.pieces.data(), pieces, 25);
-        std::memcpy(snap.tiles.data(), tiles, 25);
+        snap.bb = bb;
         snap.tile_counts[0] = tile_counts[0][0];
         snap.tile_counts[1] = tile_counts[0][1];
         snap.tile_counts[2] = tile_counts[1][0];
         snap.tile_counts[3] = tile_counts[1][1];
-
         history.push_front(snap);
-        if (history.size() > HISTORY_SIZE)
-        {
-            history.pop_back();
-        }
     }
 
-    // Board hash for repetition check
+    // Board hash for repetition check and MCTS keys
     uint64_t get_board_hash() const
     {
-        // Simple FNV-1a like hash
-        uint64_t h = 14695981039346656037ULL;
-        for (int i = 0; i < 5; ++i)
-            for (int j = 0; j < 5; ++j)
-            {
-                h ^= pieces[i][j];
-                h *= 1099511628211ULL;
-                h ^= tiles[i][j];
-                h *= 1099511628211ULL;
-            }
-        h ^= current_player;
-        h *= 1099511628211ULL;
-        return h;
+        return zobrist;
+    }
+
+    // 64-bit key of everything encode_state_into() reads: the history
+    // snapshots it uses (oldest repeated when fewer than HISTORY_SIZE), the
+    // side to move and the move count. Positions with equal keys have the
+    // same network input, which the Zobrist key alone does not guarantee.
+    uint64_t history_hash() const
+    {
+        uint64_t h = (uint64_t)current_player << 32 | (uint32_t)move_count;
+        int hist_len = history.size();
+        for (int i = 0; i < HISTORY_SIZE; ++i)
+        {
+            static_assert(sizeof(GameStateSnapshot) <= 3 * sizeof(uint64_t), "snapshot no longer fits the hash words");
+            uint64_t words[3] = {0, 0, 0};
+            std::memcpy(words, &((i < hist_len) ? history[i] : history.back()), sizeof(GameStateSnapshot));
+            for (uint64_t w : words)
+                h = ZobristTable::next(h) ^ w;
+        }
+        return ZobristTable::next(h);
     }
 
+    // Copies the trivially copyable ContrastState in one go.
+    // position_history is not needed for MCTS simulations and is left empty.
     ContrastGame copy() const
     {
-        ContrastGame g;
-        std::memcpy(g.pieces, pieces, sizeof(pieces));
-        std::memcpy(g.tiles, tiles, sizeof(tiles));
-        std::memcpy(g.tile_counts, tile_counts, sizeof(tile_counts));
-        g.current_player = current_player;
-        g.game_over = game_over;
-        g.winner = winner;
-        g.move_count = move_count;
-        g.history = history; // Copy deque
-        // position_history copy not strictly needed for MCTS sim but good for correctness
-        return g;
+        return ContrastGame(static_cast<const ContrastState &>(*this));
     }
 
     // --- Logic ---
 
     std::vector<int> get_valid_moves(int x, int y) const
+    {
+        std::vector<int> moves; // encoded as y*5+x
+        if (pieces[y][x] != current_player)
+            return moves;
+
+        int p_idx = current_player - 1;
+        int sq = y * 5 + x;
+        int d_begin, d_end;
+        bb_dir_range(bb, sq, d_begin, d_end);
+        for (int d = d_begin; d < d_end; ++d)
+        {
+            int to = bb_slide(sq, d, bb.pieces[p_idx], bb.pieces[p_idx ^ 1]);
+            if (to >= 0)
+                moves.push_back(to);
+        }
+        return moves;
+    }
+
+    // Allocation-free move generation into a caller-owned buffer
+    void generate_legal_actions(ActionList &actions) const
+    {
+        actions.clear();
+        if (game_over)
+            return;
+
+        int p_idx = current_player - 1;
+        bb_generate_actions(bb, p_idx, tile_counts[p_idx][0] > 0, tile_counts[p_idx][1] > 0, actions);
+    }
+
+    // Stops at the first legal move found
+    bool has_any_legal_action() const
+    {
+        return !game_over && bb_has_any_move(bb, current_player - 1);
+    }
+
+    std::vector<int> get_all_legal_actions() const
+    {
+        ActionList actions;
+        generate_legal_actions(actions);
+        return std::vector<int>(actions.begin(), actions.end());
+    }
+
+    // --- Reference array engine ---
+    // Straightforward scans over pieces/tiles. Kept as the specification the
+    // bitboard generator is tested against (see test_main.cpp).
+
+    std::vector<int> scan_valid_moves(int x, int y) const
     {
         std::vector<int> moves; // encoded as y*5+x
         if (pieces[y][x] != current_player)
@@ -205,7 +414,7 @@ public:
         return moves;
     }
 
-    std::vector<int> get_all_legal_actions() const
+    std::vector<int> scan_legal_actions() const
     {
         if (game_over)
             return {};
@@ -236,7 +445,7 @@ public:
             int cx = p.first;
             int cy = p.second;
 
-            std::vector<int> moves = get_valid_moves(cx, cy);
+            std::vector<int> moves = scan_valid_moves(cx, cy);
             for (int m_enc : moves)
             {
                 int mx = m_enc % 5;
@@ -296,59 +505,70 @@ public:
 
     void step(int action_hash)
     {
-        if (game_over)
-            return;
+        make(action_hash);
+    }
 
-        int move_idx = action_hash / NUM_TILES;
-        int tile_idx = action_hash % NUM_TILES;
+    // step() that also returns what unmake() needs to restore the exact prior state
+    UndoRecord make(int action_hash)
+    {
+        UndoRecord undo;
+        undo.action = action_hash;
+        undo.applied = !game_over;
+        undo.counted_repetition = false;
+        if (game_over)
+            return undo;
 
-        int from_idx = move_idx / 25;
-        int to_idx = move_idx % 25;
+        undo.game_over = game_over;
+        undo.winner = winner;
+        undo.move_count = move_count;
+        undo.zobrist = zobrist;
+        undo.history_head = history.head;
+        undo.history_count = history.count;
+        undo.evicted = history.slots[(history.head + 1) % HISTORY_SIZE];
 
-        int fx = from_idx % 5;
-        int fy = from_idx / 5;
-        int tx = to_idx % 5;
-        int ty = to_idx / 5;
+        DecodedAction d = decode_action(action_hash);
+        int from_idx = d.from;
+        int to_idx = d.to;
 
         // Execute Move
-        pieces[ty][tx] = pieces[fy][fx];
-        pieces[fy][fx] = 0;
+        pieces[to_idx / 5][to_idx % 5] = pieces[from_idx / 5][from_idx % 5];
+        pieces[from_idx / 5][from_idx % 5] = 0;
+        bb.pieces[current_player - 1] ^= bb_bit(from_idx) | bb_bit(to_idx);
+        zobrist ^= ZOBRIST.piece[current_player - 1][from_idx] ^ ZOBRIST.piece[current_player - 1][to_idx];
 
         // Execute Tile
-        if (tile_idx > 0)
+        if (d.tile_color != TILE_WHITE)
         {
-            int t_color = 0;
-            int t_loc = 0;
-            if (tile_idx <= 25)
-            {
-                t_color = TILE_BLACK;
-                t_loc = tile_idx - 1;
-            }
-            else
-            {
-                t_color = TILE_GRAY;
-                t_loc = tile_idx - 26;
-            }
-            int t_x = t_loc % 5;
-            int t_y = t_loc / 5;
+            int t_color = d.tile_color;
+            int t_loc = d.tile_square;
 
-            tiles[t_y][t_x] = t_color;
+            tiles[t_loc / 5][t_loc % 5] = t_color;
+            if (t_color == TILE_BLACK)
+                bb.black |= bb_bit(t_loc);
+            else
+                bb.gray |= bb_bit(t_loc);
 
             // Decrement stock
             int p_idx = current_player - 1;
             int c_idx = (t_color == TILE_BLACK) ? 0 : 1;
+            zobrist ^= ZOBRIST.tile[c_idx][t_loc] ^ ZOBRIST.stock[p_idx][c_idx][tile_counts[p_idx][c_idx]];
             tile_counts[p_idx][c_idx]--;
+            zobrist ^= ZOBRIST.stock[p_idx][c_idx][tile_counts[p_idx][c_idx]];
         }
 
         check_win_fast();
 
         current_player = (current_player == P1) ? P2 : P1;
+        zobrist ^= ZOBRIST.side;
+
+#ifdef CONTRAST_DEBUG_HASH
+        assert(zobrist == compute_zobrist());
+#endif
 
         // Check legal moves for next player
         if (!game_over)
         {
-            auto acts = get_all_legal_actions();
-            if (acts.empty())
+            if (!has_any_legal_action())
             {
                 game_over = true;
                 winner = (current_player == P1) ? P2 : P1;
@@ -362,44 +582,137 @@ public:
         if (!game_over && move_count >= 50)
         {
             uint64_t h = get_board_hash();
-            position_history[h]++;
-            if (position_history[h] >= 5)
+            int &seen = position_history[h];
+            seen++;
+            undo.counted_repetition = true;
+            if (seen >= 5)
             {
                 game_over = true;
                 winner = 0; // Draw
             }
         }
+        return undo;
+    }
+
+    void unmake(const UndoRecord &undo)
+    {
+        if (!undo.applied)
+            return;
+
+        if (undo.counted_repetition)
+        {
+            auto it = position_history.find(zobrist);
+            if (--it->second == 0)
+                position_history.erase(it);
+        }
+
+        history.slots[history.head] = undo.evicted;
+        history.head = undo.history_head;
+        history.count = undo.history_count;
+
+        current_player = (current_player == P1) ? P2 : P1;
+        int p_idx = current_player - 1;
+
+        DecodedAction d = decode_action(undo.action);
+        int from_idx = d.from;
+        int to_idx = d.to;
+
+        // Undo Move
+        pieces[from_idx / 5][from_idx % 5] = pieces[to_idx / 5][to_idx % 5];
+        pieces[to_idx / 5][to_idx % 5] = 0;
+        bb.pieces[p_idx] ^= bb_bit(from_idx) | bb_bit(to_idx);
+
+        // Undo Tile (tiles are only ever placed on white squares)
+        if (d.tile_color != TILE_WHITE)
+        {
+            int c_idx = (d.tile_color == TILE_BLACK) ? 0 : 1;
+            int t_loc = d.tile_square;
+            tiles[t_loc / 5][t_loc % 5] = TILE_WHITE;
+            bb.black &= ~bb_bit(t_loc);
+            bb.gray &= ~bb_bit(t_loc);
+            tile_counts[p_idx][c_idx]++;
+        }
+
+        zobrist = undo.zobrist;
+        move_count = undo.move_count;
+        game_over = undo.game_over;
+        winner = undo.winner;
     }
 
     void check_win_fast()
     {
-        for (int x = 0; x < 5; ++x)
+        if (bb.pieces[0] & BB_ROW_TOP)
         {
-            if (pieces[0][x] == P1)
-            {
-                game_over = true;
-                winner = P1;
-                return;
-            }
+            game_over = true;
+            winner = P1;
+            return;
         }
-        for (int x = 0; x < 5; ++x)
+        if (bb.pieces[1] & BB_ROW_BOTTOM)
         {
-            if (pieces[4][x] == P2)
-            {
-                game_over = true;
-                winner = P2;
-                return;
-            }
+            game_over = true;
+            winner = P2;
+            return;
         }
     }
 
     // Encode state for NN
-    // Returns Tensor(90, 5, 5) flattened ?? No, keep shape logic but stored in Tensor (N=90)
-    // Actually Tensor class supports (N, C, H, W). Here batch=1, C=90, H=5, W=5.
+    // Tensor class supports (N, C, H, W). Here batch=1, C=66, H=5, W=5.
     Tensor encode_state() const
     {
         Tensor t({1, 66, 5, 5});
-        t.fill(0.0f);
+        encode_state_into(t.data.data());
+        return t;
+    }
+
+    // Writes the 66x5x5 planes of this position to `out` (e.g. one slot of a
+    // batch). Every float is written exactly once: bitboard planes are
+    // expanded over the fixed 25 squares (flipped for P2 by reversing the
+    // bits), which the compiler unrolls and vectorizes.
+    void encode_state_into(float *out) const
+    {
+        constexpr int plane = EncodedLayout::plane;
+        bool should_flip = (current_player == P2);
+        int my_idx = current_player - 1;
+        int opp_idx = 1 - my_idx;
+        int hist_len = history.size();
+
+        for (int i = 0; i < HISTORY_SIZE; ++i)
+        {
+            const auto &snap = (i < hist_len) ? history[i] : history.back();
+
+            // Channels 0-7: My Pieces, 8-15: Opp Pieces, 16-23: Black Tiles, 24-31: Gray Tiles
+            const uint32_t planes[4] = {snap.bb.pieces[my_idx], snap.bb.pieces[opp_idx], snap.bb.black, snap.bb.gray};
+            for (int k = 0; k < 4; ++k)
+            {
+                uint32_t bits = should_flip ? bb_rotate180(planes[k]) : planes[k];
+                float *dst = out + EncodedLayout::index(0, k * HISTORY_SIZE + i, 0, 0);
+                for (int y = 0; y < BOARD_SIZE; ++y, bits >>= BOARD_SIZE)
+                    std::memcpy(dst + y * BOARD_SIZE, BB_ROW_PLANES.row[bits & 31], BOARD_SIZE * sizeof(float));
+            }
+
+            // Counts (planes 32-63)
+            const float counts[4] = {
+                snap.tile_counts[my_idx * 2 + 0] / 3.0f,
+                snap.tile_counts[my_idx * 2 + 1] / 1.0f,
+                snap.tile_counts[opp_idx * 2 + 0] / 3.0f,
+                snap.tile_counts[opp_idx * 2 + 1] / 1.0f,
+            };
+            for (int k = 0; k < 4; ++k)
+                std::fill_n(out + EncodedLayout::index(0, 32 + k * HISTORY_SIZE + i, 0, 0), plane, counts[k]);
+        }
+
+        // Channel 64: Color (Always 1 for current player since we flip)
+        std::fill_n(out + EncodedLayout::index(0, 64, 0, 0), plane, 1.0f);
+
+        // Channel 65: Move Count
+        std::fill_n(out + EncodedLayout::index(0, 65, 0, 0), plane, (float)move_count / MAX_STEPS);
+    }
+
+    // Clears the planes and sets the occupied squares one by one; kept as the
+    // reference encode_state_into() is tested and benchmarked against
+    void encode_state_reference_into(float *out) const
+    {
+        std::fill_n(out, ENCODED_STATE_SIZE, 0.0f);
 
         int current_pid = current_player;
         int opp_pid = (current_pid == P1) ? P2 : P1;
@@ -415,64 +728,39 @@ public:
             const auto &snap = (i < hist_len) ? history[i] : history.back();
             // history[0] is latest
 
-            for (int y = 0; y < 5; ++y)
+            // Channels 0-7: My Pieces, 8-15: Opp Pieces, 16-23: Black Tiles, 24-31: Gray Tiles
+            const uint32_t planes[4] = {snap.bb.pieces[my_idx], snap.bb.pieces[opp_idx], snap.bb.black, snap.bb.gray};
+            for (int k = 0; k < 4; ++k)
             {
-                for (int x = 0; x < 5; ++x)
+                float *plane = &out[(k * 8 + i) * 25];
+                for (uint32_t m = planes[k]; m; m &= m - 1)
                 {
-                    int idx = y * 5 + x; // Snap is flat vector
-                    int p_val = snap.pieces[idx];
-                    int t_val = snap.tiles[idx];
-
-                    int draw_x = x;
-                    int draw_y = y;
-
-                    if (should_flip)
-                    {
-                        // Rotate 180 means (x,y) -> (4-x, 4-y)
-                        draw_x = 4 - x;
-                        draw_y = 4 - y;
-                    }
-
-                    // Channels 0-7: My Pieces
-                    if (p_val == current_pid)
-                    {
-                        t[t.index(0, i, draw_y, draw_x)] = 1.0f;
-                    }
-                    // Channels 8-15: Opp Pieces
-                    if (p_val == opp_pid)
-                    {
-                        t[t.index(0, 8 + i, draw_y, draw_x)] = 1.0f;
-                    }
-                    // Channels 16-23: Black Tiles
-                    if (t_val == TILE_BLACK)
-                    {
-                        t[t.index(0, 16 + i, draw_y, draw_x)] = 1.0f;
-                    }
-                    // Channels 24-31: Gray Tiles
-                    if (t_val == TILE_GRAY)
-                    {
-                        t[t.index(0, 24 + i, draw_y, draw_x)] = 1.0f;
-                    }
-
-                    // Counts (planes 32-63)
-                    t[t.index(0, 32 + i, draw_y, draw_x)] = snap.tile_counts[my_idx * 2 + 0] / 3.0f;
-                    t[t.index(0, 40 + i, draw_y, draw_x)] = snap.tile_counts[my_idx * 2 + 1] / 1.0f;
-                    t[t.index(0, 48 + i, draw_y, draw_x)] = snap.tile_counts[opp_idx * 2 + 0] / 3.0f;
-                    t[t.index(0, 56 + i, draw_y, draw_x)] = snap.tile_counts[opp_idx * 2 + 1] / 1.0f;
+                    int sq = bb_lowest(m);
+                    // Rotate 180 means (x,y) -> (4-x, 4-y), i.e. sq -> 24-sq
+                    plane[should_flip ? 24 - sq : sq] = 1.0f;
                 }
             }
+
+            // Counts (planes 32-63)
+            const float counts[4] = {
+                snap.tile_counts[my_idx * 2 + 0] / 3.0f,
+                snap.tile_counts[my_idx * 2 + 1] / 1.0f,
+                snap.tile_counts[opp_idx * 2 + 0] / 3.0f,
+                snap.tile_counts[opp_idx * 2 + 1] / 1.0f,
+            };
+            for (int k = 0; k < 4; ++k)
+                std::fill_n(&out[(32 + k * 8 + i) * 25], 25, counts[k]);
         }
 
         // Channel 64: Color (Always 1 for current player since we flip)
         for (int i = 0; i < 25; ++i)
-            t.data[64 * 25 + i] = 1.0f;
+            out[64 * 25 + i] = 1.0f;
 
         // Channel 65: Move Count
         float mc_val = (float)move_count / 200.0f; // MAX_STEPS
         for (int i = 0; i < 25; ++i)
-            t.data[65 * 25 + i] = mc_val;
+            out[65 * 25 + i] = mc_val;
 
-        return t;
     }
 };
 
@@ -485,32 +773,8 @@ inline int flip_location(int idx)
 inline int flip_action(int action_hash)
 {
     int move_idx = action_hash / NUM_TILES;
-    int tile_idx = action_hash % NUM_TILES;
-
-    int from_idx = move_idx / 25;
-    int to_idx = move_idx % 25;
-
-    int new_from = flip_location(from_idx);
-    int new_to = flip_location(to_idx);
-    int new_move_idx = new_from * 25 + new_to;
-
-    int new_tile_idx = 0;
-    if (tile_idx > 0)
-    {
-        if (tile_idx <= 25)
-        { // Black
-            int pos = tile_idx - 1;
-            int new_pos = flip_location(pos);
-            new_tile_idx = new_pos + 1;
-        }
-        else
-        { // Gray
-            int pos = tile_idx - 26;
-            int new_pos = flip_location(pos);
-            new_tile_idx = new_pos + 26;
-        }
-    }
-    return new_move_idx * NUM_TILES + new_tile_idx;
+    int tile_idx = action_hash - move_idx * NUM_TILES;
+    return (NUM_MOVES - 1 - move_idx) * NUM_TILES + ACTION_TABLES.tile_flipped[tile_idx];
 }
 
 #endif // GAME_H
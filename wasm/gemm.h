@@ -0,0 +1,175 @@
+#ifndef GEMM_H
+#define GEMM_H
+
+#include "simd.h"
+#include "arena.h"
+#include <vector>
+#include <algorithm>
+
+// Single-precision GEMM for the convolution layers.
+//
+// C[M x N] = A[M x K] * B[K x N], row-major with leading dimensions, C is
+// overwritten. Blocked the usual way: B is packed into KC x NC panels of NR
+// columns, A into MC x KC panels of MR rows, and an MR x NR micro-kernel from
+// simd.h keeps its accumulators in registers while it streams both panels.
+// The packed panels are contiguous and zero padded, so the kernel has no edge
+// cases in its inner loop; partial tiles at the borders of C go through a
+// small scratch tile instead.
+
+constexpr int GEMM_KC = 256; // Depth of a packed panel (fits A and B slivers in L1)
+constexpr int GEMM_MC = 64;  // Rows of A packed at once (L2)
+constexpr int GEMM_NC = 512; // Columns of B packed at once
+
+// Packs rows [0, mc) x cols [0, kc) of A as consecutive mr-row slivers,
+// column-major inside each sliver: a_pack[(i / mr) * kc * mr + p * mr + i % mr]
+inline void gemm_pack_a(int mc, int kc, const float* A, int lda, int mr, float* a_pack) {
+    for (int i0 = 0; i0 < mc; i0 += mr) {
+        int rows = std::min(mr, mc - i0);
+        for (int p = 0; p < kc; ++p) {
+            for (int i = 0; i < rows; ++i) a_pack[i] = A[(i0 + i) * lda + p];
+            for (int i = rows; i < mr; ++i) a_pack[i] = 0.0f;
+            a_pack += mr;
+        }
+    }
+}
+
+// Packs rows [0, kc) x cols [0, nc) of B as consecutive nr-column slivers,
+// row-major inside each sliver: b_pack[(j / nr) * kc * nr + p * nr + j % nr]
+inline void gemm_pack_b(int kc, int nc, const float* B, int ldb, int nr, float* b_pack) {
+    for (int j0 = 0; j0 < nc; j0 += nr) {
+        int cols = std::min(nr, nc - j0);
+        for (int p = 0; p < kc; ++p) {
+            const float* row = B + p * ldb + j0;
+            for (int j = 0; j < cols; ++j) b_pack[j] = row[j];
+            for (int j = cols; j < nr; ++j) b_pack[j] = 0.0f;
+            b_pack += nr;
+        }
+    }
+}
+
+// Arena floats sgemm() needs for an M x N x K product, for any kernel variant
+inline size_t sgemm_workspace(int M, int N, int K) {
+    size_t kc = std::min(K, GEMM_KC);
+    return Arena::rounded((std::min(M, GEMM_MC) + SIMD_MAX_MR) * kc) +
+           Arena::rounded((std::min(N, GEMM_NC) + SIMD_MAX_NR) * kc);
+}
+
+inline void sgemm(int M, int N, int K, const float* A, int lda, const float* B, int ldb, float* C, int ldc,
+                  Arena& arena, const SimdKernels& kernels = simd_kernels()) {
+    const int MR = kernels.mr, NR = kernels.nr;
+    const int MC = std::max(GEMM_MC / MR, 1) * MR;
+    auto round_up = [](int x, int r) { return (x + r - 1) / r * r; };
+    size_t arena_mark = arena.mark();
+    float* a_pack = arena.alloc(round_up(std::min(M, MC), MR) * std::min(K, GEMM_KC));
+    float* b_pack = arena.alloc(round_up(std::min(N, GEMM_NC), NR) * std::min(K, GEMM_KC));
+    float tile[SIMD_MAX_MR * SIMD_MAX_NR];
+
+    for (int jc = 0; jc < N; jc += GEMM_NC) {
+        int nc = std::min(GEMM_NC, N - jc);
+        for (int pc = 0; pc < K; pc += GEMM_KC) {
+            int kc = std::min(GEMM_KC, K - pc);
+            bool accumulate = pc > 0;
+            gemm_pack_b(kc, nc, B + pc * ldb + jc, ldb, NR, b_pack);
+
+            for (int ic = 0; ic < M; ic += MC) {
+                int mc = std::min(MC, M - ic);
+                gemm_pack_a(mc, kc, A + ic * lda + pc, lda, MR, a_pack);
+
+                for (int jr = 0; jr < nc; jr += NR) {
+                    const float* b_sliver = b_pack + jr * kc;
+                    int nr = std::min(NR, nc - jr);
+                    for (int ir = 0; ir < mc; ir += MR) {
+                        const float* a_sliver = a_pack + ir * kc;
+                        int mr = std::min(MR, mc - ir);
+                        float* c = C + (ic + ir) * ldc + jc + jr;
+                        if (mr == MR && nr == NR) {
+                            kernels.gemm_tile(kc, a_sliver, b_sliver, c, ldc, accumulate);
+                            continue;
+                        }
+                        kernels.gemm_tile(kc, a_sliver, b_sliver, tile, NR, false);
+                        for (int i = 0; i < mr; ++i) {
+                            for (int j = 0; j < nr; ++j) {
+                                c[i * ldc + j] = accumulate ? c[i * ldc + j] + tile[i * NR + j] : tile[i * NR + j];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    arena.release(arena_mark);
+}
+
+// sgemm() with its own scratch, for callers outside a forward pass
+inline void sgemm(int M, int N, int K, const float* A, int lda, const float* B, int ldb, float* C, int ldc,
+                  const SimdKernels& kernels = simd_kernels()) {
+    Arena arena(sgemm_workspace(M, N, K));
+    sgemm(M, N, K, A, lda, B, ldb, C, ldc, arena, kernels);
+}
+
+// Lowers a batch of images [N, C, H, W] to the convolution's column matrix:
+// row (c, kh, kw), column (n, h_out, w_out), i.e. [C * k * k, N * H_out * W_out].
+// Out-of-bounds taps read the implicit zero padding.
+inline void im2col(const float* input, int N, int C, int H, int W,
+                   int k, int stride, int pad, int H_out, int W_out, float* cols) {
+    int hw_out = H_out * W_out;
+    int row_len = N * hw_out;
+    for (int c = 0; c < C; ++c) {
+        for (int kh = 0; kh < k; ++kh) {
+            for (int kw = 0; kw < k; ++kw) {
+                float* row = cols + ((c * k + kh) * k + kw) * row_len;
+                for (int n = 0; n < N; ++n) {
+                    const float* plane = input + (n * C + c) * H * W;
+                    for (int h = 0; h < H_out; ++h) {
+                        int y = h * stride + kh - pad;
+                        for (int w = 0; w < W_out; ++w) {
+                            int x = w * stride + kw - pad;
+                            *row++ = (y >= 0 && y < H && x >= 0 && x < W) ? plane[y * W + x] : 0.0f;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Copies an H x W plane into an HP x WP buffer at offset (PAD, PAD) and
+// zeroes the rest, so kernels of a fixed geometry read padded taps with no
+// bounds checks. HP and WP may exceed H + 2 PAD (Winograd tiles overhang).
+template <int H, int W, int PAD, int HP = H + 2 * PAD, int WP = W + 2 * PAD>
+inline void pad_plane(const float* plane, float* padded) {
+    static_assert(HP >= H + 2 * PAD && WP >= W + 2 * PAD, "padded plane too small");
+    std::fill(padded, padded + HP * WP, 0.0f);
+    for (int y = 0; y < H; ++y) std::copy(plane + y * W, plane + (y + 1) * W, padded + (y + PAD) * WP + PAD);
+}
+
+// im2col() for a stride-1 "same" convolution (pad K / 2) on H x W planes
+// known at compile time: each row of a tap is W contiguous floats of the
+// padded plane, and every trip count is a constant.
+template <int K, int H, int W>
+inline void im2col_same(const float* input, int N, int C, float* cols) {
+    constexpr int PAD = K / 2, HW = H * W, WP = W + 2 * PAD;
+    int row_len = N * HW;
+    float padded[(H + 2 * PAD) * WP];
+    for (int c = 0; c < C; ++c) {
+        for (int n = 0; n < N; ++n) {
+            const float* plane = input + (size_t)(n * C + c) * HW;
+            if constexpr (PAD == 0) {
+                std::copy(plane, plane + HW, cols + (size_t)c * row_len + n * HW);
+                continue;
+            }
+            pad_plane<H, W, PAD>(plane, padded);
+            for (int kh = 0; kh < K; ++kh) {
+                for (int kw = 0; kw < K; ++kw) {
+                    float* row = cols + (size_t)((c * K + kh) * K + kw) * row_len + n * HW;
+                    for (int h = 0; h < H; ++h) {
+                        const float* src = padded + (h + kh) * WP + kw;
+                        std::copy(src, src + W, row + h * W);
+                    }
+                }
+            }
+        }
+    }
+}
+
+#endif // GEMM_H
@@ -2,6 +2,9 @@
 #define LAYERS_H
 
 #include "tensor.h"
+#include "gemm.h"
+#include "winograd.h"
+#include "quant.h"
 #include <vector>
 #include <cmath>
 #include <cassert>
@@ -22,25 +25,32 @@ inline Tensor pad_tensor(const Tensor& input, int pad) {
     
     Tensor output({N, C, H_out, W_out});
     
+    // Strides are looked up once per plane; rows are copied whole
     for(int n=0; n<N; ++n) {
         for(int c=0; c<C; ++c) {
+            const float* src = &input[input.index(n, c, 0, 0)];
+            float* dst = &output[output.index(n, c, pad, pad)];
             for(int h=0; h<H; ++h) {
-                for(int w=0; w<W; ++w) {
-                    int idx_in = input.index(n, c, h, w);
-                    int idx_out = output.index(n, c, h+pad, w+pad);
-                    output[idx_out] = input[idx_in];
-                }
+                std::copy(src + h * W, src + (h + 1) * W, dst + h * W_out);
             }
         }
     }
     return output;
 }
 
+// Convolution algorithm, selectable per Conv2d
+enum ConvAlgo {
+    CONV_GEMM,         // im2col + GEMM, any shape
+    CONV_WINOGRAD_2X2, // Winograd F(2x2, 3x3), stride-1 3x3 only
+    CONV_WINOGRAD_4X4, // Winograd F(4x4, 3x3), stride-1 3x3 only
+    CONV_INT8,         // int8 weights and activations (quant.h), any shape; needs a calibrated input scale
+};
+
 // Conv2d Layer
 class Conv2d {
 public:
-    Tensor weight;
-    Tensor bias;
+    Parameter weight; // [out_channels, in_channels, kernel_size, kernel_size]
+    Parameter bias;   // [out_channels]
     int in_channels;
     int out_channels;
     int kernel_size;
@@ -48,22 +58,196 @@ public:
     int padding;
     bool has_bias;
 
+    ConvAlgo algo = CONV_GEMM;
+    std::vector<float> winograd_weights; // Pre-transformed for `algo` when it is a Winograd one
+    QuantState quant;                    // Quantized for `algo` == CONV_INT8
+
     Conv2d(int in_c, int out_c, int k, int s, int p, bool bias=true)
         : in_channels(in_c), out_channels(out_c), kernel_size(k), stride(s), padding(p), has_bias(bias) {}
 
+    std::vector<int> weight_shape() const { return {out_channels, in_channels, kernel_size, kernel_size}; }
+
     // Load weights/bias from raw float arrays
     void load_weights(const std::vector<float>& w_data, const std::vector<float>& b_data) {
-        weight = Tensor({out_channels, in_channels, kernel_size, kernel_size}, w_data);
-        if (has_bias) {
-            bias = Tensor({out_channels}, b_data);
+        set_weights(Parameter(weight_shape(), w_data), has_bias ? Parameter({out_channels}, b_data) : Parameter());
+    }
+
+    // Takes parameters of weight_shape() and [out_channels], owned or views
+    void set_weights(Parameter w, Parameter b) {
+        assert(w.shape == weight_shape() && (!has_bias || b.shape == std::vector<int>{out_channels}));
+        weight = std::move(w);
+        bias = std::move(b);
+        prepare_weights();
+    }
+
+    bool supports(ConvAlgo a) const {
+        if (a == CONV_INT8) return quant.calibrated();
+        return a == CONV_GEMM || (kernel_size == 3 && stride == 1);
+    }
+
+    // Switch algorithm; Winograd and int8 weights are prepared here, not per
+    // call. Returns false (and keeps the current algorithm) if the shape is
+    // unsupported or, for int8, the input scale is not calibrated yet.
+    bool set_algorithm(ConvAlgo a) {
+        if (!supports(a)) return false;
+        algo = a;
+        prepare_weights();
+        return true;
+    }
+
+    // Multiplies in one forward pass over N images of H x W (transforms excluded)
+    long long multiplies(int N, int H, int W) const {
+        int H_out = (H + 2 * padding - kernel_size) / stride + 1;
+        int W_out = (W + 2 * padding - kernel_size) / stride + 1;
+        if (algo == CONV_GEMM || algo == CONV_INT8) {
+            return (long long)N * out_channels * in_channels * kernel_size * kernel_size * H_out * W_out;
+        }
+        int m = winograd_tile();
+        int tiles = ((H_out + m - 1) / m) * ((W_out + m - 1) / m);
+        return (long long)N * out_channels * in_channels * (m + 2) * (m + 2) * tiles;
+    }
+
+    int out_size(int in_size) const { return (in_size + 2 * padding - kernel_size) / stride + 1; }
+
+    // Arena floats forward_into() needs for N images of H x W
+    size_t workspace(int N, int H, int W) const {
+        if (algo == CONV_WINOGRAD_4X4) return winograd_workspace<4>(N, in_channels, H, W, padding, out_channels);
+        if (algo == CONV_WINOGRAD_2X2) return winograd_workspace<2>(N, in_channels, H, W, padding, out_channels);
+        int K = in_channels * kernel_size * kernel_size;
+        int cols_n = N * out_size(H) * out_size(W);
+        if (algo == CONV_INT8) {
+            size_t padded = (size_t)N * (H + 2 * padding) * (W + 2 * padding) * in_channels;
+            return quant_rows_floats(1, padded) + (direct_int8() ? 0 : quant_rows_floats(cols_n, quant_stride(K)));
         }
+        size_t floats = sgemm_workspace(out_channels, cols_n, K);
+        if (!direct_gemm(N)) floats += Arena::rounded((size_t)K * cols_n);
+        if (N > 1) floats += Arena::rounded((size_t)out_channels * cols_n);
+        return floats;
     }
 
+    // Convenience wrapper over forward_into() with its own scratch
     Tensor forward(const Tensor& input) {
-        // Input: [N, C_in, H_in, W_in]
         int N = input.shape[0];
         int H_in = input.shape[2];
         int W_in = input.shape[3];
+        Tensor output({N, out_channels, out_size(H_in), out_size(W_in)});
+        Arena arena(workspace(N, H_in, W_in));
+        forward_into(input.data.data(), N, H_in, W_in, output.data.data(), arena);
+        return output;
+    }
+
+    // [N, C_in, H, W] -> [N, C_out, H_out, W_out]; scratch comes from `arena`
+    // and is handed back before returning. The epilogue fused into the output
+    // pass adds the bias and, if given, `residual` (output-shaped), then
+    // applies ReLU if `relu`. Neither `input` nor `residual` may alias `output`.
+    // Nonzero IN_C and OUT_C must equal the layer's channel counts; the
+    // Winograd kernels are then instantiated with them as constants. Nonzero
+    // H and W must equal H_in and W_in: a stride-1 "same" convolution then
+    // runs the kernels of that fixed geometry (any other shape ignores them).
+    template <int IN_C = 0, int OUT_C = 0, int H = 0, int W = 0>
+    void forward_into(const float* input, int N, int H_in, int W_in, float* output, Arena& arena,
+                      bool relu = false, const float* residual = nullptr) const {
+        assert((!IN_C || IN_C == in_channels) && (!OUT_C || OUT_C == out_channels));
+        assert((!H || H == H_in) && (!W || W == W_in));
+        quant.observe(input, (size_t)N * in_channels * H_in * W_in);
+        if (algo == CONV_INT8) {
+            forward_int8<IN_C, H, W>(input, N, H_in, W_in, output, arena, relu, residual);
+            return;
+        }
+        if (algo != CONV_GEMM) {
+            auto conv = (algo == CONV_WINOGRAD_4X4) ? winograd_conv<4, IN_C, OUT_C> : winograd_conv<2, IN_C, OUT_C>;
+            if constexpr (H && W) {
+                if (padding == 1)
+                    conv = (algo == CONV_WINOGRAD_4X4) ? winograd_conv<4, IN_C, OUT_C, H, W>
+                                                       : winograd_conv<2, IN_C, OUT_C, H, W>;
+            }
+            conv(input, N, in_channels, H_in, W_in, padding, winograd_weights.data(), out_channels,
+                 has_bias ? bias.data() : nullptr, output, arena, relu, residual);
+            return;
+        }
+        forward_gemm<H, W>(input, N, H_in, W_in, output, arena, relu, residual);
+    }
+
+    // Convolution as one GEMM: weight [C_out, C_in*k*k] x columns [C_in*k*k, N*H_out*W_out].
+    // A 1x1 unpadded conv on a single image multiplies the input directly.
+    template <int H = 0, int W = 0>
+    void forward_gemm(const float* input, int N, int H_in, int W_in, float* output, Arena& arena,
+                      bool relu = false, const float* residual = nullptr) const {
+        int H_out = out_size(H_in);
+        int W_out = out_size(W_in);
+        int hw_out = H_out * W_out;
+        int K = in_channels * kernel_size * kernel_size;
+        int cols_n = N * hw_out;
+        size_t arena_mark = arena.mark();
+
+        const float* cols = input;
+        if (!direct_gemm(N)) {
+            float* cols_buf = arena.alloc((size_t)K * cols_n);
+            bool lowered = false;
+            if constexpr (H && W) {
+                if (same_geometry(1)) im2col_same<1, H, W>(input, N, in_channels, cols_buf);
+                else if (same_geometry(3)) im2col_same<3, H, W>(input, N, in_channels, cols_buf);
+                lowered = same_geometry(1) || same_geometry(3);
+            }
+            if (!lowered)
+                im2col(input, N, in_channels, H_in, W_in, kernel_size, stride, padding, H_out, W_out, cols_buf);
+            cols = cols_buf;
+        }
+
+        // GEMM rows are output channels and columns run over (n, h, w), so for
+        // a single image the result already has the output layout
+        float* gemm_out = output;
+        if (N > 1) gemm_out = arena.alloc((size_t)out_channels * cols_n);
+        sgemm(out_channels, cols_n, K, weight.data(), K, cols, cols_n, gemm_out, cols_n, arena);
+
+        const SimdKernels& k = simd_kernels();
+        for (int n = 0; n < N; ++n) {
+            for (int oc = 0; oc < out_channels; ++oc) {
+                float b_val = has_bias ? bias[oc] : 0.0f;
+                const float* src = gemm_out + oc * cols_n + n * hw_out;
+                size_t dst_off = (size_t)(n * out_channels + oc) * hw_out;
+                k.epilogue(output + dst_off, src, b_val, residual ? residual + dst_off : nullptr, relu, hw_out);
+            }
+        }
+        arena.release(arena_mark);
+    }
+
+    // Convolution on int8 weights and activations: the input is quantized
+    // once to padded channels-last, lowered to patch rows (a 1x1 conv on a
+    // whole number of vectors uses it as is), and multiplied by the quantized
+    // weight rows; the int32 sums are rescaled in the epilogue. Template
+    // arguments as in forward_into().
+    template <int IN_C = 0, int H = 0, int W = 0>
+    void forward_int8(const float* input, int N, int H_in, int W_in, float* output, Arena& arena,
+                      bool relu = false, const float* residual = nullptr) const {
+        int H_out = out_size(H_in);
+        int W_out = out_size(W_in);
+        int P = N * H_out * W_out;
+        int Hp = H_in + 2 * padding, Wp = W_in + 2 * padding;
+        const QuantizedMatrix& qw = quant.weights;
+        size_t arena_mark = arena.mark();
+        int16_t* nhwc = arena.alloc_as<int16_t>((size_t)N * Hp * Wp * in_channels);
+        quantize_nhwc_padded<IN_C, H, W>(input, N, in_channels, H_in, W_in, padding, quant.input_scale, nhwc);
+        int16_t* rows = nhwc;
+        if (!direct_int8()) {
+            rows = arena.alloc_as<int16_t>((size_t)P * qw.stride);
+            bool lowered = false;
+            if constexpr (H && W) {
+                lowered = same_geometry(3);
+                if (lowered) im2row_nhwc_same<3, H, W, IN_C>(nhwc, N, in_channels, rows, qw.stride);
+            }
+            if (!lowered)
+                im2row_nhwc(nhwc, N, in_channels, Hp, Wp, kernel_size, stride, H_out, W_out, rows, qw.stride);
+        }
+        quantized_matmul(qw, rows, P, H_out * W_out, quant.input_scale, has_bias ? bias.data() : nullptr,
+                         output, relu, residual);
+        arena.release(arena_mark);
+    }
+
+    // Direct convolution, kept as the reference the GEMM path is tested against
+    Tensor forward_reference(const Tensor& input) {
+        // Input: [N, C_in, H_in, W_in]
+        int N = input.shape[0];
 
         // Padding
         Tensor padded_input = pad_tensor(input, padding);
@@ -75,9 +259,10 @@ public:
 
         Tensor output({N, out_channels, H_out, W_out});
 
-        for (int n = 0; n < N; ++n) {
-            for (int oc = 0; oc < out_channels; ++oc) {
-                float b_val = has_bias ? bias[oc] : 0.0f;
+        // Output channel outermost: its weights stay in cache across the whole batch
+        for (int oc = 0; oc < out_channels; ++oc) {
+            float b_val = has_bias ? bias[oc] : 0.0f;
+            for (int n = 0; n < N; ++n) {
                 for (int h_out = 0; h_out < H_out; ++h_out) {
                     for (int w_out = 0; w_out < W_out; ++w_out) {
                         float sum = 0.0f;
@@ -104,52 +289,119 @@ public:
         }
         return output;
     }
+
+private:
+    bool direct_gemm(int N) const { return kernel_size == 1 && stride == 1 && padding == 0 && N == 1; }
+    bool direct_int8() const {
+        return kernel_size == 1 && stride == 1 && padding == 0 && quant_stride(in_channels) == in_channels;
+    }
+
+    // Stride-1 k x k convolution padded to keep the plane size
+    bool same_geometry(int k) const { return kernel_size == k && stride == 1 && padding == k / 2; }
+
+    int winograd_tile() const { return algo == CONV_WINOGRAD_4X4 ? 4 : 2; }
+
+    void prepare_weights() {
+        winograd_weights.clear();
+        quant.weights.clear();
+        if (algo == CONV_GEMM || weight.empty()) return;
+        if (algo == CONV_INT8) {
+            // Rows in (kh, kw, c) order to match the channels-last patches
+            int kk = kernel_size * kernel_size;
+            std::vector<float> hwc(weight.size());
+            for (int oc = 0; oc < out_channels; ++oc)
+                for (int ic = 0; ic < in_channels; ++ic)
+                    for (int t = 0; t < kk; ++t)
+                        hwc[((size_t)oc * kk + t) * in_channels + ic] = weight[(oc * in_channels + ic) * kk + t];
+            quant.weights.quantize(hwc.data(), out_channels, in_channels * kk);
+            return;
+        }
+        auto transform = (algo == CONV_WINOGRAD_4X4) ? winograd_transform_weights<4> : winograd_transform_weights<2>;
+        winograd_weights = transform(weight.data(), out_channels, in_channels);
+    }
 };
 
 // Linear (Fully Connected) Layer
 class Linear {
 public:
-    Tensor weight;
-    Tensor bias;
+    Parameter weight; // [out_features, in_features]
+    Parameter bias;   // [out_features]
     int in_features;
     int out_features;
 
+    bool int8 = false; // Quantized weights and activations, see set_int8()
+    QuantState quant;
+
     Linear(int in_f, int out_f) : in_features(in_f), out_features(out_f) {}
 
+    std::vector<int> weight_shape() const { return {out_features, in_features}; }
+
     void load_weights(const std::vector<float>& w_data, const std::vector<float>& b_data) {
-        weight = Tensor({out_features, in_features}, w_data);
-        bias = Tensor({out_features}, b_data);
+        set_weights(Parameter(weight_shape(), w_data), Parameter({out_features}, b_data));
+    }
+
+    // Takes parameters of weight_shape() and [out_features], owned or views
+    void set_weights(Parameter w, Parameter b) {
+        assert(w.shape == weight_shape() && b.shape == std::vector<int>{out_features});
+        weight = std::move(w);
+        bias = std::move(b);
+        if (int8) quant.weights.quantize(weight.data(), out_features, in_features);
+    }
+
+    // Switch to int8 weights and activations; false if the input scale is
+    // not calibrated yet
+    bool set_int8(bool on) {
+        if (on && !quant.calibrated()) return false;
+        int8 = on;
+        if (on) quant.weights.quantize(weight.data(), out_features, in_features);
+        else quant.weights.clear();
+        return true;
+    }
+
+    // Arena floats forward_into() needs for a batch of N
+    size_t workspace(int N) const {
+        return int8 ? quant_rows_floats(N, quant_stride(in_features)) : 0;
     }
 
     Tensor forward(const Tensor& input) {
-        // Input: [N, in_features]
         int N = input.shape[0];
         Tensor output({N, out_features});
+        Arena arena(workspace(N));
+        forward_into(input.data.data(), N, output.data.data(), arena);
+        return output;
+    }
 
-        for (int n = 0; n < N; ++n) {
-            for (int out_f = 0; out_f < out_features; ++out_f) {
-                float sum = bias[out_f];
-                for (int in_f = 0; in_f < in_features; ++in_f) {
-                    // Linear: y = xA^T + b => weight is [out, in]
-                    // input index: n*in_features + in_f
-                    // weight index: out_f*in_features + in_f
-                    sum += input[n * in_features + in_f] * weight[out_f * in_features + in_f];
-                }
-                output[n * out_features + out_f] = sum;
+    // [N, in_features] -> [N, out_features], with ReLU fused if `relu`
+    void forward_into(const float* input, int N, float* output, Arena& arena, bool relu = false) const {
+        quant.observe(input, (size_t)N * in_features);
+        if (int8) {
+            const QuantizedMatrix& qw = quant.weights;
+            size_t arena_mark = arena.mark();
+            int16_t* rows = arena.alloc_as<int16_t>((size_t)N * qw.stride);
+            quantize_rows(input, N, in_features, qw.stride, quant.input_scale, rows);
+            quantized_matmul(qw, rows, N, 1, quant.input_scale, bias.data(), output, relu);
+            arena.release(arena_mark);
+            return;
+        }
+
+        // Linear: y = xA^T + b => weight is [out, in], so every output is a
+        // dot product of a weight row with an input row. Each weight row stays
+        // in L1 while it is applied to the whole batch.
+        const SimdKernels& k = simd_kernels();
+        for (int out_f = 0; out_f < out_features; ++out_f) {
+            const float* w_row = weight.data() + (size_t)out_f * in_features;
+            for (int n = 0; n < N; ++n) {
+                float y = bias[out_f] + k.dot(input + n * in_features, w_row, in_features);
+                output[n * out_features + out_f] = (relu && y < 0.0f) ? 0.0f : y;
             }
         }
-        return output;
     }
 };
 
 // ReLU
 inline Tensor relu(const Tensor& input) {
     Tensor output = input;
-    for (size_t i = 0; i < output.data.size(); ++i) {
-        if (output.data[i] < 0) {
-            output.data[i] = 0.0f;
-        }
-    }
+    simd_kernels().relu(output.data.data(), output.size());
     return output; // Copy elision
 }
 
@@ -178,19 +430,49 @@ public:
         conv2->load_weights(w2, b2);
     }
 
+    // Arena floats forward_into() needs besides its buffers
+    size_t workspace(int N, int H, int W) const {
+        return std::max(conv1->workspace(N, H, W), conv2->workspace(N, H, W));
+    }
+
     Tensor forward(const Tensor& x) {
-        Tensor residual = x;
-        Tensor out = conv1->forward(x);
-        out = relu(out); // ReLU after first conv
-        out = conv2->forward(out);
-        
-        // Add residual
-        for (size_t i = 0; i < out.data.size(); ++i) {
-            out.data[i] += residual.data[i];
-        }
-        
-        return relu(out); // Final ReLU
+        int N = x.shape[0], H = x.shape[2], W = x.shape[3];
+        Tensor tmp(x.shape), out(x.shape);
+        Arena arena(workspace(N, H, W));
+        forward_into(x.data.data(), N, H, W, tmp.data.data(), out.data.data(), arena);
+        return out;
+    }
+
+    // out = relu(conv2(relu(conv1(x))) + x), with the ReLUs and the residual
+    // add fused into the convolutions' epilogues. `tmp` holds the inner
+    // activation; the three buffers must be distinct. Nonzero C, H_C and W_C
+    // fix the channel count and plane size, as in Conv2d::forward_into().
+    template <int C = 0, int H_C = 0, int W_C = 0>
+    void forward_into(const float* x, int N, int H, int W, float* tmp, float* out, Arena& arena) const {
+        conv1->forward_into<C, C, H_C, W_C>(x, N, H, W, tmp, arena, true);
+        conv2->forward_into<C, C, H_C, W_C>(tmp, N, H, W, out, arena, true, x);
     }
 };
 
+// Head: 1x1 conv + ReLU -> flatten -> Linear (+ ReLU if `relu`). The conv's
+// epilogue applies the ReLU while it writes the [N, C, H, W] activation,
+// which is already the flattened [N, C*H*W] input of the Linear, so the
+// hidden activation is written once and read once, straight from cache.
+inline size_t conv_relu_linear_workspace(const Conv2d& conv, const Linear& fc, int N, int H, int W) {
+    return Arena::rounded((size_t)N * conv.out_channels * conv.out_size(H) * conv.out_size(W)) +
+           std::max(conv.workspace(N, H, W), fc.workspace(N));
+}
+
+// Nonzero IN_C, H_C and W_C are passed on to Conv2d::forward_into().
+template <int IN_C = 0, int H_C = 0, int W_C = 0>
+void conv_relu_linear(const Conv2d& conv, const Linear& fc, const float* input, int N, int H, int W,
+                      float* output, Arena& arena, bool relu = false) {
+    assert(fc.in_features == conv.out_channels * conv.out_size(H) * conv.out_size(W));
+    size_t arena_mark = arena.mark();
+    float* hidden = arena.alloc((size_t)N * fc.in_features);
+    conv.forward_into<IN_C, 0, H_C, W_C>(input, N, H, W, hidden, arena, true);
+    fc.forward_into(hidden, N, output, arena, relu);
+    arena.release(arena_mark);
+}
+
 #endif // LAYERS_H
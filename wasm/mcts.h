@@ -3,33 +3,130 @@
 
 #include "game.h"
 #include "model.h"
+#include "ttable.h"
+#include "evalcache.h"
 #include <unordered_map>
+#include <vector>
+#include <algorithm>
 #include <cmath>
 #include <random>
 #include <iostream>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <climits>
 
-struct Node
+// Whether a network with architecture `arch` reads this game's encoded
+// planes and scores its actions, as the search requires
+inline bool network_fits_game(const ModelArch &arch)
 {
-    std::unordered_map<int, float> P; // Action -> Prob
-    std::unordered_map<int, int> N;   // Action -> Visits
-    std::unordered_map<int, float> W; // Action -> Total Value
+    return arch.board_size == BOARD_SIZE && arch.input_channels == ENCODED_PLANES &&
+           arch.move_actions == BOARD_SIZE * BOARD_SIZE * BOARD_SIZE * BOARD_SIZE && arch.tile_actions == NUM_TILES;
+}
 
-    // Add simple terminal flag or value if needed, but handled by expand return
+// When a search stops: after `simulations`, once `time_ms` of wall-clock
+// time has passed (0 = no budget), or, with `early_stop`, as soon as the
+// most visited root move can no longer be overtaken in the simulations
+// still to come
+struct SearchLimits
+{
+    int simulations = INT_MAX;
+    double time_ms = 0.0;
+    bool early_stop = false;
+
+    static SearchLimits count(int simulations)
+    {
+        SearchLimits l;
+        l.simulations = simulations;
+        return l;
+    }
+
+    // A budget of `ms` with early stopping, capped at `max_simulations`
+    static SearchLimits timed(double ms, int max_simulations = INT_MAX)
+    {
+        SearchLimits l;
+        l.simulations = max_simulations;
+        l.time_ms = ms;
+        l.early_stop = true;
+        return l;
+    }
+};
+
+// What the last search did
+struct SearchReport
+{
+    int simulations = 0;
+    double elapsed_ms = 0.0;
+    bool stopped_early = false; // The best root move was decided before the limits ran out
 };
 
 class MCTS
 {
 public:
     ContrastDualPolicyNet *network;
-    std::unordered_map<uint64_t, Node> nodes;
+
+    // Bounded tree storage. Nodes and edges are referenced by index, never by
+    // pointer: the pools are compacted by collect() between simulations.
+    TranspositionTable tree;
 
     float c_puct = 2.5f; // From config
     float dirichlet_alpha = 0.3f;
     float dirichlet_epsilon = 0.25f;
 
+    // Batched search: leaves collected per network call (1 = plain sequential search)
+    int batch_size = 1;
+    // Value charged to every edge on an in-flight path so the other leaves of
+    // a batch spread over different branches; refunded on backup
+    float virtual_loss = 1.0f;
+    // Tree-parallel search: threads sharing the tree (1 = no extra threads)
+    int num_threads = 1;
+    // Network evaluations shared across searches and games (not owned; none
+    // if null). It must be cleared whenever the network's weights change.
+    EvalCache *eval_cache = nullptr;
+
     std::mt19937 rng;
 
-    MCTS(ContrastDualPolicyNet *net) : network(net)
+    // A leaf waiting for its network evaluation
+    struct PendingLeaf
+    {
+        ContrastGame game;                          // Position at the leaf
+        uint64_t key;
+        ActionList legal_actions;
+        std::vector<std::pair<uint32_t, int>> path; // (node, edge offset) from the root down
+    };
+    std::vector<PendingLeaf> pending;
+    std::vector<int> batch_misses; // Pending leaves the evaluation cache did not have
+    std::vector<UndoRecord> undo_stack;
+
+    // Network input, output and scratch, reused from one evaluation to the
+    // next so a warmed-up search allocates nothing per call
+    struct Evaluator
+    {
+        std::vector<float> input;
+        ContrastDualPolicyNet::Output out;
+        Arena arena;
+        float cached_move_logits[BOARD_SIZE * BOARD_SIZE * BOARD_SIZE * BOARD_SIZE]; // Filled by a cache hit
+        float cached_tile_logits[NUM_TILES];
+
+        // Input planes for a batch of n positions
+        float *batch(int n)
+        {
+            if (input.size() < (size_t)n * ENCODED_STATE_SIZE)
+                input.resize((size_t)n * ENCODED_STATE_SIZE);
+            return input.data();
+        }
+    };
+    Evaluator evaluator;
+    std::vector<Evaluator> thread_evaluators; // One per worker of search_parallel()
+
+    SearchReport last_search;
+
+    // Makes a running search stop at its next check (see stop_pondering())
+    std::atomic<bool> stop_requested{false};
+    std::thread ponder_thread;
+    std::atomic<bool> ponder_running{false}; // Cleared when the background search returns
+
+    MCTS(ContrastDualPolicyNet *net, size_t tt_megabytes = 32) : network(net), tree(tt_megabytes)
     {
         rng.seed(std::random_device{}());
     }
@@ -41,55 +138,338 @@ public:
         return game.get_board_hash() ^ (game.move_count * 987654321ULL);
     }
 
-    void search(const ContrastGame &root_game, int num_simulations)
+    uint32_t find_node(uint64_t key)
+    {
+        return tree.find(key);
+    }
+
+    void clear()
+    {
+        tree.clear();
+    }
+
+    // Runs `num_simulations` simulations from `root_game`
+    int search(const ContrastGame &root_game, int num_simulations)
+    {
+        return search(root_game, SearchLimits::count(num_simulations));
+    }
+
+    // Runs simulations until `limits` stop the search and returns how many
+    // ran (also in last_search). Expanding a new root is not counted.
+    int search(const ContrastGame &root_game, const SearchLimits &limits)
+    {
+        begin_search(root_game);
+        int done = continue_search(limits);
+        end_search();
+        return done;
+    }
+
+    // --- Resumable search ---
+    // begin_search() expands the root and adds its Dirichlet noise once;
+    // each continue_search() then runs more simulations on the same tree, so
+    // a caller can search in chunks and read the best move, value and
+    // principal variation in between. The session ends with end_search(), or
+    // with advance() since the root may not survive the re-rooting.
+    struct SearchSession
+    {
+        ContrastGame root;
+        uint64_t root_key = 0;
+        bool active = false;
+        int simulations = 0;     // Over every continue_search() so far
+        double elapsed_ms = 0.0; // Time spent inside them
+        SearchLimits limits;     // For the whole session, from begin_search()
+        bool stopped_early = false;
+    };
+    SearchSession session;
+
+    // Starts a session at `root_game`. Returns false if the root has no
+    // moves, in which case continue_search() does nothing. Without
+    // `root_noise` the root keeps the network's priors (pondering).
+    bool begin_search(const ContrastGame &root_game, bool root_noise = true,
+                      const SearchLimits &limits = SearchLimits())
     {
-        uint64_t root_key = get_key(root_game);
+        last_search = SearchReport();
+        session.root = root_game.copy();
+        session.root_key = get_key(root_game);
+        session.active = true;
+        session.simulations = 0;
+        session.elapsed_ms = 0.0;
+        session.limits = limits;
+        session.stopped_early = false;
+        tree.new_generation();
 
         // Expand root if needed
-        if (nodes.find(root_key) == nodes.end())
+        uint64_t root_key = session.root_key;
+        uint32_t root = find_node(root_key);
+        if (root == NO_NODE)
         {
+            if (!tree.can_insert())
+                tree.collect(root_key);
             expand(root_game);
+            root = find_node(root_key);
         }
+        if (root == NO_NODE)
+            return false;
 
         // Add noise to root
-        auto &root_node = nodes[root_key];
-        if (root_node.P.empty())
-            return;
+        Node &root_node = tree.node(root);
+        root_node.generation = tree.generation;
+        if (root_node.num_edges == 0)
+            return false;
+        if (!root_noise)
+            return true;
 
-        std::vector<int> actions;
-        for (auto &kv : root_node.P)
-            actions.push_back(kv.first);
+        Edge *edges = tree.edges_of(root_node);
+        int num_edges = root_node.num_edges;
 
         // Dirichlet noise (approximate)
         std::gamma_distribution<float> gamma(dirichlet_alpha, 1.0f);
-        std::vector<float> noise;
+        std::vector<float> noise(num_edges);
         float noise_sum = 0;
-        for (size_t i = 0; i < actions.size(); ++i)
+        for (int i = 0; i < num_edges; ++i)
         {
-            float n = gamma(rng);
-            noise.push_back(n);
-            noise_sum += n;
+            noise[i] = gamma(rng);
+            noise_sum += noise[i];
         }
 
-        for (size_t i = 0; i < actions.size(); ++i)
+        for (int i = 0; i < num_edges; ++i)
         {
-            int a = actions[i];
             float n_val = noise[i] / noise_sum;
-            root_node.P[a] = (1 - dirichlet_epsilon) * root_node.P[a] + dirichlet_epsilon * n_val;
+            edges[i].prior = (1 - dirichlet_epsilon) * edges[i].prior + dirichlet_epsilon * n_val;
+        }
+        sort_edges(edges, num_edges);
+        return true;
+    }
+
+    // Runs `num_simulations` more simulations of the current session, fewer
+    // if the session's limits run out first
+    int continue_search(int num_simulations)
+    {
+        const SearchLimits &l = session.limits;
+        SearchLimits chunk = SearchLimits::count(std::min(num_simulations, std::max(l.simulations - session.simulations, 0)));
+        if (l.time_ms > 0.0)
+        {
+            chunk.time_ms = l.time_ms - session.elapsed_ms;
+            if (chunk.time_ms <= 0.0)
+                chunk.simulations = 0;
         }
+        return continue_search(chunk);
+    }
+
+    // Runs simulations of the current session until `limits` stop them and
+    // returns how many ran (also in last_search); 0 without a session
+    int continue_search(const SearchLimits &limits)
+    {
+        SearchControl control(limits);
+        last_search = SearchReport();
+        uint64_t root_key = session.root_key;
+        if (!session.active)
+            return report_search(control, 0);
+        uint32_t root = find_node(root_key);
+        if (root == NO_NODE || tree.node(root).num_edges == 0)
+            return report_search(control, 0);
 
-        // Simulations
-        for (int i = 0; i < num_simulations; ++i)
+        // One scratch game per call; evaluate() walks it down and back up with make/unmake
+        if (num_threads > 1)
+            return report_search(control, search_parallel(session.root, root_key, control));
+        ContrastGame scratch = session.root.copy();
+        if (batch_size > 1)
+            return report_search(control, search_batched(scratch, root_key, control));
+        int done = 0;
+        while (!control.should_stop(*this, root_key, done))
         {
-            ContrastGame scratch = root_game.copy();
+            // A simulation adds at most one node; make room while no indices are held
+            if (!tree.can_insert())
+                tree.collect(root_key);
             evaluate(scratch);
+            done++;
         }
+        return report_search(control, done);
     }
 
-    float evaluate(ContrastGame &game)
+    // Closes the session; the tree keeps its visits for the next search
+    void end_search()
     {
-        uint64_t key = get_key(game);
+        session.active = false;
+    }
+
+    // Whether a session searched in chunks should end: its limits from
+    // begin_search() are used up, or with early_stop its best root move can
+    // no longer be overtaken within them (which sets session.stopped_early),
+    // as a single search() with those limits would decide
+    bool session_done()
+    {
+        const SearchLimits &l = session.limits;
+        if (!session.active || session.simulations >= l.simulations)
+            return true;
+        if (l.time_ms > 0.0 && session.elapsed_ms >= l.time_ms)
+            return true;
+        if (!l.early_stop || session.simulations == 0)
+            return false;
+        if (root_visit_gap(session.root_key) > SearchControl::simulations_left(l, session.simulations, session.elapsed_ms))
+            session.stopped_early = true;
+        return session.stopped_early;
+    }
+
+    // --- Pondering ---
+    // Searches the opponent's position on a background thread while they
+    // think. The root gets no noise: the aim is to predict their reply. When
+    // it is played, advance() keeps its subtree, so the next search starts
+    // from the visits gathered meanwhile. Every other call on this object
+    // must wait for stop_pondering(); the thread owns the tree until then.
+
+    // Stop pondering after this many simulations, so an idle opponent does
+    // not keep a core busy and the tree collecting forever
+    int ponder_limit = 50000;
+
+    void start_pondering(const ContrastGame &game)
+    {
+        stop_pondering();
+        if (game.game_over || !begin_search(game, false))
+        {
+            end_search();
+            return;
+        }
+        ponder_running.store(true, std::memory_order_release);
+        ponder_thread = std::thread([this]
+                                    { continue_search(SearchLimits::count(ponder_limit));
+                                      ponder_running.store(false, std::memory_order_release); });
+    }
+
+    bool is_pondering() const { return ponder_thread.joinable(); }
+
+    // False once the background search has stopped by itself (ponder_limit
+    // reached); it still counts as pondering until stop_pondering()
+    bool ponder_searching() const { return ponder_running.load(std::memory_order_acquire); }
+
+    // Interrupts the background search (within one simulation or batch) and
+    // waits for it. Its visits stay in the tree.
+    void stop_pondering()
+    {
+        if (!ponder_thread.joinable())
+            return;
+        stop_requested.store(true, std::memory_order_relaxed);
+        ponder_thread.join();
+        stop_requested.store(false, std::memory_order_relaxed);
+        end_search();
+    }
 
+    ~MCTS()
+    {
+        stop_pondering();
+    }
+
+    // Most visited line from `game`, at most `max_length` actions, stopping
+    // at the first unvisited node
+    std::vector<int> principal_variation(const ContrastGame &game, int max_length)
+    {
+        std::vector<int> pv;
+        ContrastGame scratch = game.copy();
+        while ((int)pv.size() < max_length && !scratch.game_over)
+        {
+            uint32_t node_idx = tree.probe(get_key(scratch));
+            if (node_idx == NO_NODE)
+                break;
+            int best = most_visited_edge(tree.node(node_idx));
+            if (best < 0)
+                break;
+            int action = tree.edges_of(tree.node(node_idx))[best].action;
+            pv.push_back(action);
+            scratch.step(action);
+        }
+        return pv;
+    }
+
+    // Decides when a search stops. The clock is read once per simulation (or
+    // batch) and the root's edges are scanned only under a time budget or
+    // early stopping, both small next to a network call. Safe to share
+    // between the search_parallel() workers.
+    class SearchControl
+    {
+    public:
+        explicit SearchControl(const SearchLimits &limits) : limits(limits), start(Clock::now()) {}
+
+        double elapsed_ms() const { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); }
+
+        // Simulations still allowed after `done`
+        int remaining(int done) const { return std::max(limits.simulations - done, 0); }
+
+        bool should_stop(const MCTS &mcts, uint64_t root_key, int done)
+        {
+            if (done >= limits.simulations || mcts.stop_requested.load(std::memory_order_relaxed))
+                return true;
+            double elapsed = 0.0;
+            if (limits.time_ms > 0.0)
+            {
+                elapsed = elapsed_ms();
+                if (elapsed >= limits.time_ms)
+                    return true;
+            }
+            if (!limits.early_stop || done == 0)
+                return false;
+
+            if (mcts.root_visit_gap(root_key) > simulations_left(limits, done, elapsed))
+            {
+                __atomic_store_n(&stopped_early, true, __ATOMIC_RELAXED);
+                return true;
+            }
+            return false;
+        }
+
+        // Simulations the rest of `limits` allows after `done` in `elapsed`
+        // ms, at the rate so far
+        static double simulations_left(const SearchLimits &limits, int done, double elapsed)
+        {
+            double left = std::max(limits.simulations - done, 0);
+            if (limits.time_ms > 0.0 && elapsed > 0.0)
+                left = std::min(left, done / elapsed * (limits.time_ms - elapsed));
+            return left;
+        }
+
+        const SearchLimits limits;
+        bool stopped_early = false;
+
+    private:
+        using Clock = std::chrono::steady_clock;
+        Clock::time_point start;
+    };
+
+    int report_search(const SearchControl &control, int simulations)
+    {
+        last_search.simulations = simulations;
+        last_search.elapsed_ms = control.elapsed_ms();
+        last_search.stopped_early = control.stopped_early;
+        session.simulations += simulations;
+        session.elapsed_ms += last_search.elapsed_ms;
+        return simulations;
+    }
+
+    // Visits by which the most visited root edge leads the runner-up (all of
+    // its visits if it is the only edge); 0 without a root
+    int root_visit_gap(uint64_t root_key) const
+    {
+        uint32_t root = tree.probe(root_key);
+        if (root == NO_NODE)
+            return 0;
+        const Node &node = tree.node(root);
+        const Edge *edges = tree.edges_of(node);
+        int first = 0, second = 0;
+        for (uint32_t i = 0; i < node.num_edges; ++i)
+        {
+            int v = load_relaxed(edges[i].visits);
+            if (v > first)
+            {
+                second = first;
+                first = v;
+            }
+            else if (v > second)
+                second = v;
+        }
+        return first - second;
+    }
+
+    float evaluate(ContrastGame &game)
+    {
         // 1. Game Over
         if (game.game_over)
         {
@@ -99,154 +479,638 @@ public:
         }
 
         // 2. Expand if new
-        if (nodes.find(key) == nodes.end())
+        uint32_t node_idx = find_node(get_key(game));
+        if (node_idx == NO_NODE)
         {
             return expand(game);
         }
 
-        // 3. Selection (PUCT)
-        Node &node = nodes[key];
-        if (node.P.empty())
+        // 3. Selection (PUCT): linear scan over the node's edge span
+        Node &node = tree.node(node_idx);
+        node.generation = tree.generation;
+        if (node.num_edges == 0)
             return 0.0f; // Should not happen unless no legal moves but not game over?
 
-        float sqrt_sum_n = 0;
-        int sum_n = 0;
-        for (auto &kv : node.N)
-            sum_n += kv.second;
-        sqrt_sum_n = std::sqrt((float)sum_n);
+        int best = select_edge(node);
+        int action = tree.edges_of(node)[best].action;
+
+        // 4. Step
+        UndoRecord undo = game.make(action);
+        float v = -evaluate(game);
+        game.unmake(undo);
+
+        // 5. Backup (no collection runs mid-simulation, so the index is still valid)
+        Node &parent = tree.node(node_idx);
+        Edge &edge = tree.edges_of(parent)[best];
+        parent.visits++;
+        edge.visits++;
+        edge.value_sum += v;
+
+        return v;
+    }
+
+    // PUCT: linear scan over the node's edge span, returns the edge offset
+    int select_edge(const Node &node)
+    {
+        // Relaxed loads: other search threads may be updating these counters
+        float sqrt_sum_n = std::sqrt((float)load_relaxed(node.visits));
+        const Edge *edges = tree.edges_of(node);
 
-        int best_a = -1;
+        int best = -1;
         float best_score = -1e9f;
 
-        for (auto &kv : node.P)
+        for (uint32_t i = 0; i < node.num_edges; ++i)
         {
-            int a = kv.first;
-            float p = kv.second;
-            int n = node.N[a];
-            float w = node.W[a];
-
-            float q = (n > 0) ? (w / n) : 0.0f;
-            float u = c_puct * p * sqrt_sum_n / (1.0f + n);
+            const Edge &e = edges[i];
+            int visits = load_relaxed(e.visits);
+            float q = (visits > 0) ? (load_relaxed(e.value_sum) / visits) : 0.0f;
+            float u = c_puct * e.prior * sqrt_sum_n / (1.0f + visits);
 
             if (q + u > best_score)
             {
                 best_score = q + u;
-                best_a = a;
+                best = i;
             }
         }
+        return best;
+    }
 
-        // 4. Step
-        game.step(best_a);
-        float v = -evaluate(game);
+    float expand(const ContrastGame &game)
+    {
+        ActionList legal_actions;
+        game.generate_legal_actions(legal_actions);
+        const float *move_logits, *tile_logits;
+        float value = evaluate_position(game, legal_actions, evaluator, move_logits, tile_logits);
+        store_node(game, legal_actions, move_logits, tile_logits);
+        return value;
+    }
+
+    // Value and logits for `game`: from the evaluation cache when it has the
+    // position, else from one forward pass, which is then cached
+    float evaluate_position(const ContrastGame &game, const ActionList &legal_actions, Evaluator &eval,
+                            const float *&move_logits, const float *&tile_logits)
+    {
+        float value;
+        if (probe_cache(game, eval, value))
+        {
+            move_logits = eval.cached_move_logits;
+            tile_logits = eval.cached_tile_logits;
+            return value;
+        }
+        game.encode_state_into(eval.batch(1));
+        auto &out = eval.out;
+        network->forward(eval.input.data(), 1, out, eval.arena);
+        move_logits = out.move_logits.data.data();
+        tile_logits = out.tile_logits.data.data();
+        store_cache(game, legal_actions, move_logits, tile_logits, out.value);
+        return out.value;
+    }
 
-        // 5. Backup
-        node.N[best_a]++;
-        node.W[best_a] += v;
+    bool probe_cache(const ContrastGame &game, Evaluator &eval, float &value)
+    {
+        return eval_cache &&
+               eval_cache->probe(game.history_hash(), eval.cached_move_logits, eval.cached_tile_logits, value);
+    }
 
-        return v;
+    void store_cache(const ContrastGame &game, const ActionList &legal_actions, const float *move_logits,
+                     const float *tile_logits, float value)
+    {
+        if (eval_cache)
+            eval_cache->store(game.history_hash(), legal_actions, game.current_player == P2, move_logits,
+                              tile_logits, value);
     }
 
-    float expand(const ContrastGame &game)
+    // Create the node for `game` with priors from one row of network output
+    void store_node(const ContrastGame &game, const ActionList &legal_actions, const float *move_logits,
+                    const float *tile_logits)
     {
         uint64_t key = get_key(game);
 
-        // Inference
-        Tensor input = game.encode_state();
-        auto out = network->forward(input);
-        float value = out.value;
+        // Table full mid-simulation (cannot happen from a search, which makes room first): evaluate without storing
+        if (!tree.can_insert())
+            return;
 
-        auto &node = nodes[key]; // Create node
+        // Create node
+        uint32_t node_idx = tree.insert(key, legal_actions.size());
+        fill_edges(game, legal_actions, move_logits, tile_logits, tree.edges_of(tree.node(node_idx)));
+    }
 
-        auto legal_actions = game.get_all_legal_actions();
+    // Priors for the legal actions of `game`: softmax over the legal moves only
+    void fill_edges(const ContrastGame &game, const ActionList &legal_actions,
+                    const float *move_logits, const float *tile_logits, Edge *edges)
+    {
         if (legal_actions.empty())
         {
-            return value; // Should be handled by game_over, but safety
+            return; // Should be handled by game_over, but safety
         }
 
-        // Softmax policy for legal actions only
+        // Softmax policy for legal actions only. P2 sees the board rotated:
+        // its actions index the logits through the flip tables, chosen once
+        // so the gather has no per-action branch.
         bool should_flip = (game.current_player == P2);
+        int move_base = should_flip ? NUM_MOVES - 1 : 0;
+        int move_sign = should_flip ? -1 : 1;
+        const uint8_t *tile_map = should_flip ? ACTION_TABLES.tile_flipped : ACTION_TABLES.tile_same;
 
-        std::vector<float> logits;
-        float max_logit = -1e9f;
+        float logits[MAX_ACTIONS];
+        int num_actions = legal_actions.size();
 
-        for (int a : legal_actions)
+        for (int i = 0; i < num_actions; ++i)
         {
-            // Mapping logic from Python
-            int query_hash = should_flip ? flip_action(a) : a;
-            int move_idx = query_hash / 51; // NUM_TILES
-            int tile_idx = query_hash % 51;
+            int a = legal_actions[i];
+            int move_idx = a / NUM_TILES;
+            int tile_idx = a - move_idx * NUM_TILES;
+            logits[i] = move_logits[move_base + move_sign * move_idx] + tile_logits[tile_map[tile_idx]];
+        }
+        simd_kernels().softmax(logits, num_actions);
 
-            // Logits in tensor are flat 625 and 51
-            float m_l = out.move_logits.data[move_idx];
-            float t_l = out.tile_logits.data[tile_idx];
-            float combined = m_l + t_l;
+        // Store Probs, highest prior first so selection scans the likely edges first
+        uint16_t order[MAX_ACTIONS];
+        order_by_prior(logits, num_actions, order);
+        for (int i = 0; i < num_actions; ++i)
+        {
+            int j = order[i];
+            edges[i] = {legal_actions[j], logits[j], 0, 0.0f};
+        }
+    }
 
-            logits.push_back(combined);
-            if (combined > max_logit)
-                max_logit = combined;
+    // Indices of `priors` (all positive) from the highest prior down, ties in
+    // index order. The float bits of positive values order like the values,
+    // so their complement is an ascending integer key: short lists sort it
+    // with the index packed below, longer ones (the opening's hundreds of
+    // tile placements) take a byte-wise radix sort, which avoids the
+    // comparison sort's unpredictable branches.
+    static void order_by_prior(const float *priors, int n, uint16_t *order)
+    {
+        uint32_t keys[MAX_ACTIONS];
+        for (int i = 0; i < n; ++i)
+        {
+            uint32_t bits;
+            std::memcpy(&bits, &priors[i], sizeof(bits));
+            keys[i] = ~bits;
         }
 
-        // Exp & Sum
-        float sum_exp = 0.0f;
-        for (float &l : logits)
+        if (n < 64)
         {
-            l = std::exp(l - max_logit);
-            sum_exp += l;
+            uint64_t packed[64];
+            for (int i = 0; i < n; ++i)
+                packed[i] = (uint64_t)keys[i] << 32 | (uint32_t)i;
+            std::sort(packed, packed + n);
+            for (int i = 0; i < n; ++i)
+                order[i] = (uint16_t)packed[i];
+            return;
         }
 
-        // Store Probs
-        for (size_t i = 0; i < legal_actions.size(); ++i)
+        uint32_t count[4][256] = {};
+        for (int i = 0; i < n; ++i)
+            for (int p = 0; p < 4; ++p)
+                count[p][keys[i] >> (8 * p) & 255]++;
+
+        uint16_t scratch[MAX_ACTIONS];
+        uint16_t *src = order, *dst = scratch;
+        for (int i = 0; i < n; ++i)
+            order[i] = i;
+        for (int p = 0; p < 4; ++p)
         {
-            node.P[legal_actions[i]] = logits[i] / sum_exp;
-            node.N[legal_actions[i]] = 0;
-            node.W[legal_actions[i]] = 0;
+            if (count[p][keys[0] >> (8 * p) & 255] == (uint32_t)n)
+                continue; // Every key has the same byte here
+            uint32_t sum = 0;
+            for (int d = 0; d < 256; ++d)
+            {
+                uint32_t c = count[p][d];
+                count[p][d] = sum;
+                sum += c;
+            }
+            for (int i = 0; i < n; ++i)
+            {
+                int j = src[i];
+                dst[count[p][keys[j] >> (8 * p) & 255]++] = j;
+            }
+            std::swap(src, dst);
         }
+        if (src != order)
+            std::memcpy(order, src, n * sizeof(uint16_t));
+    }
 
-        return value;
+    // --- Batched search ---
+    // Each pass descends up to batch_size times with virtual loss applied to
+    // the edges taken, encodes the distinct unexpanded leaves into one
+    // (K, 66, 5, 5) tensor, runs a single forward pass and backs up all K.
+
+    int search_batched(ContrastGame &game, uint64_t root_key, SearchControl &control)
+    {
+        if ((int)pending.size() < batch_size)
+            pending.resize(batch_size);
+
+        int done = 0;
+        while (!control.should_stop(*this, root_key, done))
+        {
+            int want = std::min(batch_size, control.remaining(done));
+            if (!tree.can_insert(want))
+                tree.collect(root_key);
+
+            int queued = 0;
+            int finished = 0; // Terminal paths, backed up without the network
+            for (int attempt = 0; attempt < 2 * want && queued + finished < want; ++attempt)
+            {
+                float terminal_value;
+                switch (descend(game, queued, terminal_value))
+                {
+                case LEAF_QUEUED:
+                    queued++;
+                    break;
+                case LEAF_TERMINAL:
+                    backup(pending[queued].path, terminal_value);
+                    finished++;
+                    break;
+                case LEAF_COLLISION:
+                    revert(pending[queued].path);
+                    break;
+                }
+            }
+
+            if (queued + finished == 0)
+            {
+                // Every descent hit an in-flight leaf; fall back to one plain simulation
+                evaluate(game);
+                done++;
+                continue;
+            }
+
+            // Leaves the evaluation cache has are expanded at once; the rest
+            // share one forward pass
+            batch_misses.clear();
+            for (int i = 0; i < queued; ++i)
+            {
+                PendingLeaf &leaf = pending[i];
+                leaf.game.generate_legal_actions(leaf.legal_actions);
+                float value;
+                if (!probe_cache(leaf.game, evaluator, value))
+                {
+                    batch_misses.push_back(i);
+                    continue;
+                }
+                store_node(leaf.game, leaf.legal_actions, evaluator.cached_move_logits, evaluator.cached_tile_logits);
+                backup(leaf.path, value);
+            }
+
+            int misses = batch_misses.size();
+            if (misses > 0)
+            {
+                float *input = evaluator.batch(misses);
+                for (int i = 0; i < misses; ++i)
+                    pending[batch_misses[i]].game.encode_state_into(input + i * ENCODED_STATE_SIZE);
+
+                auto &out = evaluator.out;
+                network->forward(input, misses, out, evaluator.arena);
+                for (int i = 0; i < misses; ++i)
+                {
+                    PendingLeaf &leaf = pending[batch_misses[i]];
+                    const float *move_logits = &out.move_logits.data[i * 625];
+                    const float *tile_logits = &out.tile_logits.data[i * NUM_TILES];
+                    store_cache(leaf.game, leaf.legal_actions, move_logits, tile_logits, out.values[i]);
+                    store_node(leaf.game, leaf.legal_actions, move_logits, tile_logits);
+                    backup(leaf.path, out.values[i]);
+                }
+            }
+            done += queued + finished;
+        }
+        return done;
     }
 
-    int get_best_action(const ContrastGame &game)
+    enum LeafResult
     {
-        uint64_t key = get_key(game);
-        if (nodes.find(key) == nodes.end())
-            return -1;
+        LEAF_QUEUED,
+        LEAF_TERMINAL,
+        LEAF_COLLISION
+    };
 
-        Node &node = nodes[key];
-        int best_a = -1;
-        int max_n = -1;
+    // Walk from the root to a leaf, charging virtual loss on the way, and
+    // leave the game back at the root. The path goes to pending[slot].
+    LeafResult descend(ContrastGame &game, int slot, float &terminal_value)
+    {
+        PendingLeaf &leaf = pending[slot];
+        leaf.path.clear();
+        undo_stack.clear();
 
-        for (auto &kv : node.N)
+        LeafResult result;
+        while (true)
         {
-            if (kv.second > max_n)
+            if (game.game_over)
+            {
+                terminal_value = (game.winner == 0) ? 0.0f : (game.winner == game.current_player) ? 1.0f : -1.0f;
+                result = LEAF_TERMINAL;
+                break;
+            }
+
+            uint64_t key = get_key(game);
+            uint32_t node_idx = find_node(key);
+            if (node_idx == NO_NODE)
+            {
+                result = LEAF_QUEUED;
+                for (int i = 0; i < slot; ++i)
+                    if (pending[i].key == key)
+                        result = LEAF_COLLISION; // Already waiting in this batch
+                if (result == LEAF_QUEUED)
+                {
+                    leaf.game = game.copy();
+                    leaf.key = key;
+                }
+                break;
+            }
+
+            Node &node = tree.node(node_idx);
+            node.generation = tree.generation;
+            if (node.num_edges == 0)
             {
-                max_n = kv.second;
-                best_a = kv.first;
+                terminal_value = 0.0f;
+                result = LEAF_TERMINAL;
+                break;
             }
+
+            int best = select_edge(node);
+            Edge &edge = tree.edges_of(node)[best];
+            node.visits++;
+            edge.visits++;
+            edge.value_sum -= virtual_loss;
+            leaf.path.push_back({node_idx, best});
+            undo_stack.push_back(game.make(edge.action));
+        }
+
+        for (int i = (int)undo_stack.size() - 1; i >= 0; --i)
+            game.unmake(undo_stack[i]);
+        return result;
+    }
+
+    // `leaf_value` is from the point of view of the player to move at the leaf
+    void backup(const std::vector<std::pair<uint32_t, int>> &path, float leaf_value)
+    {
+        float v = leaf_value;
+        for (int i = (int)path.size() - 1; i >= 0; --i)
+        {
+            v = -v;
+            Edge &edge = tree.edges_of(tree.node(path[i].first))[path[i].second];
+            edge.value_sum += v + virtual_loss; // Visit was already counted on the way down
+        }
+    }
+
+    // Undo the virtual visits of a path that was not evaluated
+    void revert(const std::vector<std::pair<uint32_t, int>> &path)
+    {
+        for (auto &step : path)
+        {
+            Node &node = tree.node(step.first);
+            Edge &edge = tree.edges_of(node)[step.second];
+            node.visits--;
+            edge.visits--;
+            edge.value_sum += virtual_loss;
         }
-        return best_a;
+    }
+
+    // --- Tree-parallel search ---
+    // num_threads workers descend the shared tree concurrently. Visit counts
+    // and value sums are updated with relaxed atomics and virtual loss keeps
+    // the workers on different branches. A new node is claimed with
+    // insert_shared() before its network call, so every position is evaluated
+    // once; other workers reaching it before publish() back off and retry.
+
+    using Path = std::vector<std::pair<uint32_t, int>>;
+
+    int search_parallel(const ContrastGame &root_game, uint64_t root_key, SearchControl &control)
+    {
+        if ((int)thread_evaluators.size() < num_threads)
+            thread_evaluators.resize(num_threads);
+
+        int done = 0;
+        while (!control.should_stop(*this, root_key, done))
+        {
+            // Rounds end before the pools fill up, so collect() only ever runs
+            // while no worker holds indices. Nodes left dead by lost insert
+            // races also take slots, so a round keeps num_threads slots spare
+            // and ends early once they are reached; an insert that still finds
+            // the pools full just evaluates without storing.
+            if (!tree.can_insert(num_threads))
+                tree.collect(root_key);
+            int round = std::max<int>(1, std::min<int64_t>(control.remaining(done),
+                                                           (int64_t)tree.free_slots() - num_threads));
+
+            std::atomic<int> remaining(round);
+            std::atomic<int> completed(0);
+            std::atomic<bool> stop(false);
+            auto worker = [&](int t)
+            {
+                ContrastGame scratch = root_game.copy();
+                Path path;
+                std::vector<UndoRecord> undos;
+                while (!stop.load(std::memory_order_relaxed) && remaining.fetch_sub(1, std::memory_order_relaxed) > 0)
+                {
+                    simulate_shared(scratch, path, undos, thread_evaluators[t]);
+                    if (!tree.can_insert(num_threads))
+                        remaining.store(0, std::memory_order_relaxed);
+                    int total = done + completed.fetch_add(1, std::memory_order_relaxed) + 1;
+                    if (control.should_stop(*this, root_key, total))
+                        stop.store(true, std::memory_order_relaxed);
+                }
+            };
+
+            std::vector<std::thread> threads;
+            for (int t = 1; t < num_threads; ++t)
+                threads.emplace_back(worker, t);
+            worker(0);
+            for (auto &t : threads)
+                t.join();
+            done += completed.load();
+        }
+        return done;
+    }
+
+    // One simulation from the root of `game`, which is left unchanged
+    void simulate_shared(ContrastGame &game, Path &path, std::vector<UndoRecord> &undos, Evaluator &eval)
+    {
+        while (true)
+        {
+            path.clear();
+            undos.clear();
+            float leaf_value = 0.0f;
+            bool collision = false;
+
+            while (true)
+            {
+                if (game.game_over)
+                {
+                    leaf_value = (game.winner == 0) ? 0.0f : (game.winner == game.current_player) ? 1.0f : -1.0f;
+                    break;
+                }
+
+                uint64_t key = get_key(game);
+                uint32_t node_idx = tree.find_shared(key);
+                if (node_idx == NO_NODE)
+                {
+                    collision = !expand_shared(game, key, leaf_value, eval);
+                    break;
+                }
+                if (!tree.is_ready(node_idx))
+                {
+                    collision = true; // Another worker is expanding it
+                    break;
+                }
+
+                Node &node = tree.node(node_idx);
+                tree.touch(node_idx);
+                if (node.num_edges == 0)
+                    break;
+
+                int best = select_edge(node);
+                Edge &edge = tree.edges_of(node)[best];
+                add_relaxed(node.visits, 1);
+                add_relaxed(edge.visits, 1);
+                add_relaxed(edge.value_sum, -virtual_loss);
+                path.push_back({node_idx, best});
+                undos.push_back(game.make(edge.action));
+            }
+
+            for (int i = (int)undos.size() - 1; i >= 0; --i)
+                game.unmake(undos[i]);
+
+            if (!collision)
+            {
+                float v = leaf_value;
+                for (int i = (int)path.size() - 1; i >= 0; --i)
+                {
+                    v = -v;
+                    Edge &edge = tree.edges_of(tree.node(path[i].first))[path[i].second];
+                    add_relaxed(edge.value_sum, v + virtual_loss);
+                }
+                return;
+            }
+
+            for (auto &step : path)
+            {
+                Node &node = tree.node(step.first);
+                Edge &edge = tree.edges_of(node)[step.second];
+                add_relaxed(node.visits, -1);
+                add_relaxed(edge.visits, -1);
+                add_relaxed(edge.value_sum, virtual_loss);
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    // Claim, evaluate and publish the node for `game`. Returns false if
+    // another worker claimed it first. With the table full the position is
+    // evaluated without being stored.
+    bool expand_shared(const ContrastGame &game, uint64_t key, float &value, Evaluator &eval)
+    {
+        ActionList legal_actions;
+        game.generate_legal_actions(legal_actions);
+
+        bool owner;
+        uint32_t node_idx = tree.insert_shared(key, legal_actions.size(), owner);
+        if (node_idx != NO_NODE && !owner)
+            return false;
+
+        const float *move_logits, *tile_logits;
+        value = evaluate_position(game, legal_actions, eval, move_logits, tile_logits);
+        if (node_idx != NO_NODE)
+        {
+            fill_edges(game, legal_actions, move_logits, tile_logits, tree.edges_of(tree.node(node_idx)));
+            tree.publish(node_idx);
+        }
+        return true;
+    }
+
+    // Re-root after a real move: keep only the nodes reachable from `game`
+    // and free everything else in one compaction, so the next search starts
+    // from the played subtree's accumulated visits and memory stays flat.
+    void advance(const ContrastGame &game)
+    {
+        end_search();
+        std::vector<bool> keep(tree.size(), false);
+        uint32_t root = tree.probe(get_key(game));
+        if (root != NO_NODE)
+        {
+            ContrastGame scratch = game.copy();
+            mark_reachable(scratch, root, keep);
+        }
+        tree.compact(keep);
+    }
+
+    void mark_reachable(ContrastGame &game, uint32_t node_idx, std::vector<bool> &keep)
+    {
+        keep[node_idx] = true;
+        const Node &node = tree.node(node_idx);
+        const Edge *edges = tree.edges_of(node);
+
+        for (uint32_t i = 0; i < node.num_edges; ++i)
+        {
+            UndoRecord undo = game.make(edges[i].action);
+            uint32_t child = game.game_over ? NO_NODE : tree.probe(get_key(game));
+            if (child != NO_NODE && !keep[child])
+                mark_reachable(game, child, keep);
+            game.unmake(undo);
+        }
+    }
+
+    static void sort_edges(Edge *edges, int num_edges)
+    {
+        std::sort(edges, edges + num_edges, [](const Edge &a, const Edge &b)
+                  { return a.prior > b.prior; });
+    }
+
+    // Offset of the most visited edge of `node` (the first on ties), or -1
+    // if none has been visited
+    int most_visited_edge(const Node &node) const
+    {
+        const Edge *edges = tree.edges_of(node);
+        int best = -1;
+        int max_n = 0;
+
+        for (uint32_t i = 0; i < node.num_edges; ++i)
+        {
+            if (edges[i].visits > max_n)
+            {
+                max_n = edges[i].visits;
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    int get_best_action(const ContrastGame &game)
+    {
+        uint32_t node_idx = find_node(get_key(game));
+        if (node_idx == NO_NODE)
+            return -1;
+
+        const Node &node = tree.node(node_idx);
+        if (node.num_edges == 0)
+            return -1;
+        int best = most_visited_edge(node);
+        return tree.edges_of(node)[std::max(best, 0)].action; // Unsearched root: the highest prior
+    }
+
+    // Simulations already through `game`'s node, 0 if it is not in the tree
+    int get_root_visits(const ContrastGame &game)
+    {
+        uint32_t node_idx = find_node(get_key(game));
+        return node_idx == NO_NODE ? 0 : tree.node(node_idx).visits;
     }
 
     float get_root_value(const ContrastGame &game)
     {
-        uint64_t key = get_key(game);
-        if (nodes.find(key) == nodes.end())
+        uint32_t node_idx = find_node(get_key(game));
+        if (node_idx == NO_NODE)
             return 0.0f;
 
-        Node &node = nodes[key];
+        const Node &node = tree.node(node_idx);
+        const Edge *edges = tree.edges_of(node);
         float total_w = 0.0f;
         int total_n = 0;
 
-        for (auto &kv : node.N)
+        for (uint32_t i = 0; i < node.num_edges; ++i)
         {
-            int a = kv.first;
-            int n = kv.second;
-            float w = node.W[a]; // map lookup might be unsafe if not exists?
-            // in expand P is init, N/W are empty.
-            // but N is map int->int. implicitly 0.
-            // W is map int->float. implicitly 0.0.
-
-            total_n += n;
-            total_w += w;
+            total_n += edges[i].visits;
+            total_w += edges[i].value_sum;
         }
 
         if (total_n == 0)
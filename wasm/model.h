@@ -3,7 +3,9 @@
 
 #include "tensor.h"
 #include "layers.h"
-#include <fstream>
+#include "model_file.h"
+#include <memory>
+#include <string>
 #include <vector>
 #include <iostream>
 
@@ -29,160 +31,460 @@ public:
 
     int num_res_blocks;
 
-    ContrastDualPolicyNet(int blocks = 8) : num_res_blocks(blocks)
+    // Algorithm of the 3x3 backbone convolutions (conv_input and the residual
+    // blocks). Winograd weights are transformed when the weights are loaded.
+    ConvAlgo backbone_algo = CONV_WINOGRAD_2X2;
+
+    // Use the compiled fast path when the architecture has one (see
+    // FastPath below); off runs the generic path, for comparison
+    bool use_fast_path = true;
+
+    explicit ContrastDualPolicyNet(const ModelArch &arch)
     {
-        // Init Layers (shapes match export script)
-        // Input: 66 -> 64
-        conv_input = new Conv2d(66, 64, 3, 1, 1);
+        build(arch);
+    }
 
-        for (int i = 0; i < num_res_blocks; ++i)
+    // The shipped architecture with `blocks` residual blocks
+    explicit ContrastDualPolicyNet(int blocks = 8) : ContrastDualPolicyNet(arch_with_blocks(blocks)) {}
+
+    // Every 3x3 convolution of the backbone, in forward order
+    std::vector<Conv2d *> backbone_convs()
+    {
+        std::vector<Conv2d *> convs = {conv_input};
+        for (auto b : res_blocks)
         {
-            res_blocks.push_back(new ResidualBlock(64));
+            convs.push_back(b->conv1);
+            convs.push_back(b->conv2);
         }
+        return convs;
+    }
 
-        // Move: 64 -> 32 -> Flatten(800) -> 625
-        move_conv = new Conv2d(64, 32, 1, 1, 0);
-        move_fc = new Linear(32 * 5 * 5, 625);
-
-        // Tile: 64 -> 16 -> Flatten(400) -> 51
-        tile_conv = new Conv2d(64, 16, 1, 1, 0);
-        tile_fc = new Linear(16 * 5 * 5, 51);
-
-        // Value: 64 -> 4 -> Flatten(100) -> 32 -> 1
-        value_conv = new Conv2d(64, 4, 1, 1, 0);
-        value_fc1 = new Linear(4 * 5 * 5, 32);
-        value_fc2 = new Linear(32, 1);
+    // Takes effect once int8 is off, if it is on
+    void set_backbone_algorithm(ConvAlgo algo)
+    {
+        backbone_algo = algo;
+        if (int8)
+            return;
+        for (Conv2d *c : backbone_convs())
+            c->set_algorithm(algo);
     }
 
-    ~ContrastDualPolicyNet()
+    // Every layer, in forward order
+    std::vector<Conv2d *> convs()
     {
-        delete conv_input;
-        for (auto b : res_blocks)
-            delete b;
-        delete move_conv;
-        delete move_fc;
-        delete tile_conv;
-        delete tile_fc;
-        delete value_conv;
-        delete value_fc1;
-        delete value_fc2;
+        std::vector<Conv2d *> all = backbone_convs();
+        all.insert(all.end(), {move_conv, tile_conv, value_conv});
+        return all;
     }
+    std::vector<Linear *> linears() { return {move_fc, tile_fc, value_fc1, value_fc2}; }
+
+    // --- INT8 inference (quant.h) ---
+    // calibrate() runs fp32 forward passes over `count` encoded positions and
+    // sets every layer's input activation scale from the largest value seen.
+    // set_int8(true) then quantizes all weights per output channel; false
+    // restores fp32 with backbone_algo.
+
+    bool int8 = false;
 
-    // Helper to read vector from stream
-    std::vector<float> read_float_vector(std::ifstream &f)
+    bool int8_calibrated()
     {
-        int dims_len;
-        f.read(reinterpret_cast<char *>(&dims_len), sizeof(int));
-        std::vector<int> shape(dims_len);
-        f.read(reinterpret_cast<char *>(shape.data()), dims_len * sizeof(int));
+        for (Conv2d *c : convs())
+            if (!c->quant.calibrated())
+                return false;
+        for (Linear *l : linears())
+            if (!l->quant.calibrated())
+                return false;
+        return true;
+    }
 
-        int size = 1;
-        for (int s : shape)
-            size *= s;
-        std::vector<float> data(size);
-        f.read(reinterpret_cast<char *>(data.data()), size * sizeof(float));
-        return data; // RVO
+    void calibrate(const float *inputs, int count)
+    {
+        bool was_int8 = int8;
+        set_int8(false);
+        for (Conv2d *c : convs())
+            c->quant.begin_calibration();
+        for (Linear *l : linears())
+            l->quant.begin_calibration();
+
+        const int batch = 16;
+        Arena scratch;
+        Output out;
+        for (int i = 0; i < count; i += batch)
+            forward(inputs + (size_t)i * input_size(), std::min(batch, count - i), out, scratch);
+
+        for (Conv2d *c : convs())
+            c->quant.end_calibration();
+        for (Linear *l : linears())
+            l->quant.end_calibration();
+        set_int8(was_int8);
     }
 
-    void load_from_file(const std::string &path)
+    // Returns false (and stays fp32) if the network is not calibrated
+    bool set_int8(bool on)
     {
-        std::ifstream f(path, std::ios::binary);
-        if (!f.is_open())
-        {
-            std::cerr << "Failed to open model file: " << path << std::endl;
-            return;
-        }
+        if (on && !int8_calibrated())
+            return false;
+        int8 = on;
+        for (Conv2d *c : backbone_convs())
+            c->set_algorithm(on ? CONV_INT8 : backbone_algo);
+        for (Conv2d *c : {move_conv, tile_conv, value_conv})
+            c->set_algorithm(on ? CONV_INT8 : CONV_GEMM);
+        for (Linear *l : linears())
+            l->set_int8(on);
+        return true;
+    }
 
-        // Order matches export script
-        // 1. Input
-        auto w = read_float_vector(f);
-        auto b = read_float_vector(f);
-        conv_input->load_weights(w, b);
+    ContrastDualPolicyNet(const ContrastDualPolicyNet &) = delete;
+    ContrastDualPolicyNet &operator=(const ContrastDualPolicyNet &) = delete;
 
-        // 2. ResBlocks
-        for (int i = 0; i < num_res_blocks; ++i)
-        {
-            auto w1 = read_float_vector(f);
-            auto b1 = read_float_vector(f);
-            auto w2 = read_float_vector(f);
-            auto b2 = read_float_vector(f);
-            res_blocks[i]->load_weights(w1, b1, w2, b2);
-        }
+    ~ContrastDualPolicyNet()
+    {
+        destroy();
+    }
 
-        // 3. Move Head
-        auto mw = read_float_vector(f);
-        auto mb = read_float_vector(f);
-        move_conv->load_weights(mw, mb);
+    // Architecture the layers were built for; load_from_file() rebuilds them
+    // for the architecture of the file
+    const ModelArch &arch() const { return spec; }
 
-        auto mfc_w = read_float_vector(f);
-        auto mfc_b = read_float_vector(f);
-        move_fc->load_weights(mfc_w, mfc_b);
+    // Whether forward() runs a compiled fast path for this architecture
+    bool has_fast_path() const { return fast_forward != nullptr; }
 
-        // 4. Tile Head
-        auto tw = read_float_vector(f);
-        auto tb = read_float_vector(f);
-        tile_conv->load_weights(tw, tb);
+    // Name, weight shape and bias shape of every layer of `a`, in the order
+    // of model_layer_names()
+    struct LayerSpec
+    {
+        std::string name;
+        std::vector<int> weight_shape;
+        std::vector<int> bias_shape;
+    };
+
+    static std::vector<LayerSpec> layer_specs(const ModelArch &a)
+    {
+        std::vector<std::string> names = model_layer_names(a.res_blocks);
+        int area = a.board_size * a.board_size;
+        std::vector<LayerSpec> specs;
+        auto add = [&](std::vector<int> w, int out) { specs.push_back({names[specs.size()], w, {out}}); };
+        add({a.filters, a.input_channels, 3, 3}, a.filters);
+        for (int i = 0; i < 2 * a.res_blocks; ++i)
+            add({a.filters, a.filters, 3, 3}, a.filters);
+        add({a.move_head_filters, a.filters, 1, 1}, a.move_head_filters);
+        add({a.move_actions, a.move_head_filters * area}, a.move_actions);
+        add({a.tile_head_filters, a.filters, 1, 1}, a.tile_head_filters);
+        add({a.tile_actions, a.tile_head_filters * area}, a.tile_actions);
+        add({a.value_head_filters, a.filters, 1, 1}, a.value_head_filters);
+        add({a.value_hidden, a.value_head_filters * area}, a.value_hidden);
+        add({1, a.value_hidden}, 1);
+        return specs;
+    }
 
-        auto tfc_w = read_float_vector(f);
-        auto tfc_b = read_float_vector(f);
-        tile_fc->load_weights(tfc_w, tfc_b);
+    // The layer behind each model_layer_names() prefix, in the same order
+    struct NamedLayer
+    {
+        std::string name;
+        Conv2d *conv; // Exactly one of conv and fc is set
+        Linear *fc;
 
-        // 5. Value Head
-        auto vw = read_float_vector(f);
-        auto vb = read_float_vector(f);
-        value_conv->load_weights(vw, vb);
+        QuantState &quant() const { return conv ? conv->quant : fc->quant; }
+    };
 
-        auto vfc1_w = read_float_vector(f);
-        auto vfc1_b = read_float_vector(f);
-        value_fc1->load_weights(vfc1_w, vfc1_b);
+    std::vector<NamedLayer> named_layers()
+    {
+        std::vector<std::string> names = model_layer_names(num_res_blocks);
+        std::vector<Conv2d *> conv_layers = backbone_convs();
+        std::vector<NamedLayer> layers;
+        for (size_t i = 0; i < conv_layers.size(); ++i)
+            layers.push_back({names[i], conv_layers[i], nullptr});
+        size_t head = conv_layers.size();
+        layers.push_back({names[head], move_conv, nullptr});
+        layers.push_back({names[head + 1], nullptr, move_fc});
+        layers.push_back({names[head + 2], tile_conv, nullptr});
+        layers.push_back({names[head + 3], nullptr, tile_fc});
+        layers.push_back({names[head + 4], value_conv, nullptr});
+        layers.push_back({names[head + 5], nullptr, value_fc1});
+        layers.push_back({names[head + 6], nullptr, value_fc2});
+        return layers;
+    }
 
-        auto vfc2_w = read_float_vector(f);
-        auto vfc2_b = read_float_vector(f);
-        value_fc2->load_weights(vfc2_w, vfc2_b);
+    // Why the last load_from_file() failed
+    std::string load_error;
+
+    // Loads a model file (model_file.h), either version 1 or legacy, and
+    // rebuilds the layers if the file's architecture differs from the
+    // current one. Float weights are not copied: on native builds the layers
+    // point into the mapped file, which stays open while they use it. Int8
+    // weights are dequantized. If the file is invalid or its tensors do not
+    // fit its architecture, the network is left as it was and false is
+    // returned, with the reason in load_error.
+    bool load_from_file(const std::string &path)
+    {
+        auto file = std::make_shared<ModelFile>();
+        if (!file->open(path, load_error) || !load(*file, path))
+        {
+            std::cerr << "Failed to load model: " << load_error << std::endl;
+            return false;
+        }
+        weights_file = file;
+        std::cout << "Model weights loaded (" << (file->version ? "version " + std::to_string(file->version) : "legacy")
+                  << " format, " << file->file_bytes() / 1024 << " KB" << (file->is_mapped() ? ", mapped" : "")
+                  << ")." << std::endl;
+        return true;
+    }
 
-        std::cout << "Model weights loaded." << std::endl;
+    // Writes a version 1 model file. With int8_weights, conv and linear
+    // weights are stored as per-row int8, about a quarter of the size. Input
+    // activation scales are included once the network is calibrated, so the
+    // loaded network can switch to int8 without calibrating again.
+    bool save_to_file(const std::string &path, bool int8_weights = false)
+    {
+        ModelFileWriter writer(arch());
+        for (const NamedLayer &l : named_layers())
+        {
+            const Parameter &w = l.conv ? l.conv->weight : l.fc->weight;
+            const Parameter &b = l.conv ? l.conv->bias : l.fc->bias;
+            if (int8_weights)
+                writer.add_int8(l.name + "_w", w.shape, w.data());
+            else
+                writer.add(l.name + "_w", w.shape, w.data());
+            writer.add(l.name + "_b", b.shape, b.data());
+            if (l.quant().calibrated())
+                writer.add(l.name + "_in_scale", {1}, &l.quant().input_scale);
+        }
+        std::string error;
+        if (!writer.save(path, error))
+        {
+            std::cerr << "Failed to save model: " << error << std::endl;
+            return false;
+        }
+        return true;
     }
 
     // Forward Pass
-    // Returns {move_logits(1, 625), tile_logits(1, 51), value(1, 1)}
+    // Input is a batch (N, input_channels, board, board), (N, 66, 5, 5) for
+    // the shipped network. Returns {move_logits(N, move_actions),
+    // tile_logits(N, tile_actions), values(N)}; `value` is values[0]
     struct Output
     {
         Tensor move_logits;
         Tensor tile_logits;
         float value;
+        std::vector<float> values;
     };
 
+    // Arena floats forward() needs for a batch of N: three ping-pong
+    // activation buffers of the backbone width plus the largest layer scratch
+    size_t arena_floats(int N) const
+    {
+        int B = spec.board_size;
+        size_t act = Arena::rounded((size_t)N * spec.filters * B * B);
+        size_t scratch = conv_input->workspace(N, B, B);
+        for (auto b : res_blocks)
+            scratch = std::max(scratch, b->workspace(N, B, B));
+        scratch = std::max(scratch, conv_relu_linear_workspace(*move_conv, *move_fc, N, B, B));
+        scratch = std::max(scratch, conv_relu_linear_workspace(*tile_conv, *tile_fc, N, B, B));
+        scratch = std::max(scratch, conv_relu_linear_workspace(*value_conv, *value_fc1, N, B, B));
+        scratch = std::max(scratch, value_fc2->workspace(N));
+        return 3 * act + scratch;
+    }
+
+    // Allocation-free forward pass once `arena` and `out` have held a batch
+    // this large: activations and layer scratch come from `arena`, and the
+    // tensors of `out` are resized in place. Each concurrent caller needs its
+    // own arena and output.
+    void forward(const float *input, int N, Output &out, Arena &arena)
+    {
+        arena.reserve(arena_floats(N));
+        ForwardFn pass = (use_fast_path && fast_forward) ? fast_forward : &ContrastDualPolicyNet::forward_pass<0, 0, 0>;
+        (this->*pass)(input, N, out, arena);
+    }
+
+    // Same, on the network's own arena (single-threaded callers)
+    void forward(const float *input, int N, Output &out)
+    {
+        forward(input, N, out, arena);
+    }
+
     Output forward(const Tensor &input)
     {
-        // Backbone
-        Tensor x = conv_input->forward(input);
-        x = relu(x);
+        Output out;
+        Arena scratch;
+        forward(input.data.data(), input.shape[0], out, scratch);
+        return out;
+    }
+
+    // Floats of one encoded input position
+    int input_size() const { return spec.input_channels * spec.board_size * spec.board_size; }
+
+private:
+    ModelArch spec;
+    Arena arena;
+    std::shared_ptr<const ModelFile> weights_file; // Backs the layers' weight views
+
+    using ForwardFn = void (ContrastDualPolicyNet::*)(const float *, int, Output &, Arena &);
+    ForwardFn fast_forward = nullptr;
+
+    // Architectures with a compiled fast path: the input and backbone channel
+    // counts and the board size are template arguments, so the Winograd tile
+    // transforms, im2col and the int8 lowering run with fixed strides and
+    // trip counts. The shipped network and its half and double width
+    // variants are listed; anything else runs forward_pass<0, 0, 0>, which
+    // reads the sizes at run time.
+    template <int IN_C, int FILTERS, int BOARD>
+    struct FastPath
+    {
+        static constexpr int in_channels = IN_C;
+        static constexpr int filters = FILTERS;
+        static constexpr int board = BOARD;
+    };
+
+    template <class... Paths>
+    static ForwardFn select_forward(const ModelArch &a)
+    {
+        ForwardFn fn = nullptr;
+        ((fn = (!fn && a.input_channels == Paths::in_channels && a.filters == Paths::filters &&
+                a.board_size == Paths::board)
+                   ? &ContrastDualPolicyNet::forward_pass<Paths::in_channels, Paths::filters, Paths::board>
+                   : fn),
+         ...);
+        return fn;
+    }
+
+    // The forward pass proper; its template arguments are 0 on the generic path
+    template <int IN_C, int FILTERS, int BOARD>
+    void forward_pass(const float *input, int N, Output &out, Arena &arena)
+    {
+        size_t arena_mark = arena.mark();
+        const int B = BOARD ? BOARD : spec.board_size;
+        size_t act = (size_t)N * spec.filters * B * B;
+        float *x = arena.alloc(act);
+        float *a = arena.alloc(act);
+        float *b = arena.alloc(act);
+
+        // Backbone: conv_input, then each block reads x and leaves its output
+        // in b, which becomes the next x. Bias, residual and ReLU run in the
+        // conv epilogues.
+        conv_input->forward_into<IN_C, FILTERS, BOARD, BOARD>(input, N, B, B, x, arena, true);
+        for (auto block : res_blocks)
+        {
+            block->forward_into<FILTERS, BOARD, BOARD>(x, N, B, B, a, b, arena);
+            std::swap(x, b);
+        }
+
+        out.move_logits.shape = {N, spec.move_actions};
+        out.move_logits.data.resize((size_t)N * spec.move_actions);
+        out.tile_logits.shape = {N, spec.tile_actions};
+        out.tile_logits.data.resize((size_t)N * spec.tile_actions);
+        out.values.resize(N);
 
+        // Move Head: filters -> move_head_filters -> Flatten -> move_actions
+        conv_relu_linear<FILTERS, BOARD, BOARD>(*move_conv, *move_fc, x, N, B, B, out.move_logits.data.data(), arena);
+
+        // Tile Head: filters -> tile_head_filters -> Flatten -> tile_actions
+        conv_relu_linear<FILTERS, BOARD, BOARD>(*tile_conv, *tile_fc, x, N, B, B, out.tile_logits.data.data(), arena);
+
+        // Value Head: filters -> value_head_filters -> Flatten -> value_hidden -> ReLU -> 1 -> tanh
+        conv_relu_linear<FILTERS, BOARD, BOARD>(*value_conv, *value_fc1, x, N, B, B, b, arena, true);
+        value_fc2->forward_into(b, N, a, arena);
+        for (int n = 0; n < N; ++n)
+            out.values[n] = std::tanh(a[n]);
+        out.value = out.values[0];
+
+        arena.release(arena_mark);
+    }
+
+    static ModelArch arch_with_blocks(int blocks)
+    {
+        ModelArch a;
+        a.res_blocks = blocks;
+        return a;
+    }
+
+    void build(const ModelArch &a)
+    {
+        spec = a;
+        num_res_blocks = a.res_blocks;
+        int area = a.board_size * a.board_size;
+
+        conv_input = new Conv2d(a.input_channels, a.filters, 3, 1, 1);
+        for (int i = 0; i < num_res_blocks; ++i)
+            res_blocks.push_back(new ResidualBlock(a.filters));
+
+        move_conv = new Conv2d(a.filters, a.move_head_filters, 1, 1, 0);
+        move_fc = new Linear(a.move_head_filters * area, a.move_actions);
+
+        tile_conv = new Conv2d(a.filters, a.tile_head_filters, 1, 1, 0);
+        tile_fc = new Linear(a.tile_head_filters * area, a.tile_actions);
+
+        value_conv = new Conv2d(a.filters, a.value_head_filters, 1, 1, 0);
+        value_fc1 = new Linear(a.value_head_filters * area, a.value_hidden);
+        value_fc2 = new Linear(a.value_hidden, 1);
+
+        fast_forward = select_forward<FastPath<66, 64, 5>, FastPath<66, 32, 5>, FastPath<66, 128, 5>>(a);
+        int8 = false;
+        set_backbone_algorithm(backbone_algo);
+        arena.reserve(arena_floats(1));
+    }
+
+    void destroy()
+    {
+        delete conv_input;
         for (auto b : res_blocks)
+            delete b;
+        res_blocks.clear();
+        delete move_conv;
+        delete move_fc;
+        delete tile_conv;
+        delete tile_fc;
+        delete value_conv;
+        delete value_fc1;
+        delete value_fc2;
+    }
+
+    // Checks every tensor against the file's architecture before touching
+    // any layer, then rebuilds the layers if that architecture is new
+    bool load(const ModelFile &file, const std::string &path)
+    {
+        std::vector<LayerSpec> specs = layer_specs(file.arch);
+        std::vector<Parameter> weights(specs.size()), biases(specs.size());
+        std::vector<float> scales(specs.size(), 0.0f);
+        for (size_t i = 0; i < specs.size(); ++i)
         {
-            x = b->forward(x);
+            const LayerSpec &l = specs[i];
+            if (!file.read(l.name + "_w", l.weight_shape, weights[i], load_error) ||
+                !file.read(l.name + "_b", l.bias_shape, biases[i], load_error))
+            {
+                load_error = path + ": " + load_error + " (model is " + file.arch.describe() + ")";
+                return false;
+            }
+            if (file.find(l.name + "_in_scale"))
+            {
+                Parameter scale;
+                if (!file.read(l.name + "_in_scale", {1}, scale, load_error) || !(scale[0] > 0.0f))
+                {
+                    load_error = path + ": bad input scale for " + l.name;
+                    return false;
+                }
+                scales[i] = scale[0];
+            }
         }
 
-        // Move Head
-        Tensor m = move_conv->forward(x); // (1, 32, 5, 5)
-        m = relu(m);
-        // Flatten handled implicitly by Linear treating input as (N, 800)
-        Tensor move_logits = move_fc->forward(m);
-
-        // Tile Head
-        Tensor t = tile_conv->forward(x);
-        t = relu(t);
-        Tensor tile_logits = tile_fc->forward(t);
-
-        // Value Head
-        Tensor v = value_conv->forward(x); // (1, 1, 5, 5)
-        v = relu(v);
-        v = value_fc1->forward(v);
-        v = relu(v);
-        Tensor val_out = value_fc2->forward(v);
-        float value = std::tanh(val_out[0]);
-
-        return {move_logits, tile_logits, value};
+        if (file.arch != spec)
+        {
+            destroy();
+            build(file.arch);
+        }
+        std::vector<NamedLayer> layers = named_layers();
+        for (size_t i = 0; i < layers.size(); ++i)
+        {
+            const NamedLayer &l = layers[i];
+            l.quant().input_scale = scales[i];
+            if (l.conv)
+                l.conv->set_weights(std::move(weights[i]), std::move(biases[i]));
+            else
+                l.fc->set_weights(std::move(weights[i]), std::move(biases[i]));
+        }
+        if (int8 && !int8_calibrated())
+            set_int8(false); // The new weights came without activation scales
+        return true;
     }
 };
 
@@ -0,0 +1,598 @@
+#ifndef MODEL_FILE_H
+#define MODEL_FILE_H
+
+#include "tensor.h"
+#include "quant.h"
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if !defined(__EMSCRIPTEN__) && (defined(__unix__) || defined(__APPLE__))
+#define MODEL_FILE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define MODEL_FILE_MMAP 0
+#endif
+
+// Model file format, version 1. Fields are little-endian (wasm, x86, ARM).
+//
+//   ModelFileHeader       magic, version, section sizes, file size, checksum
+//   ModelArch             architecture parameters, arch_fields int32 values
+//   ModelTensorEntry[]    tensor_count entries: name, dtype, shape, data offset
+//   tensor data           each tensor starts at a multiple of `alignment`
+//
+// The checksum is the CRC-32 (zlib polynomial) of every byte after the
+// header. A MODEL_DTYPE_INT8 tensor "<name>" of shape [rows, ...] holds
+// per-row symmetric int8 values and is accompanied by its float scales, the
+// [rows] tensor "<name>_scale" (quant_weight_scale() picks them). Since float
+// tensors are aligned, native builds map the file and layers point straight
+// into it.
+//
+// scripts/export_weights.py writes this format, as does ModelFileWriter.
+// Files without the magic are read as the legacy format: a bare sequence of
+// (int32 ndims, int32 dims[ndims], float32 data[]) records, in the order of
+// model_layer_names().
+
+constexpr char MODEL_FILE_MAGIC[8] = {'C', 'T', 'R', 'S', 'T', 'N', 'N', '\0'};
+constexpr uint32_t MODEL_FILE_VERSION = 1;
+constexpr uint32_t MODEL_FILE_ALIGN = 64;
+constexpr int MODEL_TENSOR_NAME_LEN = 48;
+constexpr int MODEL_TENSOR_MAX_DIMS = 4;
+
+enum ModelDtype : uint32_t {
+    MODEL_DTYPE_FLOAT32 = 0,
+    MODEL_DTYPE_INT8 = 1,
+};
+
+struct ModelFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t alignment;
+    uint32_t arch_fields;
+    uint32_t tensor_count;
+    uint64_t file_bytes;
+    uint32_t checksum;
+    uint32_t reserved;
+};
+static_assert(sizeof(ModelFileHeader) == 40, "ModelFileHeader layout");
+
+// Architecture section; the defaults are the shipped network (config.py)
+struct ModelArch {
+    int32_t board_size = 5;
+    int32_t input_channels = 66;
+    int32_t filters = 64;
+    int32_t res_blocks = 8;
+    int32_t move_head_filters = 32;
+    int32_t tile_head_filters = 16;
+    int32_t value_head_filters = 4;
+    int32_t value_hidden = 32;
+    int32_t move_actions = 625;
+    int32_t tile_actions = 51;
+
+    bool operator==(const ModelArch& o) const { return std::memcmp(this, &o, sizeof(ModelArch)) == 0; }
+    bool operator!=(const ModelArch& o) const { return !(*this == o); }
+
+    // Why the fields cannot describe a network, or "" if they can. Upper
+    // bounds keep every layer shape well inside int and the layers' sizes
+    // sane, so a bad header fails here rather than in build().
+    std::string check() const {
+        struct Bound { const char* name; int32_t value; int32_t max; };
+        const Bound bounds[] = {
+            {"board_size", board_size, 16},
+            {"input_channels", input_channels, 1024},
+            {"filters", filters, 1024},
+            {"res_blocks", res_blocks, 256},
+            {"move_head_filters", move_head_filters, 1024},
+            {"tile_head_filters", tile_head_filters, 1024},
+            {"value_head_filters", value_head_filters, 1024},
+            {"value_hidden", value_hidden, 4096},
+            {"move_actions", move_actions, 65536},
+            {"tile_actions", tile_actions, 4096},
+        };
+        static_assert(sizeof(bounds) / sizeof(bounds[0]) == sizeof(ModelArch) / sizeof(int32_t), "a bound per field");
+        for (const Bound& b : bounds)
+            if (b.value <= 0 || b.value > b.max)
+                return std::string(b.name) + " is " + std::to_string(b.value) + ", outside 1.." + std::to_string(b.max);
+        return "";
+    }
+    bool valid() const { return check().empty(); }
+
+    std::string describe() const {
+        return std::to_string(input_channels) + " planes, " + std::to_string(res_blocks) + " blocks x " +
+               std::to_string(filters) + " filters, heads " + std::to_string(move_head_filters) + "/" +
+               std::to_string(tile_head_filters) + "/" + std::to_string(value_head_filters) + ", value hidden " +
+               std::to_string(value_hidden) + ", " + std::to_string(board_size) + "x" +
+               std::to_string(board_size) + " board";
+    }
+};
+constexpr uint32_t MODEL_ARCH_FIELDS = sizeof(ModelArch) / sizeof(int32_t);
+static_assert(sizeof(ModelArch) == MODEL_ARCH_FIELDS * sizeof(int32_t), "ModelArch holds int32 fields only");
+
+struct ModelTensorEntry {
+    char name[MODEL_TENSOR_NAME_LEN]; // NUL-terminated
+    uint32_t dtype;
+    uint32_t ndims;
+    int32_t dims[MODEL_TENSOR_MAX_DIMS];
+    uint64_t offset; // From the start of the file
+    uint64_t bytes;
+};
+static_assert(sizeof(ModelTensorEntry) == 88, "ModelTensorEntry layout");
+
+// Tensor name prefixes of the network's layers in forward order; a layer's
+// weight and bias are "<prefix>_w" and "<prefix>_b" (the export script's names)
+inline std::vector<std::string> model_layer_names(int res_blocks) {
+    std::vector<std::string> names = {"input_conv"};
+    for (int i = 0; i < res_blocks; ++i) {
+        names.push_back("res" + std::to_string(i) + "_conv1");
+        names.push_back("res" + std::to_string(i) + "_conv2");
+    }
+    names.insert(names.end(), {"move_head_conv", "move_head_fc", "tile_head_conv", "tile_head_fc",
+                               "val_head_conv", "val_head_fc1", "val_head_fc2"});
+    return names;
+}
+
+// CRC-32 with the zlib polynomial, so Python's zlib.crc32() agrees
+struct Crc32Table {
+    uint32_t v[256];
+    constexpr Crc32Table() : v() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            v[i] = c;
+        }
+    }
+};
+constexpr Crc32Table CRC32_TABLE;
+
+inline uint32_t crc32(const uint8_t* data, size_t n, uint32_t crc = 0) {
+    crc = ~crc;
+    for (size_t i = 0; i < n; ++i) crc = CRC32_TABLE.v[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+inline std::string shape_string(const std::vector<int>& shape) {
+    std::string s = "[";
+    for (size_t i = 0; i < shape.size(); ++i) s += (i ? ", " : "") + std::to_string(shape[i]);
+    return s + "]";
+}
+
+// Read-only bytes of a file: memory-mapped where the platform has mmap, read
+// into a buffer otherwise (Emscripten's MEMFS would copy anyway)
+class MappedFile {
+public:
+    MappedFile() {}
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    bool open(const std::string& path, std::string& error) {
+        close();
+#if MODEL_FILE_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            error = "cannot open " + path + ": " + std::strerror(errno);
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            error = "cannot stat " + path + ": " + std::strerror(errno);
+            ::close(fd);
+            return false;
+        }
+        len = (size_t)st.st_size;
+        if (len > 0) {
+            void* p = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                error = "cannot map " + path + ": " + std::strerror(errno);
+                ::close(fd);
+                len = 0;
+                return false;
+            }
+            ptr = static_cast<const uint8_t*>(p);
+            mapped = true;
+        }
+        ::close(fd);
+        return true;
+#else
+        std::ifstream f(path, std::ios::binary | std::ios::ate);
+        if (!f.is_open()) {
+            error = "cannot open " + path;
+            return false;
+        }
+        buffer.resize((size_t)f.tellg());
+        f.seekg(0);
+        f.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+        if (!f) {
+            error = "cannot read " + path;
+            return false;
+        }
+        ptr = buffer.data();
+        len = buffer.size();
+        return true;
+#endif
+    }
+
+    void close() {
+#if MODEL_FILE_MMAP
+        if (mapped) munmap(const_cast<uint8_t*>(ptr), len);
+#endif
+        buffer.clear();
+        ptr = nullptr;
+        len = 0;
+        mapped = false;
+    }
+
+    const uint8_t* data() const { return ptr; }
+    size_t size() const { return len; }
+    bool is_mapped() const { return mapped; }
+
+private:
+    std::vector<uint8_t> buffer;
+    const uint8_t* ptr = nullptr;
+    size_t len = 0;
+    bool mapped = false;
+};
+
+struct ModelTensor {
+    std::string name;
+    uint32_t dtype = MODEL_DTYPE_FLOAT32;
+    std::vector<int> shape;
+    const uint8_t* data = nullptr; // Into the file's bytes
+    size_t bytes = 0;
+};
+
+// A parsed model file. Every check happens in open(), which fails with a
+// message naming the problem; the tensors then stay valid while the
+// ModelFile lives.
+class ModelFile {
+public:
+    uint32_t version = 0; // 0 for the legacy format
+    ModelArch arch;
+    std::vector<ModelTensor> tensors;
+
+    bool open(const std::string& path, std::string& error) {
+        tensors.clear();
+        if (!file.open(path, error)) return false;
+        const uint8_t* data = file.data();
+        size_t size = file.size();
+        bool ok = (size >= sizeof(MODEL_FILE_MAGIC) && std::memcmp(data, MODEL_FILE_MAGIC, sizeof(MODEL_FILE_MAGIC)) == 0)
+                      ? parse(data, size, error)
+                      : parse_legacy(data, size, error);
+        if (!ok) {
+            error = path + ": " + error;
+            tensors.clear();
+            file.close();
+        }
+        return ok;
+    }
+
+    bool is_mapped() const { return file.is_mapped(); }
+    size_t file_bytes() const { return file.size(); }
+
+    const ModelTensor* find(const std::string& name) const {
+        for (const ModelTensor& t : tensors)
+            if (t.name == name) return &t;
+        return nullptr;
+    }
+
+    // Values of tensor `name`, which must have `shape`: a view into the file
+    // for float32, dequantized with "<name>_scale" for int8
+    bool read(const std::string& name, const std::vector<int>& shape, Parameter& out, std::string& error) const {
+        const ModelTensor* t = find(name);
+        if (!t) {
+            error = "missing tensor " + name;
+            return false;
+        }
+        if (t->shape != shape) {
+            error = name + " has shape " + shape_string(t->shape) + ", expected " + shape_string(shape);
+            return false;
+        }
+        if (t->dtype == MODEL_DTYPE_FLOAT32) {
+            out = Parameter::view(shape, reinterpret_cast<const float*>(t->data));
+            return true;
+        }
+        const ModelTensor* s = find(name + "_scale");
+        if (!s || s->dtype != MODEL_DTYPE_FLOAT32 || s->shape != std::vector<int>{shape[0]}) {
+            error = "int8 tensor " + name + " needs a float32 " + name + "_scale of shape [" +
+                    std::to_string(shape[0]) + "]";
+            return false;
+        }
+        const int8_t* q = reinterpret_cast<const int8_t*>(t->data);
+        const float* scales = reinterpret_cast<const float*>(s->data);
+        size_t cols = t->bytes / shape[0];
+        std::vector<float> values(t->bytes);
+        for (size_t i = 0; i < values.size(); ++i) values[i] = q[i] * scales[i / cols];
+        out = Parameter(shape, std::move(values));
+        return true;
+    }
+
+private:
+    MappedFile file;
+
+    static size_t dtype_size(uint32_t dtype) { return dtype == MODEL_DTYPE_INT8 ? 1 : sizeof(float); }
+
+    // Bytes of a tensor of `shape`, in 64 bits whatever size_t is. False if
+    // they would exceed `limit` (what is left of the file); as the running
+    // product never passes `limit`, it cannot overflow either.
+    static bool shape_bytes(const std::vector<int>& shape, size_t element_size, uint64_t limit, uint64_t& bytes) {
+        uint64_t n = element_size;
+        if (n > limit) return false;
+        for (int d : shape) {
+            if ((uint64_t)d > limit / n) return false;
+            n *= (uint64_t)d;
+        }
+        bytes = n;
+        return true;
+    }
+
+    bool parse(const uint8_t* data, size_t size, std::string& error) {
+        ModelFileHeader h;
+        if (size < sizeof(h)) {
+            error = "file is " + std::to_string(size) + " bytes, too short for a model header";
+            return false;
+        }
+        std::memcpy(&h, data, sizeof(h));
+        if (h.version != MODEL_FILE_VERSION) {
+            error = "model file version " + std::to_string(h.version) + " is not supported (this build reads version " +
+                    std::to_string(MODEL_FILE_VERSION) + ")";
+            return false;
+        }
+        if (h.file_bytes != size) {
+            error = "header says " + std::to_string(h.file_bytes) + " bytes but the file has " + std::to_string(size) +
+                    " (truncated download?)";
+            return false;
+        }
+        if (h.arch_fields != MODEL_ARCH_FIELDS) {
+            error = "architecture section has " + std::to_string(h.arch_fields) + " fields, version 1 has " +
+                    std::to_string(MODEL_ARCH_FIELDS);
+            return false;
+        }
+        if (h.alignment < sizeof(float) || (h.alignment & (h.alignment - 1)) != 0) {
+            error = "bad tensor alignment " + std::to_string(h.alignment);
+            return false;
+        }
+        size_t table_end = sizeof(h) + sizeof(ModelArch) + (size_t)h.tensor_count * sizeof(ModelTensorEntry);
+        if (h.tensor_count > size / sizeof(ModelTensorEntry) || table_end > size) {
+            error = "tensor table of " + std::to_string(h.tensor_count) + " entries runs past the end of the file";
+            return false;
+        }
+        uint32_t crc = crc32(data + sizeof(h), size - sizeof(h));
+        if (crc != h.checksum) {
+            error = "checksum mismatch (file is corrupted)";
+            return false;
+        }
+
+        std::memcpy(&arch, data + sizeof(h), sizeof(ModelArch));
+        std::string bad_arch = arch.check();
+        if (!bad_arch.empty()) {
+            error = "architecture section is invalid: " + bad_arch;
+            return false;
+        }
+
+        const uint8_t* table = data + sizeof(h) + sizeof(ModelArch);
+        for (uint32_t i = 0; i < h.tensor_count; ++i) {
+            ModelTensorEntry e;
+            std::memcpy(&e, table + (size_t)i * sizeof(e), sizeof(e));
+            std::string where = "tensor #" + std::to_string(i);
+            if (std::memchr(e.name, '\0', sizeof(e.name)) == nullptr || e.name[0] == '\0') {
+                error = where + " has no valid name";
+                return false;
+            }
+            ModelTensor t;
+            t.name = e.name;
+            where = "tensor " + t.name;
+            if (find(t.name)) {
+                error = where + " appears twice";
+                return false;
+            }
+            if (e.dtype != MODEL_DTYPE_FLOAT32 && e.dtype != MODEL_DTYPE_INT8) {
+                error = where + " has unknown dtype " + std::to_string(e.dtype);
+                return false;
+            }
+            if (e.ndims < 1 || e.ndims > (uint32_t)MODEL_TENSOR_MAX_DIMS) {
+                error = where + " has " + std::to_string(e.ndims) + " dimensions";
+                return false;
+            }
+            for (uint32_t d = 0; d < e.ndims; ++d) {
+                if (e.dims[d] <= 0) {
+                    error = where + " has a non-positive dimension";
+                    return false;
+                }
+                t.shape.push_back(e.dims[d]);
+            }
+            t.dtype = e.dtype;
+            uint64_t need;
+            if (!shape_bytes(t.shape, dtype_size(e.dtype), size, need)) {
+                error = where + " has shape " + shape_string(t.shape) + ", larger than the file";
+                return false;
+            }
+            if (e.bytes != need) {
+                error = where + " holds " + std::to_string(e.bytes) + " bytes, its shape " + shape_string(t.shape) +
+                        " needs " + std::to_string(need);
+                return false;
+            }
+            t.bytes = (size_t)need;
+            if (e.offset % h.alignment != 0 || e.offset < table_end || e.offset > size || e.bytes > size - e.offset) {
+                error = where + " has data outside the file or misaligned (offset " + std::to_string(e.offset) + ")";
+                return false;
+            }
+            t.data = data + e.offset;
+            tensors.push_back(std::move(t));
+        }
+        version = h.version;
+        return true;
+    }
+
+    bool parse_legacy(const uint8_t* data, size_t size, std::string& error) {
+        std::vector<ModelTensor> records;
+        size_t pos = 0;
+        while (pos < size) {
+            std::string where = "legacy record #" + std::to_string(records.size());
+            int32_t ndims;
+            if (size - pos < sizeof(ndims)) {
+                error = where + " is truncated";
+                return false;
+            }
+            std::memcpy(&ndims, data + pos, sizeof(ndims));
+            if (ndims < 1 || ndims > MODEL_TENSOR_MAX_DIMS) {
+                error = "not a model file (no header, and " + where + " claims " + std::to_string(ndims) +
+                        " dimensions)";
+                return false;
+            }
+            pos += sizeof(ndims);
+            if (size - pos < ndims * sizeof(int32_t)) {
+                error = where + " is truncated";
+                return false;
+            }
+            ModelTensor t;
+            for (int d = 0; d < ndims; ++d) {
+                int32_t dim;
+                std::memcpy(&dim, data + pos + d * sizeof(dim), sizeof(dim));
+                if (dim <= 0) {
+                    error = where + " has a non-positive dimension";
+                    return false;
+                }
+                t.shape.push_back(dim);
+            }
+            pos += ndims * sizeof(int32_t);
+            uint64_t need;
+            if (!shape_bytes(t.shape, sizeof(float), size - pos, need)) {
+                error = where + " " + shape_string(t.shape) + " is truncated";
+                return false;
+            }
+            t.bytes = (size_t)need;
+            t.data = data + pos;
+            pos += t.bytes;
+            records.push_back(std::move(t));
+        }
+
+        // Input conv, 4 per block, 14 head tensors
+        if (records.size() < 16 || (records.size() - 16) % 4 != 0) {
+            error = "legacy file has " + std::to_string(records.size()) + " tensors, which fits no block count";
+            return false;
+        }
+        std::vector<std::string> layers = model_layer_names((int)(records.size() - 16) / 4);
+        for (size_t i = 0; i < records.size(); ++i) records[i].name = layers[i / 2] + (i % 2 ? "_b" : "_w");
+        tensors = std::move(records);
+
+        // The legacy format has no architecture section; infer it from the shapes
+        auto dim = [&](const char* name, int d) {
+            const ModelTensor* t = find(name);
+            return d < (int)t->shape.size() ? t->shape[d] : 0;
+        };
+        arch.res_blocks = (int)layers.size() / 2 - 4;
+        arch.filters = dim("input_conv_w", 0);
+        arch.input_channels = dim("input_conv_w", 1);
+        arch.move_head_filters = dim("move_head_conv_w", 0);
+        arch.tile_head_filters = dim("tile_head_conv_w", 0);
+        arch.value_head_filters = dim("val_head_conv_w", 0);
+        arch.value_hidden = dim("val_head_fc1_w", 0);
+        arch.move_actions = dim("move_head_fc_w", 0);
+        arch.tile_actions = dim("tile_head_fc_w", 0);
+        int area = arch.move_head_filters > 0 ? dim("move_head_fc_w", 1) / arch.move_head_filters : 0;
+        arch.board_size = 1;
+        while (arch.board_size * arch.board_size < area) ++arch.board_size;
+        std::string bad_arch = arch.check();
+        if (!bad_arch.empty()) {
+            error = "legacy file's shapes give an invalid architecture: " + bad_arch;
+            return false;
+        }
+        version = 0;
+        return true;
+    }
+};
+
+// Builds a version 1 model file
+class ModelFileWriter {
+public:
+    explicit ModelFileWriter(const ModelArch& arch) : arch(arch) {}
+
+    void add(const std::string& name, const std::vector<int>& shape, const float* values) {
+        size_t n = Parameter::count(shape);
+        std::vector<uint8_t> bytes(n * sizeof(float));
+        std::memcpy(bytes.data(), values, bytes.size());
+        entries.push_back({name, MODEL_DTYPE_FLOAT32, shape, std::move(bytes)});
+    }
+
+    // Per-row int8 values plus the "<name>_scale" tensor
+    void add_int8(const std::string& name, const std::vector<int>& shape, const float* values) {
+        int rows = shape[0];
+        int cols = (int)(Parameter::count(shape) / rows);
+        std::vector<uint8_t> bytes((size_t)rows * cols);
+        std::vector<float> scales(rows);
+        for (int r = 0; r < rows; ++r) {
+            const float* row = values + (size_t)r * cols;
+            scales[r] = quant_weight_scale(row, cols);
+            for (int c = 0; c < cols; ++c)
+                bytes[(size_t)r * cols + c] = (uint8_t)(int8_t)std::lrint(row[c] / scales[r]);
+        }
+        entries.push_back({name, MODEL_DTYPE_INT8, shape, std::move(bytes)});
+        add(name + "_scale", {rows}, scales.data());
+    }
+
+    std::vector<uint8_t> bytes() const {
+        auto align = [](size_t x) { return (x + MODEL_FILE_ALIGN - 1) / MODEL_FILE_ALIGN * MODEL_FILE_ALIGN; };
+        size_t offset = sizeof(ModelFileHeader) + sizeof(ModelArch) + entries.size() * sizeof(ModelTensorEntry);
+        std::vector<ModelTensorEntry> table;
+        for (const Entry& e : entries) {
+            ModelTensorEntry t = {};
+            std::strncpy(t.name, e.name.c_str(), MODEL_TENSOR_NAME_LEN - 1);
+            t.dtype = e.dtype;
+            t.ndims = (uint32_t)e.shape.size();
+            for (size_t d = 0; d < e.shape.size(); ++d) t.dims[d] = e.shape[d];
+            offset = align(offset);
+            t.offset = offset;
+            t.bytes = e.data.size();
+            offset += e.data.size();
+            table.push_back(t);
+        }
+
+        std::vector<uint8_t> out(offset, 0);
+        size_t pos = sizeof(ModelFileHeader);
+        std::memcpy(&out[pos], &arch, sizeof(arch));
+        pos += sizeof(arch);
+        if (!table.empty()) std::memcpy(&out[pos], table.data(), table.size() * sizeof(ModelTensorEntry));
+        for (size_t i = 0; i < entries.size(); ++i)
+            if (!entries[i].data.empty()) std::memcpy(&out[table[i].offset], entries[i].data.data(), entries[i].data.size());
+
+        ModelFileHeader h = {};
+        std::memcpy(h.magic, MODEL_FILE_MAGIC, sizeof(h.magic));
+        h.version = MODEL_FILE_VERSION;
+        h.alignment = MODEL_FILE_ALIGN;
+        h.arch_fields = MODEL_ARCH_FIELDS;
+        h.tensor_count = (uint32_t)entries.size();
+        h.file_bytes = out.size();
+        h.checksum = crc32(out.data() + sizeof(h), out.size() - sizeof(h));
+        std::memcpy(out.data(), &h, sizeof(h));
+        return out;
+    }
+
+    bool save(const std::string& path, std::string& error) const {
+        std::vector<uint8_t> data = bytes();
+        std::ofstream f(path, std::ios::binary);
+        f.write(reinterpret_cast<const char*>(data.data()), data.size());
+        if (!f) {
+            error = "cannot write " + path;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    struct Entry {
+        std::string name;
+        uint32_t dtype;
+        std::vector<int> shape;
+        std::vector<uint8_t> data;
+    };
+    ModelArch arch;
+    std::vector<Entry> entries;
+};
+
+#endif // MODEL_FILE_H
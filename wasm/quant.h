@@ -0,0 +1,249 @@
+#ifndef QUANT_H
+#define QUANT_H
+
+#include "simd.h"
+#include "arena.h"
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+// INT8 inference.
+//
+// Weights are quantized symmetrically per output channel, w ~= scale[oc] * q
+// with q in [-127, 127]. Every quantized activation is non-negative (the
+// input planes and post-ReLU values), so activations use the unsigned range,
+// x ~= act_scale * q with q in [0, 255], and act_scale is calibrated per
+// layer from the largest input seen on a set of positions. Products are
+// summed in int32 and rescaled once per output:
+//   y = scale[oc] * act_scale * sum(q_w * q_x) + bias
+// Both operands are held widened to int16, so one SIMD multiply-add
+// (pmaddwd, i32x4.dot_i16x8_s) takes 16 or 8 pairs with no saturation: a
+// pair sum is at most 2 * 255 * 127, and a whole row stays far inside int32.
+
+constexpr int QUANT_K_ALIGN = 16; // Reduction length padding: whole vectors for every kernel
+constexpr int QUANT_ROWS = 4;     // Output channels per dot4_i16 call
+constexpr int QUANT_WEIGHT_MAX = 127;
+constexpr int QUANT_ACT_MAX = 255;
+
+// Padded row length of a quantized matrix or input with `cols` columns
+inline int quant_stride(int cols) { return (cols + QUANT_K_ALIGN - 1) / QUANT_K_ALIGN * QUANT_K_ALIGN; }
+
+// Arena floats holding P quantized rows of `stride` int16 values
+inline size_t quant_rows_floats(int P, int stride) {
+    return Arena::rounded(((size_t)P * stride * sizeof(int16_t) + sizeof(float) - 1) / sizeof(float));
+}
+
+// Scale of one weight row: its largest magnitude maps to QUANT_WEIGHT_MAX.
+// Model files storing int8 weights use the same rule, so requantizing their
+// dequantized rows gives back the stored values.
+inline float quant_weight_scale(const float* row, int cols) {
+    float max_abs = 0.0f;
+    for (int c = 0; c < cols; ++c) max_abs = std::max(max_abs, std::fabs(row[c]));
+    return max_abs > 0.0f ? max_abs / QUANT_WEIGHT_MAX : 1.0f;
+}
+
+// A [rows, cols] weight matrix, quantized row by row. Rows are padded to a
+// multiple of QUANT_ROWS and columns to QUANT_K_ALIGN with zeros.
+struct QuantizedMatrix {
+    int rows = 0;
+    int cols = 0;
+    int stride = 0; // Padded columns
+    std::vector<int16_t> q;
+    std::vector<float> scales; // Per row
+
+    bool empty() const { return q.empty(); }
+
+    void quantize(const float* w, int rows_, int cols_) {
+        rows = rows_;
+        cols = cols_;
+        stride = quant_stride(cols);
+        int rows_pad = (rows + QUANT_ROWS - 1) / QUANT_ROWS * QUANT_ROWS;
+        q.assign((size_t)rows_pad * stride, 0);
+        scales.assign(rows_pad, 0.0f);
+        for (int r = 0; r < rows; ++r) {
+            const float* row = w + (size_t)r * cols;
+            float scale = quant_weight_scale(row, cols);
+            scales[r] = scale;
+            for (int c = 0; c < cols; ++c) q[(size_t)r * stride + c] = (int16_t)std::lrint(row[c] / scale);
+        }
+    }
+
+    void clear() {
+        q.clear();
+        scales.clear();
+    }
+
+    // Size as stored in the model file: int8 weights plus one float scale per row
+    size_t file_bytes() const { return (size_t)rows * cols + rows * sizeof(float); }
+};
+
+// Activation range of one layer's input, observed while calibrating
+struct ActivationRange {
+    float max = 0.0f;
+
+    void observe(const float* x, size_t n) {
+        for (size_t i = 0; i < n; ++i) max = std::max(max, x[i]);
+    }
+
+    // x ~= scale * q, q in [0, QUANT_ACT_MAX]
+    float scale() const { return max > 0.0f ? max / QUANT_ACT_MAX : 1.0f; }
+};
+
+// INT8 state of one layer: its quantized weights, the scale of its input
+// activations and the input range observed while that scale is calibrated
+struct QuantState {
+    QuantizedMatrix weights;
+    float input_scale = 0.0f; // 0 until calibrated
+    bool calibrating = false;
+    mutable ActivationRange range; // Written by forward passes while calibrating (single-threaded)
+
+    bool calibrated() const { return input_scale > 0.0f; }
+
+    void begin_calibration() {
+        calibrating = true;
+        range = ActivationRange();
+    }
+    void end_calibration() {
+        calibrating = false;
+        input_scale = range.scale();
+    }
+    void observe(const float* x, size_t n) const {
+        if (calibrating) range.observe(x, n);
+    }
+};
+
+inline int16_t quantize_activation(float x, float inv_scale) {
+    int v = (int)(x * inv_scale + 0.5f);
+    return (int16_t)std::min(std::max(v, 0), QUANT_ACT_MAX);
+}
+
+// Quantizes [P, cols] float rows into [P, stride] int16 rows (zero padded)
+inline void quantize_rows(const float* x, int P, int cols, int stride, float scale, int16_t* out) {
+    float inv_scale = 1.0f / scale;
+    for (int p = 0; p < P; ++p) {
+        const float* src = x + (size_t)p * cols;
+        int16_t* dst = out + (size_t)p * stride;
+        for (int c = 0; c < cols; ++c) dst[c] = quantize_activation(src[c], inv_scale);
+        std::fill(dst + cols, dst + stride, (int16_t)0);
+    }
+}
+
+// Quantizes [N, C, H, W] into channels-last [N, H + 2 pad, W + 2 pad, C]
+// with a zero border, so every tap of a patch is a contiguous C-vector.
+// Nonzero C_, H_ and W_ replace C, H and W with compile-time constants.
+template <int C_ = 0, int H_ = 0, int W_ = 0>
+inline void quantize_nhwc_padded(const float* input, int N, int channels, int height, int width, int pad,
+                                 float scale, int16_t* out) {
+    const int C = C_ ? C_ : channels, H = H_ ? H_ : height, W = W_ ? W_ : width;
+    float inv_scale = 1.0f / scale;
+    int Hp = H + 2 * pad, Wp = W + 2 * pad;
+    if constexpr (C_ && H_ && W_) {
+        // Each output pixel's C-vector is written contiguously, and only
+        // the border is cleared
+        for (int n = 0; n < N; ++n) {
+            int16_t* image = out + (size_t)n * Hp * Wp * C;
+            std::fill(image, image + (size_t)pad * Wp * C, (int16_t)0);
+            std::fill(image + (size_t)(pad + H) * Wp * C, image + (size_t)Hp * Wp * C, (int16_t)0);
+            const float* src = input + (size_t)n * C * H * W;
+            for (int y = 0; y < H; ++y) {
+                int16_t* dst = image + (size_t)(y + pad) * Wp * C;
+                std::fill(dst, dst + pad * C, (int16_t)0);
+                for (int x = 0; x < W; ++x)
+                    for (int c = 0; c < C; ++c)
+                        dst[(pad + x) * C + c] = quantize_activation(src[(c * H + y) * W + x], inv_scale);
+                std::fill(dst + (pad + W) * C, dst + Wp * C, (int16_t)0);
+            }
+        }
+        return;
+    }
+    std::fill(out, out + (size_t)N * Hp * Wp * C, (int16_t)0);
+    for (int n = 0; n < N; ++n) {
+        for (int c = 0; c < C; ++c) {
+            const float* plane = input + (size_t)(n * C + c) * H * W;
+            for (int y = 0; y < H; ++y) {
+                int16_t* dst = out + ((size_t)(n * Hp + y + pad) * Wp + pad) * C + c;
+                for (int x = 0; x < W; ++x) dst[x * C] = quantize_activation(plane[y * W + x], inv_scale);
+            }
+        }
+    }
+}
+
+// Patch rows from a padded channels-last input: one zero-padded row per
+// output position (n, h_out, w_out) holding its (kh, kw, c) patch, so every
+// output is a dot product of a weight row with a patch row
+inline void im2row_nhwc(const int16_t* input, int N, int C, int Hp, int Wp, int k, int stride,
+                        int H_out, int W_out, int16_t* rows, int row_stride) {
+    int K = k * k * C;
+    for (int n = 0; n < N; ++n) {
+        for (int h = 0; h < H_out; ++h) {
+            for (int w = 0; w < W_out; ++w) {
+                int16_t* row = rows + (size_t)((n * H_out + h) * W_out + w) * row_stride;
+                for (int kh = 0; kh < k; ++kh) {
+                    const int16_t* src = input + ((size_t)(n * Hp + h * stride + kh) * Wp + w * stride) * C;
+                    std::copy(src, src + k * C, row + kh * k * C); // k taps of one input row are contiguous
+                }
+                std::fill(row + K, row + row_stride, (int16_t)0);
+            }
+        }
+    }
+}
+
+// im2row_nhwc() for a stride-1 "same" convolution (pad K / 2) on H x W
+// planes known at compile time; a nonzero C_ fixes the channel count too,
+// which makes every tap copy a constant length
+template <int K, int H, int W, int C_ = 0>
+inline void im2row_nhwc_same(const int16_t* input, int N, int channels, int16_t* rows, int row_stride) {
+    constexpr int WP = W + 2 * (K / 2), HP = H + 2 * (K / 2);
+    const int C = C_ ? C_ : channels;
+    const int KC = K * C;
+    for (int n = 0; n < N; ++n) {
+        for (int h = 0; h < H; ++h) {
+            for (int w = 0; w < W; ++w) {
+                int16_t* row = rows + (size_t)((n * H + h) * W + w) * row_stride;
+                for (int kh = 0; kh < K; ++kh) {
+                    const int16_t* src = input + ((size_t)(n * HP + h + kh) * WP + w) * C;
+                    std::copy(src, src + KC, row + kh * KC);
+                }
+                std::fill(row + K * KC, row + row_stride, (int16_t)0);
+            }
+        }
+    }
+}
+
+// out = [relu](W * x + bias [+ residual]) for P quantized input rows. Row p,
+// channel oc lands at out[(p / hw) * W.rows * hw + oc * hw + p % hw], i.e.
+// [N, C, H, W] for a convolution over hw positions and [N, C] for a Linear
+// (hw = 1). Input rows go in blocks of QUANT_P_BLOCK that stay in L1 while
+// every QUANT_ROWS block of weights passes over them.
+constexpr int QUANT_P_BLOCK = 16;
+
+inline void quantized_matmul(const QuantizedMatrix& W, const int16_t* x, int P, int hw, float x_scale,
+                             const float* bias, float* out, bool relu = false, const float* residual = nullptr,
+                             const SimdKernels& kernels = simd_kernels()) {
+    for (int p0 = 0; p0 < P; p0 += QUANT_P_BLOCK) {
+        int p_end = std::min(P, p0 + QUANT_P_BLOCK);
+        for (int r0 = 0; r0 < W.rows; r0 += QUANT_ROWS) {
+            const int16_t* w = W.q.data() + (size_t)r0 * W.stride;
+            int rows = std::min(QUANT_ROWS, W.rows - r0);
+            float scale[QUANT_ROWS], b[QUANT_ROWS];
+            for (int r = 0; r < rows; ++r) {
+                scale[r] = W.scales[r0 + r] * x_scale;
+                b[r] = bias ? bias[r0 + r] : 0.0f;
+            }
+            for (int p = p0; p < p_end; ++p) {
+                int32_t acc[QUANT_ROWS];
+                kernels.dot4_i16(x + (size_t)p * W.stride, w, W.stride, W.stride, acc);
+                size_t base = (size_t)(p / hw) * W.rows * hw + p % hw;
+                for (int r = 0; r < rows; ++r) {
+                    size_t idx = base + (size_t)(r0 + r) * hw;
+                    float y = acc[r] * scale[r] + b[r];
+                    if (residual) y += residual[idx];
+                    out[idx] = (relu && y < 0.0f) ? 0.0f : y;
+                }
+            }
+        }
+    }
+}
+
+#endif // QUANT_H
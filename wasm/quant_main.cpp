@@ -0,0 +1,162 @@
+#include "game.h"
+#include "model.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// INT8 accuracy and speed report.
+// Usage: ./quant_main [model.bin] [--calib N] [--eval N] [--seed S] [--save out.bin]
+//
+// Plays games by sampling the fp32 network's own policy and records the
+// positions. The first --calib positions calibrate the activation scales.
+// The next --eval positions compare int8 against fp32 on:
+// - policy KL divergence over the legal actions (the priors the search uses)
+// - top-1 action agreement
+// - value MSE
+// The report also gives forward time and weight bytes for both precisions.
+// --save writes the model with int8 weights and the calibrated activation
+// scales, ready for int8 inference without calibrating at load time.
+
+using bench_clock = std::chrono::steady_clock;
+
+static double seconds_since(bench_clock::time_point t0) {
+    return std::chrono::duration<double>(bench_clock::now() - t0).count();
+}
+
+// Softmax over the legal actions of `game`, as MCTS::fill_edges() computes its priors
+static void legal_policy(const ContrastGame& game, const ActionList& legal, const float* move_logits,
+                         const float* tile_logits, std::vector<double>& probs) {
+    bool should_flip = (game.current_player == P2);
+    probs.resize(legal.size());
+    double max_logit = -1e30;
+    for (int i = 0; i < legal.size(); ++i) {
+        int a = should_flip ? flip_action(legal[i]) : legal[i];
+        probs[i] = move_logits[a / NUM_TILES] + tile_logits[a % NUM_TILES];
+        max_logit = std::max(max_logit, probs[i]);
+    }
+    double sum = 0.0;
+    for (auto& p : probs) sum += (p = std::exp(p - max_logit));
+    for (auto& p : probs) p /= sum;
+}
+
+// Positions from self-play with actions sampled from the fp32 policy
+static std::vector<float> record_positions(ContrastDualPolicyNet& net, int count, unsigned seed,
+                                           std::vector<ContrastGame>& games) {
+    std::mt19937 rng(seed);
+    std::vector<float> planes((size_t)count * ENCODED_STATE_SIZE);
+    ContrastDualPolicyNet::Output out;
+    std::vector<double> probs;
+    ActionList legal;
+    ContrastGame game;
+    for (int i = 0; i < count; ++i) {
+        if (game.game_over || game.move_count >= MAX_STEPS) game.reset();
+        games.push_back(game.copy());
+        float* x = &planes[(size_t)i * ENCODED_STATE_SIZE];
+        game.encode_state_into(x);
+
+        net.forward(x, 1, out);
+        game.generate_legal_actions(legal);
+        legal_policy(game, legal, out.move_logits.data.data(), out.tile_logits.data.data(), probs);
+        std::discrete_distribution<int> pick(probs.begin(), probs.end());
+        game.step(legal[pick(rng)]);
+    }
+    return planes;
+}
+
+static double forward_ms(ContrastDualPolicyNet& net, const std::vector<float>& planes, int n) {
+    ContrastDualPolicyNet::Output out;
+    net.forward(planes.data(), n, out);
+    int reps = std::max(4, 200 / n);
+    auto t0 = bench_clock::now();
+    for (int r = 0; r < reps; ++r) net.forward(planes.data(), n, out);
+    return seconds_since(t0) / reps * 1e3;
+}
+
+int main(int argc, char** argv) {
+    std::string model_path = "wasm/model.bin";
+    int calib = 512;
+    int eval = 1024;
+    unsigned seed = 1;
+    std::string save_path;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--calib" && i + 1 < argc) calib = std::atoi(argv[++i]);
+        else if (arg == "--eval" && i + 1 < argc) eval = std::atoi(argv[++i]);
+        else if (arg == "--seed" && i + 1 < argc) seed = std::atoi(argv[++i]);
+        else if (arg == "--save" && i + 1 < argc) save_path = argv[++i];
+        else model_path = arg;
+    }
+
+    ContrastDualPolicyNet net;
+    if (!net.load_from_file(model_path)) return 1;
+
+    std::vector<ContrastGame> games;
+    std::vector<float> planes = record_positions(net, calib + eval, seed, games);
+    net.calibrate(planes.data(), calib);
+
+    size_t fp32_bytes = 0, int8_bytes = 0;
+    for (Conv2d* c : net.convs()) fp32_bytes += c->weight.size() * sizeof(float);
+    for (Linear* l : net.linears()) fp32_bytes += l->weight.size() * sizeof(float);
+
+    const float* eval_planes = planes.data() + (size_t)calib * ENCODED_STATE_SIZE;
+    std::vector<float> ref_move((size_t)eval * 625), ref_tile((size_t)eval * NUM_TILES), ref_value(eval);
+    ContrastDualPolicyNet::Output out;
+    for (int i = 0; i < eval; ++i) {
+        net.forward(eval_planes + (size_t)i * ENCODED_STATE_SIZE, 1, out);
+        std::copy(out.move_logits.data.begin(), out.move_logits.data.end(), &ref_move[(size_t)i * 625]);
+        std::copy(out.tile_logits.data.begin(), out.tile_logits.data.end(), &ref_tile[(size_t)i * NUM_TILES]);
+        ref_value[i] = out.value;
+    }
+    double fp32_ms[2] = {forward_ms(net, planes, 1), forward_ms(net, planes, 16)};
+
+    if (!net.set_int8(true)) {
+        std::cerr << "Calibration failed" << std::endl;
+        return 1;
+    }
+    for (Conv2d* c : net.convs()) int8_bytes += c->quant.weights.file_bytes();
+    for (Linear* l : net.linears()) int8_bytes += l->quant.weights.file_bytes();
+
+    double kl_sum = 0.0, kl_max = 0.0, mse = 0.0;
+    int agree = 0;
+    std::vector<double> p_ref, p_q;
+    ActionList legal;
+    for (int i = 0; i < eval; ++i) {
+        const ContrastGame& game = games[calib + i];
+        net.forward(eval_planes + (size_t)i * ENCODED_STATE_SIZE, 1, out);
+        game.generate_legal_actions(legal);
+        legal_policy(game, legal, &ref_move[(size_t)i * 625], &ref_tile[(size_t)i * NUM_TILES], p_ref);
+        legal_policy(game, legal, out.move_logits.data.data(), out.tile_logits.data.data(), p_q);
+
+        double kl = 0.0;
+        for (size_t a = 0; a < p_ref.size(); ++a)
+            if (p_ref[a] > 0.0) kl += p_ref[a] * std::log(p_ref[a] / std::max(p_q[a], 1e-30));
+        kl_sum += kl;
+        kl_max = std::max(kl_max, kl);
+        agree += std::max_element(p_ref.begin(), p_ref.end()) - p_ref.begin() ==
+                 std::max_element(p_q.begin(), p_q.end()) - p_q.begin();
+        double dv = out.value - ref_value[i];
+        mse += dv * dv;
+    }
+    double int8_ms[2] = {forward_ms(net, planes, 1), forward_ms(net, planes, 16)};
+
+    std::cout << "[quant] positions: " << calib << " calibration, " << eval << " evaluation" << std::endl;
+    std::cout << "[quant] policy KL(fp32 || int8): mean " << kl_sum / eval << ", max " << kl_max << std::endl;
+    std::cout << "[quant] top-1 agreement: " << 100.0 * agree / eval << "%" << std::endl;
+    std::cout << "[quant] value MSE: " << mse / eval << std::endl;
+    std::cout << "[quant] weights: fp32 " << fp32_bytes / 1024 << " KB, int8 " << int8_bytes / 1024 << " KB"
+              << std::endl;
+    std::cout << "[quant] forward N=1: fp32 " << fp32_ms[0] << " ms, int8 " << int8_ms[0] << " ms (x"
+              << fp32_ms[0] / int8_ms[0] << ")" << std::endl;
+    std::cout << "[quant] forward N=16: fp32 " << fp32_ms[1] << " ms, int8 " << int8_ms[1] << " ms (x"
+              << fp32_ms[1] / int8_ms[1] << ")" << std::endl;
+
+    if (!save_path.empty()) {
+        if (!net.save_to_file(save_path, true)) return 1;
+        std::cout << "[quant] saved int8 model to " << save_path << std::endl;
+    }
+    return 0;
+}
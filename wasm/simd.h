@@ -0,0 +1,590 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+// Vector kernels behind the convolution, linear and elementwise layers.
+//
+// Every instruction set provides the same SimdKernels table:
+// - scalar:   portable C++, always available
+// - avx2:     x86 AVX2 + FMA, chosen at runtime when the CPU supports it
+// - wasm128:  WebAssembly SIMD128, compiled in with emcc -msimd128
+// simd_kernels() returns the best one; simd_set_kernels() overrides it (tests
+// and benchmarks compare the variants listed by simd_available()).
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define CONTRAST_SIMD_AVX2 1
+#include <immintrin.h>
+#endif
+
+#if defined(__wasm_simd128__)
+#define CONTRAST_SIMD_WASM128 1
+#include <wasm_simd128.h>
+#endif
+
+// Largest micro-kernel tile over all variants
+constexpr int SIMD_MAX_MR = 6;
+constexpr int SIMD_MAX_NR = 16;
+
+struct SimdKernels
+{
+    const char *name;
+
+    // GEMM micro-kernel tile size, see gemm.h
+    int mr;
+    int nr;
+    // C[mr x nr] (+)= packed A sliver (kc x mr) * packed B sliver (kc x nr)
+    void (*gemm_tile)(int kc, const float *a, const float *b, float *C, int ldc, bool accumulate);
+
+    float (*dot)(const float *a, const float *b, int n);
+    void (*add_bias)(float *dst, const float *src, float bias, int n); // dst = src + bias
+    void (*relu)(float *x, int n);                                     // x = max(x, 0)
+    void (*add)(float *x, const float *y, int n);                      // x += y
+    // Layer output epilogue: dst = src + bias (+ residual if non-null), then
+    // ReLU if `relu`; dst may alias src
+    void (*epilogue)(float *dst, const float *src, float bias, const float *residual, bool relu, int n);
+
+    // INT8 inference (quant.h): out[r] = x . w[r * ldw ...] for r < 4, with
+    // int16 operands, int32 sums and n a multiple of 16
+    void (*dot4_i16)(const int16_t *x, const int16_t *w, int ldw, int n, int32_t *out);
+
+    // x = softmax(x) over n > 0 values (the search's priors over legal moves).
+    // The vector variants use a polynomial exp, within 1.2e-7 relative of std::exp.
+    void (*softmax)(float *x, int n);
+};
+
+// exp(x) for x <= 0 (Cephes expf): x = k ln2 + r with |r| <= ln2 / 2, then a
+// degree-6 polynomial for e^r and k added to the exponent bits. Below -87 the
+// result is clamped to about 1e-38 rather than going denormal.
+constexpr float SIMD_EXP_MIN = -87.0f;
+constexpr float SIMD_EXP_LOG2E = 1.44269504088896341f;
+constexpr float SIMD_EXP_LN2_HI = 0.693359375f;
+constexpr float SIMD_EXP_LN2_LO = -2.12194440e-4f;
+constexpr float SIMD_EXP_POLY[6] = {1.9875691500e-4f, 1.3981999507e-3f, 8.3334519073e-3f,
+                                    4.1665795894e-2f, 1.6666665459e-1f, 5.0000001201e-1f};
+
+// --- Scalar ---
+
+inline void simd_scalar_gemm_tile(int kc, const float *a, const float *b, float *C, int ldc, bool accumulate)
+{
+    constexpr int MR = 4, NR = 8;
+    float acc[MR][NR] = {};
+    for (int p = 0; p < kc; ++p)
+    {
+        for (int i = 0; i < MR; ++i)
+            for (int j = 0; j < NR; ++j)
+                acc[i][j] += a[i] * b[j];
+        a += MR;
+        b += NR;
+    }
+    for (int i = 0; i < MR; ++i)
+        for (int j = 0; j < NR; ++j)
+            C[i * ldc + j] = accumulate ? C[i * ldc + j] + acc[i][j] : acc[i][j];
+}
+
+inline float simd_scalar_dot(const float *a, const float *b, int n)
+{
+    float sum = 0.0f;
+    for (int i = 0; i < n; ++i)
+        sum += a[i] * b[i];
+    return sum;
+}
+
+inline void simd_scalar_add_bias(float *dst, const float *src, float bias, int n)
+{
+    for (int i = 0; i < n; ++i)
+        dst[i] = src[i] + bias;
+}
+
+inline void simd_scalar_relu(float *x, int n)
+{
+    for (int i = 0; i < n; ++i)
+        if (x[i] < 0.0f)
+            x[i] = 0.0f;
+}
+
+inline void simd_scalar_add(float *x, const float *y, int n)
+{
+    for (int i = 0; i < n; ++i)
+        x[i] += y[i];
+}
+
+inline void simd_scalar_epilogue(float *dst, const float *src, float bias, const float *residual, bool relu, int n)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        float v = src[i] + bias;
+        if (residual)
+            v += residual[i];
+        dst[i] = (relu && v < 0.0f) ? 0.0f : v;
+    }
+}
+
+inline void simd_scalar_dot4_i16(const int16_t *x, const int16_t *w, int ldw, int n, int32_t *out)
+{
+    for (int r = 0; r < 4; ++r)
+    {
+        const int16_t *row = w + r * ldw;
+        int32_t sum = 0;
+        for (int i = 0; i < n; ++i)
+            sum += x[i] * row[i];
+        out[r] = sum;
+    }
+}
+
+inline void simd_scalar_softmax(float *x, int n)
+{
+    float max_v = x[0];
+    for (int i = 1; i < n; ++i)
+        max_v = x[i] > max_v ? x[i] : max_v;
+    float sum = 0.0f;
+    for (int i = 0; i < n; ++i)
+    {
+        x[i] = std::exp(x[i] - max_v);
+        sum += x[i];
+    }
+    float inv = 1.0f / sum;
+    for (int i = 0; i < n; ++i)
+        x[i] *= inv;
+}
+
+inline const SimdKernels SIMD_SCALAR = {
+    "scalar", 4, 8, simd_scalar_gemm_tile,
+    simd_scalar_dot, simd_scalar_add_bias, simd_scalar_relu, simd_scalar_add, simd_scalar_epilogue,
+    simd_scalar_dot4_i16, simd_scalar_softmax};
+
+// --- AVX2 + FMA ---
+
+#ifdef CONTRAST_SIMD_AVX2
+#define SIMD_AVX2_FN __attribute__((target("avx2,fma")))
+
+// 6 x 16 tile: 12 ymm accumulators, two B loads and six broadcasts per step
+SIMD_AVX2_FN inline void simd_avx2_gemm_tile(int kc, const float *a, const float *b, float *C, int ldc, bool accumulate)
+{
+    __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+    __m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+    __m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+    __m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+    __m256 c40 = _mm256_setzero_ps(), c41 = _mm256_setzero_ps();
+    __m256 c50 = _mm256_setzero_ps(), c51 = _mm256_setzero_ps();
+
+    for (int p = 0; p < kc; ++p)
+    {
+        __m256 b0 = _mm256_loadu_ps(b);
+        __m256 b1 = _mm256_loadu_ps(b + 8);
+        __m256 av;
+        av = _mm256_broadcast_ss(a + 0);
+        c00 = _mm256_fmadd_ps(av, b0, c00);
+        c01 = _mm256_fmadd_ps(av, b1, c01);
+        av = _mm256_broadcast_ss(a + 1);
+        c10 = _mm256_fmadd_ps(av, b0, c10);
+        c11 = _mm256_fmadd_ps(av, b1, c11);
+        av = _mm256_broadcast_ss(a + 2);
+        c20 = _mm256_fmadd_ps(av, b0, c20);
+        c21 = _mm256_fmadd_ps(av, b1, c21);
+        av = _mm256_broadcast_ss(a + 3);
+        c30 = _mm256_fmadd_ps(av, b0, c30);
+        c31 = _mm256_fmadd_ps(av, b1, c31);
+        av = _mm256_broadcast_ss(a + 4);
+        c40 = _mm256_fmadd_ps(av, b0, c40);
+        c41 = _mm256_fmadd_ps(av, b1, c41);
+        av = _mm256_broadcast_ss(a + 5);
+        c50 = _mm256_fmadd_ps(av, b0, c50);
+        c51 = _mm256_fmadd_ps(av, b1, c51);
+        a += 6;
+        b += 16;
+    }
+
+    __m256 acc[6][2] = {{c00, c01}, {c10, c11}, {c20, c21}, {c30, c31}, {c40, c41}, {c50, c51}};
+    for (int i = 0; i < 6; ++i)
+    {
+        float *row = C + i * ldc;
+        if (accumulate)
+        {
+            acc[i][0] = _mm256_add_ps(acc[i][0], _mm256_loadu_ps(row));
+            acc[i][1] = _mm256_add_ps(acc[i][1], _mm256_loadu_ps(row + 8));
+        }
+        _mm256_storeu_ps(row, acc[i][0]);
+        _mm256_storeu_ps(row + 8, acc[i][1]);
+    }
+}
+
+SIMD_AVX2_FN inline float simd_avx2_dot(const float *a, const float *b, int n)
+{
+    __m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps();
+    __m256 s2 = _mm256_setzero_ps(), s3 = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        s0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), s0);
+        s1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), s1);
+        s2 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 16), _mm256_loadu_ps(b + i + 16), s2);
+        s3 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 24), _mm256_loadu_ps(b + i + 24), s3);
+    }
+    for (; i + 8 <= n; i += 8)
+        s0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), s0);
+
+    __m256 s = _mm256_add_ps(_mm256_add_ps(s0, s1), _mm256_add_ps(s2, s3));
+    __m128 h = _mm_add_ps(_mm256_castps256_ps128(s), _mm256_extractf128_ps(s, 1));
+    h = _mm_add_ps(h, _mm_movehl_ps(h, h));
+    h = _mm_add_ss(h, _mm_movehdup_ps(h));
+    float sum = _mm_cvtss_f32(h);
+    for (; i < n; ++i)
+        sum += a[i] * b[i];
+    return sum;
+}
+
+SIMD_AVX2_FN inline void simd_avx2_add_bias(float *dst, const float *src, float bias, int n)
+{
+    __m256 bv = _mm256_set1_ps(bias);
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(src + i), bv));
+    for (; i < n; ++i)
+        dst[i] = src[i] + bias;
+}
+
+SIMD_AVX2_FN inline void simd_avx2_relu(float *x, int n)
+{
+    __m256 zero = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm256_storeu_ps(x + i, _mm256_max_ps(_mm256_loadu_ps(x + i), zero));
+    for (; i < n; ++i)
+        if (x[i] < 0.0f)
+            x[i] = 0.0f;
+}
+
+SIMD_AVX2_FN inline void simd_avx2_add(float *x, const float *y, int n)
+{
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm256_storeu_ps(x + i, _mm256_add_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+    for (; i < n; ++i)
+        x[i] += y[i];
+}
+
+SIMD_AVX2_FN inline void simd_avx2_epilogue(float *dst, const float *src, float bias, const float *residual, bool relu, int n)
+{
+    __m256 bv = _mm256_set1_ps(bias);
+    __m256 zero = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256 v = _mm256_add_ps(_mm256_loadu_ps(src + i), bv);
+        if (residual)
+            v = _mm256_add_ps(v, _mm256_loadu_ps(residual + i));
+        if (relu)
+            v = _mm256_max_ps(v, zero);
+        _mm256_storeu_ps(dst + i, v);
+    }
+    simd_scalar_epilogue(dst + i, src + i, bias, residual ? residual + i : nullptr, relu, n - i);
+}
+
+// pmaddwd: 16 int16 products per instruction, summed pairwise into int32
+SIMD_AVX2_FN inline void simd_avx2_dot4_i16(const int16_t *x, const int16_t *w, int ldw, int n, int32_t *out)
+{
+    __m256i s0 = _mm256_setzero_si256(), s1 = _mm256_setzero_si256();
+    __m256i s2 = _mm256_setzero_si256(), s3 = _mm256_setzero_si256();
+    for (int i = 0; i < n; i += 16)
+    {
+        __m256i xv = _mm256_loadu_si256((const __m256i *)(x + i));
+        s0 = _mm256_add_epi32(s0, _mm256_madd_epi16(xv, _mm256_loadu_si256((const __m256i *)(w + i))));
+        s1 = _mm256_add_epi32(s1, _mm256_madd_epi16(xv, _mm256_loadu_si256((const __m256i *)(w + ldw + i))));
+        s2 = _mm256_add_epi32(s2, _mm256_madd_epi16(xv, _mm256_loadu_si256((const __m256i *)(w + 2 * ldw + i))));
+        s3 = _mm256_add_epi32(s3, _mm256_madd_epi16(xv, _mm256_loadu_si256((const __m256i *)(w + 3 * ldw + i))));
+    }
+    // Per 128-bit lane: [s0 s1 s2 s3] partial sums, then add the two lanes
+    __m256i h = _mm256_hadd_epi32(_mm256_hadd_epi32(s0, s1), _mm256_hadd_epi32(s2, s3));
+    __m128i r = _mm_add_epi32(_mm256_castsi256_si128(h), _mm256_extracti128_si256(h, 1));
+    _mm_storeu_si128((__m128i *)out, r);
+}
+
+SIMD_AVX2_FN inline __m256 simd_avx2_exp(__m256 x)
+{
+    x = _mm256_max_ps(x, _mm256_set1_ps(SIMD_EXP_MIN));
+    __m256 k = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(SIMD_EXP_LOG2E)),
+                               _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256 r = _mm256_fnmadd_ps(k, _mm256_set1_ps(SIMD_EXP_LN2_HI), x);
+    r = _mm256_fnmadd_ps(k, _mm256_set1_ps(SIMD_EXP_LN2_LO), r);
+    __m256 p = _mm256_set1_ps(SIMD_EXP_POLY[0]);
+    for (int i = 1; i < 6; ++i)
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(SIMD_EXP_POLY[i]));
+    p = _mm256_fmadd_ps(_mm256_mul_ps(p, r), r, _mm256_add_ps(r, _mm256_set1_ps(1.0f)));
+    __m256i e = _mm256_slli_epi32(_mm256_cvtps_epi32(k), 23);
+    return _mm256_castsi256_ps(_mm256_add_epi32(_mm256_castps_si256(p), e));
+}
+
+SIMD_AVX2_FN inline float simd_avx2_hmax(__m256 v)
+{
+    __m128 h = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    h = _mm_max_ps(h, _mm_movehl_ps(h, h));
+    h = _mm_max_ss(h, _mm_movehdup_ps(h));
+    return _mm_cvtss_f32(h);
+}
+
+SIMD_AVX2_FN inline float simd_avx2_hsum(__m256 v)
+{
+    __m128 h = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    h = _mm_add_ps(h, _mm_movehl_ps(h, h));
+    h = _mm_add_ss(h, _mm_movehdup_ps(h));
+    return _mm_cvtss_f32(h);
+}
+
+SIMD_AVX2_FN inline void simd_avx2_softmax(float *x, int n)
+{
+    int i = 0;
+    float max_v = x[0];
+    if (n >= 8)
+    {
+        __m256 m = _mm256_loadu_ps(x);
+        for (i = 8; i + 8 <= n; i += 8)
+            m = _mm256_max_ps(m, _mm256_loadu_ps(x + i));
+        max_v = simd_avx2_hmax(m);
+    }
+    for (; i < n; ++i)
+        max_v = x[i] > max_v ? x[i] : max_v;
+
+    __m256 mv = _mm256_set1_ps(max_v);
+    __m256 s = _mm256_setzero_ps();
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        __m256 e = simd_avx2_exp(_mm256_sub_ps(_mm256_loadu_ps(x + i), mv));
+        _mm256_storeu_ps(x + i, e);
+        s = _mm256_add_ps(s, e);
+    }
+    float sum = simd_avx2_hsum(s);
+    for (; i < n; ++i)
+    {
+        x[i] = std::exp(x[i] - max_v);
+        sum += x[i];
+    }
+
+    float inv_sum = 1.0f / sum;
+    __m256 inv = _mm256_set1_ps(inv_sum);
+    for (i = 0; i + 8 <= n; i += 8)
+        _mm256_storeu_ps(x + i, _mm256_mul_ps(_mm256_loadu_ps(x + i), inv));
+    for (; i < n; ++i)
+        x[i] *= inv_sum;
+}
+
+#undef SIMD_AVX2_FN
+
+inline const SimdKernels SIMD_AVX2 = {
+    "avx2", 6, 16, simd_avx2_gemm_tile,
+    simd_avx2_dot, simd_avx2_add_bias, simd_avx2_relu, simd_avx2_add, simd_avx2_epilogue,
+    simd_avx2_dot4_i16, simd_avx2_softmax};
+#endif // CONTRAST_SIMD_AVX2
+
+// --- WebAssembly SIMD128 ---
+
+#ifdef CONTRAST_SIMD_WASM128
+
+// 4 x 8 tile: 8 v128 accumulators. SIMD128 has no FMA, so multiply then add.
+inline void simd_wasm128_gemm_tile(int kc, const float *a, const float *b, float *C, int ldc, bool accumulate)
+{
+    v128_t acc[4][2];
+    for (int i = 0; i < 4; ++i)
+        acc[i][0] = acc[i][1] = wasm_f32x4_splat(0.0f);
+
+    for (int p = 0; p < kc; ++p)
+    {
+        v128_t b0 = wasm_v128_load(b);
+        v128_t b1 = wasm_v128_load(b + 4);
+        for (int i = 0; i < 4; ++i)
+        {
+            v128_t av = wasm_v128_load32_splat(a + i);
+            acc[i][0] = wasm_f32x4_add(acc[i][0], wasm_f32x4_mul(av, b0));
+            acc[i][1] = wasm_f32x4_add(acc[i][1], wasm_f32x4_mul(av, b1));
+        }
+        a += 4;
+        b += 8;
+    }
+
+    for (int i = 0; i < 4; ++i)
+    {
+        float *row = C + i * ldc;
+        if (accumulate)
+        {
+            acc[i][0] = wasm_f32x4_add(acc[i][0], wasm_v128_load(row));
+            acc[i][1] = wasm_f32x4_add(acc[i][1], wasm_v128_load(row + 4));
+        }
+        wasm_v128_store(row, acc[i][0]);
+        wasm_v128_store(row + 4, acc[i][1]);
+    }
+}
+
+inline float simd_wasm128_dot(const float *a, const float *b, int n)
+{
+    v128_t s0 = wasm_f32x4_splat(0.0f), s1 = wasm_f32x4_splat(0.0f);
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        s0 = wasm_f32x4_add(s0, wasm_f32x4_mul(wasm_v128_load(a + i), wasm_v128_load(b + i)));
+        s1 = wasm_f32x4_add(s1, wasm_f32x4_mul(wasm_v128_load(a + i + 4), wasm_v128_load(b + i + 4)));
+    }
+    v128_t s = wasm_f32x4_add(s0, s1);
+    float sum = wasm_f32x4_extract_lane(s, 0) + wasm_f32x4_extract_lane(s, 1) +
+                wasm_f32x4_extract_lane(s, 2) + wasm_f32x4_extract_lane(s, 3);
+    for (; i < n; ++i)
+        sum += a[i] * b[i];
+    return sum;
+}
+
+inline void simd_wasm128_add_bias(float *dst, const float *src, float bias, int n)
+{
+    v128_t bv = wasm_f32x4_splat(bias);
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
+        wasm_v128_store(dst + i, wasm_f32x4_add(wasm_v128_load(src + i), bv));
+    for (; i < n; ++i)
+        dst[i] = src[i] + bias;
+}
+
+inline void simd_wasm128_relu(float *x, int n)
+{
+    v128_t zero = wasm_f32x4_splat(0.0f);
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
+        wasm_v128_store(x + i, wasm_f32x4_max(wasm_v128_load(x + i), zero));
+    for (; i < n; ++i)
+        if (x[i] < 0.0f)
+            x[i] = 0.0f;
+}
+
+inline void simd_wasm128_add(float *x, const float *y, int n)
+{
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
+        wasm_v128_store(x + i, wasm_f32x4_add(wasm_v128_load(x + i), wasm_v128_load(y + i)));
+    for (; i < n; ++i)
+        x[i] += y[i];
+}
+
+inline void simd_wasm128_epilogue(float *dst, const float *src, float bias, const float *residual, bool relu, int n)
+{
+    v128_t bv = wasm_f32x4_splat(bias);
+    v128_t zero = wasm_f32x4_splat(0.0f);
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        v128_t v = wasm_f32x4_add(wasm_v128_load(src + i), bv);
+        if (residual)
+            v = wasm_f32x4_add(v, wasm_v128_load(residual + i));
+        if (relu)
+            v = wasm_f32x4_max(v, zero);
+        wasm_v128_store(dst + i, v);
+    }
+    simd_scalar_epilogue(dst + i, src + i, bias, residual ? residual + i : nullptr, relu, n - i);
+}
+
+// i32x4.dot_i16x8_s: 8 int16 products per instruction, summed pairwise into int32
+inline void simd_wasm128_dot4_i16(const int16_t *x, const int16_t *w, int ldw, int n, int32_t *out)
+{
+    v128_t s[4];
+    for (int r = 0; r < 4; ++r)
+        s[r] = wasm_i32x4_splat(0);
+    for (int i = 0; i < n; i += 8)
+    {
+        v128_t xv = wasm_v128_load(x + i);
+        for (int r = 0; r < 4; ++r)
+            s[r] = wasm_i32x4_add(s[r], wasm_i32x4_dot_i16x8(xv, wasm_v128_load(w + r * ldw + i)));
+    }
+    for (int r = 0; r < 4; ++r)
+        out[r] = wasm_i32x4_extract_lane(s[r], 0) + wasm_i32x4_extract_lane(s[r], 1) +
+                 wasm_i32x4_extract_lane(s[r], 2) + wasm_i32x4_extract_lane(s[r], 3);
+}
+
+// No FMA: the same polynomial as simd_avx2_exp with separate multiply and add
+inline v128_t simd_wasm128_exp(v128_t x)
+{
+    x = wasm_f32x4_max(x, wasm_f32x4_splat(SIMD_EXP_MIN));
+    v128_t k = wasm_f32x4_nearest(wasm_f32x4_mul(x, wasm_f32x4_splat(SIMD_EXP_LOG2E)));
+    v128_t r = wasm_f32x4_sub(x, wasm_f32x4_mul(k, wasm_f32x4_splat(SIMD_EXP_LN2_HI)));
+    r = wasm_f32x4_sub(r, wasm_f32x4_mul(k, wasm_f32x4_splat(SIMD_EXP_LN2_LO)));
+    v128_t p = wasm_f32x4_splat(SIMD_EXP_POLY[0]);
+    for (int i = 1; i < 6; ++i)
+        p = wasm_f32x4_add(wasm_f32x4_mul(p, r), wasm_f32x4_splat(SIMD_EXP_POLY[i]));
+    p = wasm_f32x4_add(wasm_f32x4_mul(wasm_f32x4_mul(p, r), r), wasm_f32x4_add(r, wasm_f32x4_splat(1.0f)));
+    v128_t e = wasm_i32x4_shl(wasm_i32x4_trunc_sat_f32x4(k), 23);
+    return wasm_i32x4_add(p, e);
+}
+
+inline void simd_wasm128_softmax(float *x, int n)
+{
+    int i = 0;
+    float max_v = x[0];
+    if (n >= 4)
+    {
+        v128_t m = wasm_v128_load(x);
+        for (i = 4; i + 4 <= n; i += 4)
+            m = wasm_f32x4_max(m, wasm_v128_load(x + i));
+        max_v = std::max(std::max(wasm_f32x4_extract_lane(m, 0), wasm_f32x4_extract_lane(m, 1)),
+                         std::max(wasm_f32x4_extract_lane(m, 2), wasm_f32x4_extract_lane(m, 3)));
+    }
+    for (; i < n; ++i)
+        max_v = x[i] > max_v ? x[i] : max_v;
+
+    v128_t mv = wasm_f32x4_splat(max_v);
+    v128_t s = wasm_f32x4_splat(0.0f);
+    for (i = 0; i + 4 <= n; i += 4)
+    {
+        v128_t e = simd_wasm128_exp(wasm_f32x4_sub(wasm_v128_load(x + i), mv));
+        wasm_v128_store(x + i, e);
+        s = wasm_f32x4_add(s, e);
+    }
+    float sum = wasm_f32x4_extract_lane(s, 0) + wasm_f32x4_extract_lane(s, 1) +
+                wasm_f32x4_extract_lane(s, 2) + wasm_f32x4_extract_lane(s, 3);
+    for (; i < n; ++i)
+    {
+        x[i] = std::exp(x[i] - max_v);
+        sum += x[i];
+    }
+
+    float inv_sum = 1.0f / sum;
+    v128_t inv = wasm_f32x4_splat(inv_sum);
+    for (i = 0; i + 4 <= n; i += 4)
+        wasm_v128_store(x + i, wasm_f32x4_mul(wasm_v128_load(x + i), inv));
+    for (; i < n; ++i)
+        x[i] *= inv_sum;
+}
+
+inline const SimdKernels SIMD_WASM128 = {
+    "wasm128", 4, 8, simd_wasm128_gemm_tile,
+    simd_wasm128_dot, simd_wasm128_add_bias, simd_wasm128_relu, simd_wasm128_add, simd_wasm128_epilogue,
+    simd_wasm128_dot4_i16, simd_wasm128_softmax};
+#endif // CONTRAST_SIMD_WASM128
+
+// --- Dispatch ---
+
+// Every variant this build and CPU can run, best first; the scalar one is always last
+inline std::vector<const SimdKernels *> simd_available()
+{
+    std::vector<const SimdKernels *> out;
+#ifdef CONTRAST_SIMD_AVX2
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        out.push_back(&SIMD_AVX2);
+#endif
+#ifdef CONTRAST_SIMD_WASM128
+    out.push_back(&SIMD_WASM128);
+#endif
+    out.push_back(&SIMD_SCALAR);
+    return out;
+}
+
+inline const SimdKernels *&simd_active()
+{
+    static const SimdKernels *active = simd_available().front();
+    return active;
+}
+
+inline const SimdKernels &simd_kernels() { return *simd_active(); }
+
+// Not synchronised with running searches: switch only while no forward pass is in flight
+inline void simd_set_kernels(const SimdKernels *kernels) { simd_active() = kernels; }
+
+#endif // SIMD_H
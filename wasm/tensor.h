@@ -7,6 +7,7 @@
 #include <cassert>
 #include <algorithm>
 #include <numeric>
+#include <utility>
 
 // 4D Tensor class (N, C, H, W) or (N, C) or (N)
 class Tensor {
@@ -42,7 +43,8 @@ public:
         std::fill(data.begin(), data.end(), value);
     }
 
-    // Helper to get linear index from 4D coordinates
+    // Helper to get linear index from 4D coordinates. The strides come from
+    // `shape` on every call; kernels with a fixed geometry use NchwLayout.
     int index(int n, int c, int h, int w) const {
         // shape: [N, C, H, W]
         assert(shape.size() == 4);
@@ -64,4 +66,69 @@ public:
     }
 };
 
+// [N, C, H, W] indexing with C, H and W fixed at compile time, so the
+// strides are constants the compiler folds into the addressing
+template <int C, int H, int W>
+struct NchwLayout {
+    static constexpr int channels = C;
+    static constexpr int height = H;
+    static constexpr int width = W;
+    static constexpr int plane = H * W;
+    static constexpr int image = C * plane;
+
+    static constexpr int index(int n, int c, int h, int w) { return n * image + c * plane + h * W + w; }
+};
+
+// Read-only parameter array (a layer's weights or bias). It either owns its
+// values or points at values that outlive it, such as the tensors of a
+// memory-mapped model file, so loading needs no copy.
+class Parameter {
+public:
+    std::vector<int> shape;
+
+    Parameter() {}
+    Parameter(std::vector<int> shape_, std::vector<float> values) : shape(std::move(shape_)), owned(std::move(values)) {
+        ptr = owned.data();
+        n = owned.size();
+        assert(n == count(shape));
+    }
+    Parameter(const Parameter& other) { *this = other; }
+    Parameter& operator=(const Parameter& other) {
+        shape = other.shape;
+        owned = other.owned;
+        ptr = other.owns() ? owned.data() : other.ptr;
+        n = other.n;
+        return *this;
+    }
+    Parameter(Parameter&&) = default; // The moved buffer keeps its address, so ptr stays valid
+    Parameter& operator=(Parameter&&) = default;
+
+    // Borrows `values`, which must outlive the parameter
+    static Parameter view(std::vector<int> shape, const float* values) {
+        Parameter p;
+        p.n = count(shape);
+        p.shape = std::move(shape);
+        p.ptr = values;
+        return p;
+    }
+
+    static size_t count(const std::vector<int>& shape) {
+        size_t size = 1;
+        for (int s : shape) size *= s;
+        return size;
+    }
+
+    const float* data() const { return ptr; }
+    size_t size() const { return n; }
+    bool empty() const { return n == 0; }
+    bool owns() const { return !owned.empty(); }
+
+    const float& operator[](size_t index) const { return ptr[index]; }
+
+private:
+    std::vector<float> owned;
+    const float* ptr = nullptr;
+    size_t n = 0;
+};
+
 #endif // TENSOR_H
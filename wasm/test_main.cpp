@@ -4,42 +4,1642 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <random>
+#include <new>
+#include <cstdlib>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <unordered_map>
+#include <chrono>
+#include <thread>
+
+// Counts heap allocations so hot paths can be checked to be allocation-free.
+// Every replaceable form is overridden so each path pairs malloc with free;
+// release() stays out of line so GCC does not match an inlined free()
+// against operator new (-Wmismatched-new-delete).
+static std::atomic<long long> g_allocations{0};
+
+[[gnu::noinline]] static void release(void* p) noexcept { std::free(p); }
+
+void* operator new(std::size_t size) {
+    ++g_allocations;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    ++g_allocations;
+    return std::malloc(size ? size : 1);
+}
+void* operator new[](std::size_t size) { return ::operator new(size); }
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept { return ::operator new(size, tag); }
+void operator delete(void* p) noexcept { release(p); }
+void operator delete(void* p, std::size_t) noexcept { release(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { release(p); }
+void operator delete[](void* p) noexcept { release(p); }
+void operator delete[](void* p, std::size_t) noexcept { release(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { release(p); }
+
+// Fill `game` with a random (not necessarily reachable) position
+static void random_position(ContrastGame& game, std::mt19937& rng) {
+    game.reset();
+    std::memset(game.pieces, 0, sizeof(game.pieces));
+
+    int squares[25];
+    for (int i = 0; i < 25; ++i) squares[i] = i;
+    std::shuffle(squares, squares + 25, rng);
+
+    int n1 = rng() % 6;
+    int n2 = rng() % 6;
+    for (int i = 0; i < n1 + n2; ++i) {
+        int sq = squares[i];
+        game.pieces[sq / 5][sq % 5] = (i < n1) ? P1 : P2;
+    }
+    for (int i = 0; i < 25; ++i) {
+        int r = rng() % 6; // Mostly white, like real games
+        game.tiles[i / 5][i % 5] = (r < 3) ? TILE_WHITE : (r < 5) ? TILE_BLACK : TILE_GRAY;
+    }
+    for (int p = 0; p < 2; ++p) {
+        game.tile_counts[p][0] = rng() % (INITIAL_BLACK_TILES + 1);
+        game.tile_counts[p][1] = rng() % (INITIAL_GRAY_TILES + 1);
+    }
+    game.current_player = (rng() & 1) ? P1 : P2;
+    game.sync_derived_state();
+}
+
+// Bitboard move generation must match the array engine exactly
+static bool test_bitboard_movegen(int positions) {
+    std::cout << "Checking bitboard move generation on " << positions << " positions..." << std::endl;
+    std::mt19937 rng(12345);
+    ContrastGame game;
+
+    for (int i = 0; i < positions; ++i) {
+        random_position(game, rng);
+
+        if (game.get_all_legal_actions() != game.scan_legal_actions()) {
+            std::cerr << "Action mismatch at position " << i << std::endl;
+            return false;
+        }
+        for (int sq = 0; sq < 25; ++sq) {
+            if (game.get_valid_moves(sq % 5, sq / 5) != game.scan_valid_moves(sq % 5, sq / 5)) {
+                std::cerr << "Move mismatch at position " << i << ", square " << sq << std::endl;
+                return false;
+            }
+        }
+
+        // Masks must stay in sync through step()
+        auto actions = game.get_all_legal_actions();
+        if (actions.empty()) continue;
+        game.step(actions[rng() % actions.size()]);
+        Bitboards before = game.bb;
+        game.sync_derived_state();
+        if (std::memcmp(&before, &game.bb, sizeof(Bitboards)) != 0) {
+            std::cerr << "Bitboards out of sync after step at position " << i << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Buffer-based generation and the early-exit check must not touch the heap
+static bool test_movegen_allocations(int positions) {
+    std::cout << "Checking allocation-free move generation..." << std::endl;
+    std::mt19937 rng(777);
+    ContrastGame game;
+    ActionList actions;
+
+    for (int i = 0; i < positions; ++i) {
+        random_position(game, rng);
+
+        long long before = g_allocations;
+        game.generate_legal_actions(actions);
+        bool any = game.has_any_legal_action();
+        if (g_allocations != before) {
+            std::cerr << "Move generation allocated at position " << i << std::endl;
+            return false;
+        }
+        if (any != !actions.empty()) {
+            std::cerr << "has_any_legal_action mismatch at position " << i << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Incremental Zobrist key must equal a full recompute along random playouts
+static bool test_zobrist(int games) {
+    std::cout << "Checking incremental Zobrist hashing on " << games << " random games..." << std::endl;
+    std::mt19937 rng(2024);
+    ActionList actions;
+
+    for (int g = 0; g < games; ++g) {
+        ContrastGame game;
+        while (!game.game_over && game.move_count < MAX_STEPS) {
+            game.generate_legal_actions(actions);
+            game.step(actions[rng() % actions.size()]);
+            if (game.zobrist != game.compute_zobrist()) {
+                std::cerr << "Zobrist mismatch in game " << g << " at move " << game.move_count << std::endl;
+                return false;
+            }
+        }
+    }
+
+    // Positions differing only in tile stock must not share a key
+    ContrastGame a, b;
+    b.tile_counts[0][0]--;
+    b.sync_derived_state();
+    if (a.get_board_hash() == b.get_board_hash()) {
+        std::cerr << "Tile stock not folded into the hash" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// copy() is a plain struct copy and step() no longer allocates history snapshots.
+// (The repetition table may still allocate once move 50 is reached.)
+static bool test_copy_and_history(int games) {
+    std::cout << "Checking ring-buffer history and copy()..." << std::endl;
+    std::mt19937 rng(99);
+    ActionList actions;
+
+    for (int g = 0; g < games; ++g) {
+        ContrastGame game;
+        while (!game.game_over && game.move_count < 48) {
+            game.generate_legal_actions(actions);
+            int a = actions[rng() % actions.size()];
+
+            long long before = g_allocations;
+            ContrastGame scratch = game.copy();
+            scratch.step(a);
+            if (g_allocations != before) {
+                std::cerr << "copy()+step() allocated in game " << g << std::endl;
+                return false;
+            }
+
+            game.step(a);
+            if (game.history.size() != std::min(game.move_count + 1, HISTORY_SIZE) ||
+                !(game.history[0] == scratch.history[0])) {
+                std::cerr << "History ring mismatch in game " << g << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool same_state(const ContrastGame& a, const ContrastGame& b) {
+    if (std::memcmp(a.pieces, b.pieces, sizeof(a.pieces)) != 0) return false;
+    if (std::memcmp(a.tiles, b.tiles, sizeof(a.tiles)) != 0) return false;
+    if (std::memcmp(a.tile_counts, b.tile_counts, sizeof(a.tile_counts)) != 0) return false;
+    if (std::memcmp(&a.bb, &b.bb, sizeof(Bitboards)) != 0) return false;
+    if (a.zobrist != b.zobrist || a.current_player != b.current_player) return false;
+    if (a.game_over != b.game_over || a.winner != b.winner || a.move_count != b.move_count) return false;
+    if (a.history.size() != b.history.size()) return false;
+    for (int i = 0; i < a.history.size(); ++i)
+        if (!(a.history[i] == b.history[i])) return false;
+    return a.position_history == b.position_history;
+}
+
+// unmake(make(a)) must restore every field, including the repetition table
+static bool test_make_unmake(int games) {
+    std::cout << "Checking make/unmake on " << games << " random games..." << std::endl;
+    std::mt19937 rng(31337);
+    ActionList actions;
+
+    for (int g = 0; g < games; ++g) {
+        ContrastGame game;
+        while (!game.game_over && game.move_count < MAX_STEPS) {
+            // Walk a random line down and back up
+            ContrastGame before = game;
+            UndoRecord line[8];
+            int depth = 1 + rng() % 8;
+            int made = 0;
+            for (; made < depth && !game.game_over; ++made) {
+                game.generate_legal_actions(actions);
+                line[made] = game.make(actions[rng() % actions.size()]);
+            }
+            while (made > 0) game.unmake(line[--made]);
+
+            if (!same_state(game, before)) {
+                std::cerr << "make/unmake mismatch in game " << g << " at move " << game.move_count << std::endl;
+                return false;
+            }
+
+            game.generate_legal_actions(actions);
+            game.step(actions[rng() % actions.size()]);
+        }
+    }
+    return true;
+}
+
+// Bounded table: fills up, then collect() keeps the pinned root and the most visited nodes
+static bool test_transposition_table() {
+    std::cout << "Checking transposition table replacement..." << std::endl;
+    TranspositionTable tt(1);
+    std::mt19937_64 rng(4242);
+    const uint64_t root_key = rng();
+
+    uint64_t inserted = 0;
+    std::vector<std::pair<uint64_t, int>> seen; // (key, visits)
+    for (int gen = 0; gen < 4; ++gen) {
+        tt.new_generation();
+        while (tt.can_insert()) {
+            uint64_t key = (inserted == 0) ? root_key : rng();
+            uint32_t idx = tt.insert(key, 1 + rng() % 200);
+            tt.node(idx).visits = rng() % 1000;
+            Edge* edges = tt.edges_of(tt.node(idx));
+            for (int e = 0; e < tt.node(idx).num_edges; ++e) edges[e] = {e, 0.0f, 0, 0.0f};
+            seen.push_back({key, tt.node(idx).visits});
+            inserted++;
+        }
+        tt.collect(root_key);
+        if (tt.occupancy() > TranspositionTable::KEEP_FRACTION + 1e-9) {
+            std::cerr << "collect() left the table too full: " << tt.occupancy() << std::endl;
+            return false;
+        }
+    }
+
+    if (tt.find(root_key) == NO_NODE) {
+        std::cerr << "Pinned root was evicted" << std::endl;
+        return false;
+    }
+    // Every surviving node must still resolve and keep its own edges
+    for (auto& kv : seen) {
+        uint32_t idx = tt.find(kv.first);
+        if (idx == NO_NODE) continue;
+        const Node& n = tt.node(idx);
+        if (n.key != kv.first || (kv.first != root_key && n.visits != kv.second)) return false;
+        const Edge* edges = tt.edges_of(n);
+        for (int e = 0; e < n.num_edges; ++e)
+            if (edges[e].action != e) {
+                std::cerr << "Edge span corrupted by compaction" << std::endl;
+                return false;
+            }
+    }
+    if (tt.stats.evictions + tt.size() != inserted) {
+        std::cerr << "Eviction count mismatch" << std::endl;
+        return false;
+    }
+    std::cout << "  " << inserted << " inserts, " << tt.stats.evictions << " evictions, hit rate "
+              << tt.stats.hit_rate() << ", " << (tt.memory_bytes() >> 10) << " KB" << std::endl;
+
+    // A node left unvisited for 256 searches is old, not current again
+    tt.clear();
+    uint32_t stale = tt.insert(rng(), 1);
+    tt.node(stale).visits = 1000;
+    for (int gen = 0; gen < 256; ++gen) tt.new_generation();
+    uint64_t stale_key = tt.node(stale).key;
+    while (tt.can_insert()) tt.insert(rng(), 1);
+    tt.collect(root_key);
+    if (tt.find(stale_key) != NO_NODE) {
+        std::cerr << "Generation tag wrapped: a stale node was kept as current" << std::endl;
+        return false;
+    }
+
+    // Concurrent inserts into a nearly full table never hand out a span twice
+    // or push the pools past their capacity
+    for (int round = 0; round < 20; ++round) {
+        tt.clear();
+        std::vector<std::vector<uint32_t>> owned(4);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t)
+            threads.emplace_back([&, t] {
+                std::mt19937_64 trng(round * 4 + t);
+                bool owner;
+                for (uint32_t idx; (idx = tt.insert_shared(trng() % 4096, 1 + trng() % 200, owner)) != NO_NODE;)
+                    if (owner) owned[t].push_back(idx);
+            });
+        for (auto& th : threads) th.join();
+        std::vector<std::pair<uint32_t, uint32_t>> spans;
+        for (auto& list : owned)
+            for (uint32_t idx : list)
+                spans.push_back({tt.node(idx).first_edge, tt.node(idx).num_edges});
+        std::sort(spans.begin(), spans.end());
+        for (size_t i = 1; i < spans.size(); ++i)
+            if (spans[i - 1].first + spans[i - 1].second > spans[i].first) {
+                std::cerr << "insert_shared() handed out overlapping edge spans" << std::endl;
+                return false;
+            }
+        if (tt.size() > tt.capacity() || (!spans.empty() && spans.back().first + spans.back().second >
+                                                                tt.capacity() * TranspositionTable::AVG_EDGES_PER_NODE)) {
+            std::cerr << "insert_shared() allocated past the pool capacity" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Batched forward must match per-position forwards, and batched search must
+// leave consistent statistics with all virtual loss refunded
+static bool test_batched_search(ContrastDualPolicyNet& net) {
+    std::cout << "Checking batched inference and virtual-loss search..." << std::endl;
+    std::mt19937 rng(5150);
+    ContrastGame a, b;
+    for (int i = 0; i < 7; ++i) {
+        auto actions = b.get_all_legal_actions();
+        b.step(actions[rng() % actions.size()]);
+    }
+
+    Tensor batch({2, ENCODED_PLANES, 5, 5});
+    a.encode_state_into(&batch.data[0]);
+    b.encode_state_into(&batch.data[ENCODED_STATE_SIZE]);
+    auto out = net.forward(batch);
+    auto out_a = net.forward(a.encode_state());
+    auto out_b = net.forward(b.encode_state());
+    if (std::fabs(out.values[0] - out_a.value) > 1e-5f || std::fabs(out.values[1] - out_b.value) > 1e-5f ||
+        std::fabs(out.move_logits[625 + 17] - out_b.move_logits[17]) > 1e-4f) {
+        std::cerr << "Batched forward differs from single forward" << std::endl;
+        return false;
+    }
+
+    MCTS mcts(&net);
+    mcts.batch_size = 8;
+    ContrastGame game;
+    const int sims = 64;
+    mcts.search(game, sims);
+
+    const Node& root = mcts.tree.node(mcts.find_node(mcts.get_key(game)));
+    if (root.visits != sims) {
+        std::cerr << "Batched search ran " << root.visits << " of " << sims << " simulations" << std::endl;
+        return false;
+    }
+    for (size_t i = 0; i < mcts.tree.size(); ++i) {
+        const Node& n = mcts.tree.node(i);
+        const Edge* edges = mcts.tree.edges_of(n);
+        int visits = 0;
+        for (int e = 0; e < n.num_edges; ++e) {
+            visits += edges[e].visits;
+            if (std::fabs(edges[e].value_sum) > edges[e].visits + 1e-3f) {
+                std::cerr << "Virtual loss left on an edge" << std::endl;
+                return false;
+            }
+        }
+        if (visits != n.visits) {
+            std::cerr << "Node visits do not match its edges" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Random conv layer with He-scaled weights, so outputs have realistic magnitudes
+static Conv2d random_conv(std::mt19937& rng, int in_c, int out_c, int k, int stride, int pad) {
+    Conv2d conv(in_c, out_c, k, stride, pad);
+    std::normal_distribution<float> w_dist(0.0f, std::sqrt(2.0f / (in_c * k * k)));
+    std::uniform_real_distribution<float> b_dist(-0.1f, 0.1f);
+    std::vector<float> w(out_c * in_c * k * k), b(out_c);
+    for (auto& x : w) x = w_dist(rng);
+    for (auto& x : b) x = b_dist(rng);
+    conv.load_weights(w, b);
+    return conv;
+}
+
+static Tensor random_input(std::mt19937& rng, int n, int c, int h, int w) {
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+    Tensor t({n, c, h, w});
+    for (auto& x : t.data) x = dist(rng);
+    return t;
+}
+
+// The im2col + GEMM convolution matches the direct convolution
+static bool test_conv_gemm() {
+    std::cout << "Checking im2col/GEMM convolution against the direct one..." << std::endl;
+    struct Shape { int in_c, out_c, k, stride, pad; };
+    const Shape shapes[] = {
+        {66, 64, 3, 1, 1}, // Input conv
+        {64, 64, 3, 1, 1}, // Residual blocks
+        {64, 32, 1, 1, 0}, // Heads
+        {64, 16, 1, 1, 0},
+        {64, 4, 1, 1, 0},
+        {3, 5, 3, 2, 0},   // Odd sizes: partial GEMM tiles, stride, no padding
+        {300, 70, 1, 1, 0}, // K and M spanning several cache blocks
+    };
+    std::mt19937 rng(2024);
+    for (const Shape& s : shapes) {
+        Conv2d conv = random_conv(rng, s.in_c, s.out_c, s.k, s.stride, s.pad);
+        for (int n : {1, 3, 32}) {
+            Tensor x = random_input(rng, n, s.in_c, 5, 5);
+            Tensor got = conv.forward(x);
+            Tensor want = conv.forward_reference(x);
+            if (got.shape != want.shape) {
+                std::cerr << "GEMM conv output shape differs" << std::endl;
+                return false;
+            }
+            float max_err = 0.0f;
+            for (int i = 0; i < got.size(); ++i) max_err = std::max(max_err, std::fabs(got[i] - want[i]));
+            if (max_err > 1e-5f) {
+                std::cerr << "GEMM conv " << s.in_c << "->" << s.out_c << " k" << s.k << " N=" << n
+                          << " differs by " << max_err << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Winograd convolutions match the direct one
+static bool test_winograd() {
+    std::cout << "Checking Winograd convolutions..." << std::endl;
+    struct Shape { int in_c, out_c, pad, h, w; };
+    const Shape shapes[] = {
+        {66, 64, 1, 5, 5}, // Input conv
+        {64, 64, 1, 5, 5}, // Residual blocks
+        {3, 5, 0, 7, 6},   // Unpadded, non-square
+        {8, 9, 1, 9, 4},   // Several tiles in one direction
+    };
+    std::mt19937 rng(4096);
+    for (ConvAlgo algo : {CONV_WINOGRAD_2X2, CONV_WINOGRAD_4X4}) {
+        const char* name = (algo == CONV_WINOGRAD_2X2) ? "F(2x2,3x3)" : "F(4x4,3x3)";
+        float worst = 0.0f;
+        for (const Shape& s : shapes) {
+            Conv2d conv = random_conv(rng, s.in_c, s.out_c, 3, 1, s.pad);
+            if (!conv.set_algorithm(algo)) {
+                std::cerr << name << " rejected a stride-1 3x3 conv" << std::endl;
+                return false;
+            }
+            for (int n : {1, 4}) {
+                Tensor x = random_input(rng, n, s.in_c, s.h, s.w);
+                Tensor got = conv.forward(x);
+                Tensor want = conv.forward_reference(x);
+                if (got.shape != want.shape) {
+                    std::cerr << name << " output shape differs" << std::endl;
+                    return false;
+                }
+                for (int i = 0; i < got.size(); ++i) worst = std::max(worst, std::fabs(got[i] - want[i]));
+            }
+        }
+        std::cout << "  " << name << " max error " << worst << std::endl;
+        if (worst > 1e-4f) {
+            std::cerr << name << " differs from the direct convolution by " << worst << std::endl;
+            return false;
+        }
+    }
+
+    Conv2d strided = random_conv(rng, 4, 4, 3, 2, 1);
+    Conv2d pointwise = random_conv(rng, 4, 4, 1, 1, 0);
+    if (strided.set_algorithm(CONV_WINOGRAD_2X2) || pointwise.set_algorithm(CONV_WINOGRAD_4X4) ||
+        strided.algo != CONV_GEMM || pointwise.algo != CONV_GEMM) {
+        std::cerr << "Winograd accepted an unsupported convolution" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// The fixed 5x5 geometry kernels give exactly the generic results, for every
+// algorithm, and encode_state_into() matches the reference encoder
+static bool test_fixed_geometry(int games) {
+    std::cout << "Checking fixed-geometry kernels..." << std::endl;
+    struct Shape { int in_c, out_c, k, stride, pad; };
+    const Shape shapes[] = {
+        {66, 64, 3, 1, 1}, // Input conv
+        {24, 24, 3, 1, 1}, // Channels not a whole int8 vector
+        {64, 32, 1, 1, 0}, // Heads
+        {3, 5, 3, 2, 0},   // Not "same": falls back to the generic kernels
+    };
+    std::mt19937 rng(19);
+    for (const Shape& s : shapes) {
+        Conv2d conv = random_conv(rng, s.in_c, s.out_c, s.k, s.stride, s.pad);
+        conv.quant.begin_calibration();
+        conv.forward(random_input(rng, 4, s.in_c, 5, 5));
+        conv.quant.end_calibration();
+        for (ConvAlgo algo : {CONV_GEMM, CONV_WINOGRAD_2X2, CONV_WINOGRAD_4X4, CONV_INT8}) {
+            if (!conv.set_algorithm(algo)) continue;
+            for (int n : {1, 3}) {
+                Tensor x = random_input(rng, n, s.in_c, 5, 5);
+                Tensor res = random_input(rng, n, s.out_c, conv.out_size(5), conv.out_size(5));
+                Tensor fixed(res.shape), generic(res.shape);
+                Arena arena(conv.workspace(n, 5, 5));
+                conv.forward_into<0, 0, 5, 5>(x.data.data(), n, 5, 5, fixed.data.data(), arena, true, res.data.data());
+                conv.forward_into(x.data.data(), n, 5, 5, generic.data.data(), arena, true, res.data.data());
+                if (fixed.data != generic.data) {
+                    std::cerr << "Fixed-geometry conv " << s.in_c << "->" << s.out_c << " k" << s.k << " algo "
+                              << algo << " N=" << n << " differs from the generic one" << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+
+    ActionList actions;
+    std::vector<float> got(ENCODED_STATE_SIZE), want(ENCODED_STATE_SIZE);
+    for (int g = 0; g < games; ++g) {
+        ContrastGame game;
+        while (!game.game_over && game.move_count < 60) {
+            game.encode_state_into(got.data());
+            game.encode_state_reference_into(want.data());
+            if (got != want) {
+                std::cerr << "encode_state_into() differs from the reference in game " << g << " at move "
+                          << game.move_count << std::endl;
+                return false;
+            }
+            game.generate_legal_actions(actions);
+            game.step(actions[rng() % actions.size()]);
+        }
+    }
+    return true;
+}
+
+// Every SIMD variant available on this machine matches the scalar kernels
+static bool test_simd_kernels() {
+    std::cout << "Checking SIMD kernel variants..." << std::endl;
+    std::mt19937 rng(77);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    auto random_vec = [&](int n) {
+        std::vector<float> v(n);
+        for (auto& x : v) x = dist(rng);
+        return v;
+    };
+
+    for (const SimdKernels* k : simd_available()) {
+        std::cout << "  " << k->name << std::endl;
+
+        // GEMM with full and partial tiles and several KC blocks
+        for (int M : {1, 7, 64}) {
+            for (int N : {1, 25, 37, 800}) {
+                for (int K : {3, 300, 576}) {
+                    auto A = random_vec(M * K), B = random_vec(K * N);
+                    std::vector<float> C(M * N, 123.0f);
+                    sgemm(M, N, K, A.data(), K, B.data(), N, C.data(), N, *k);
+                    for (int i = 0; i < M; ++i) {
+                        for (int j = 0; j < N; ++j) {
+                            double want = 0.0;
+                            for (int p = 0; p < K; ++p) want += (double)A[i * K + p] * B[p * N + j];
+                            if (std::fabs(C[i * N + j] - want) > 1e-4 * std::sqrt((double)K)) {
+                                std::cerr << k->name << " sgemm " << M << "x" << N << "x" << K << " differs" << std::endl;
+                                return false;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        for (int n : {1, 7, 8, 25, 33, 800}) {
+            auto a = random_vec(n), b = random_vec(n);
+            if (std::fabs(k->dot(a.data(), b.data(), n) - SIMD_SCALAR.dot(a.data(), b.data(), n)) > 1e-5f * n) {
+                std::cerr << k->name << " dot differs (n=" << n << ")" << std::endl;
+                return false;
+            }
+
+            std::vector<float> got(n), want(n);
+            k->add_bias(got.data(), a.data(), 0.25f, n);
+            SIMD_SCALAR.add_bias(want.data(), a.data(), 0.25f, n);
+            bool same = got == want;
+
+            got = a;
+            want = a;
+            k->relu(got.data(), n);
+            SIMD_SCALAR.relu(want.data(), n);
+            same = same && got == want;
+
+            got = a;
+            want = a;
+            k->add(got.data(), b.data(), n);
+            SIMD_SCALAR.add(want.data(), b.data(), n);
+            same = same && got == want;
+
+            const float* residuals[] = {nullptr, b.data()};
+            for (bool relu : {false, true}) {
+                for (const float* residual : residuals) {
+                    k->epilogue(got.data(), a.data(), -0.25f, residual, relu, n);
+                    for (int i = 0; i < n; ++i) {
+                        float y = a[i] - 0.25f + (residual ? residual[i] : 0.0f);
+                        want[i] = relu ? std::max(y, 0.0f) : y;
+                    }
+                    same = same && got == want;
+                }
+            }
+
+            if (!same) {
+                std::cerr << k->name << " elementwise kernel differs (n=" << n << ")" << std::endl;
+                return false;
+            }
+
+            // Softmax against the scalar one (std::exp), over logits spread
+            // wide enough that some underflow to the clamp
+            for (float spread : {1.0f, 30.0f, 200.0f}) {
+                got = a;
+                for (auto& x : got) x *= spread;
+                want = got;
+                k->softmax(got.data(), n);
+                SIMD_SCALAR.softmax(want.data(), n);
+                float sum = 0.0f;
+                for (int i = 0; i < n; ++i) {
+                    sum += got[i];
+                    if (std::fabs(got[i] - want[i]) > 1e-6f * want[i] + 1e-30f) {
+                        std::cerr << k->name << " softmax differs (n=" << n << ", spread " << spread << "): "
+                                  << got[i] << " vs " << want[i] << std::endl;
+                        return false;
+                    }
+                }
+                if (std::fabs(sum - 1.0f) > 1e-5f) {
+                    std::cerr << k->name << " softmax sums to " << sum << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// MCTS::order_by_prior matches a stable descending sort on both of its
+// paths, ties included
+static bool test_prior_order() {
+    std::cout << "Checking prior ordering..." << std::endl;
+    std::mt19937 rng(24);
+    std::gamma_distribution<float> gamma(0.3f, 1.0f);
+    for (int n : {1, 2, 13, 63, 64, 177, 600, MAX_ACTIONS}) {
+        std::vector<float> priors(n);
+        for (auto& p : priors) p = gamma(rng) + 1e-7f;
+        for (int i = 0; i + 1 < n; i += 7) priors[i + 1] = priors[i]; // Ties
+        std::vector<uint16_t> order(n);
+        MCTS::order_by_prior(priors.data(), n, order.data());
+        std::vector<int> want(n);
+        for (int i = 0; i < n; ++i) want[i] = i;
+        std::sort(want.begin(), want.end(),
+                  [&](int a, int b) { return priors[a] != priors[b] ? priors[a] > priors[b] : a < b; });
+        if (!std::equal(want.begin(), want.end(), order.begin())) {
+            std::cerr << "order_by_prior differs from a stable sort (n=" << n << ")" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// The action decode and flip tables against the arithmetic they replace,
+// over the whole action space
+static bool test_action_tables() {
+    std::cout << "Checking action decode tables..." << std::endl;
+    for (int a = 0; a < NUM_MOVES * NUM_TILES; ++a) {
+        int move_idx = a / 51, tile_idx = a % 51;
+        int from = move_idx / 25, to = move_idx % 25;
+        int color = tile_idx == 0 ? TILE_WHITE : tile_idx <= 25 ? TILE_BLACK : TILE_GRAY;
+        int square = tile_idx == 0 ? 0 : tile_idx <= 25 ? tile_idx - 1 : tile_idx - 26;
+        int flipped_tile = tile_idx == 0 ? 0 : tile_idx <= 25 ? (24 - square) + 1 : (24 - square) + 26;
+        int flipped = ((24 - from) * 25 + (24 - to)) * 51 + flipped_tile;
+
+        DecodedAction d = decode_action(a);
+        if (d.from != from || d.to != to || d.tile_color != color || (color != TILE_WHITE && d.tile_square != square)) {
+            std::cerr << "decode_action(" << a << ") differs" << std::endl;
+            return false;
+        }
+        if (flip_action(a) != flipped || flip_action(flipped) != a) {
+            std::cerr << "flip_action(" << a << ") = " << flip_action(a) << ", expected " << flipped << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// The whole network gives the same outputs under every SIMD variant
+static bool test_simd_network(ContrastDualPolicyNet& net) {
+    std::cout << "Checking network output across SIMD variants..." << std::endl;
+    std::mt19937 rng(99);
+    ContrastGame game;
+    Tensor batch({4, ENCODED_PLANES, 5, 5});
+    for (int i = 0; i < 4; ++i) {
+        game.encode_state_into(&batch.data[i * ENCODED_STATE_SIZE]);
+        auto actions = game.get_all_legal_actions();
+        game.step(actions[rng() % actions.size()]);
+    }
+
+    const SimdKernels* saved = &simd_kernels();
+    simd_set_kernels(&SIMD_SCALAR);
+    auto want = net.forward(batch);
+    bool ok = true;
+    for (const SimdKernels* k : simd_available()) {
+        simd_set_kernels(k);
+        auto got = net.forward(batch);
+        float max_err = 0.0f;
+        for (int i = 0; i < got.move_logits.size(); ++i)
+            max_err = std::max(max_err, std::fabs(got.move_logits[i] - want.move_logits[i]));
+        for (int i = 0; i < got.tile_logits.size(); ++i)
+            max_err = std::max(max_err, std::fabs(got.tile_logits[i] - want.tile_logits[i]));
+        for (size_t i = 0; i < got.values.size(); ++i)
+            max_err = std::max(max_err, std::fabs(got.values[i] - want.values[i]));
+        if (max_err > 1e-4f) {
+            std::cerr << k->name << " network output differs from scalar by " << max_err << std::endl;
+            ok = false;
+        }
+    }
+    simd_set_kernels(saved);
+    return ok;
+}
+
+// Bias + residual + ReLU fused into the convolution epilogue match the
+// separate passes, for every algorithm and both epilogue paths (GEMM scatter
+// at N > 1, in-place at N = 1)
+static bool test_fused_epilogues() {
+    std::cout << "Checking fused convolution epilogues..." << std::endl;
+    std::mt19937 rng(31);
+    for (ConvAlgo algo : {CONV_GEMM, CONV_WINOGRAD_2X2, CONV_WINOGRAD_4X4}) {
+        Conv2d conv = random_conv(rng, 16, 8, 3, 1, 1);
+        conv.set_algorithm(algo);
+        for (int n : {1, 3}) {
+            Tensor x = random_input(rng, n, 16, 5, 5);
+            Tensor res = random_input(rng, n, 8, 5, 5);
+            Tensor want = conv.forward_reference(x);
+            for (int i = 0; i < want.size(); ++i) want[i] = std::max(want[i] + res[i], 0.0f);
+
+            Tensor got({n, 8, 5, 5});
+            Arena arena(conv.workspace(n, 5, 5));
+            conv.forward_into(x.data.data(), n, 5, 5, got.data.data(), arena, true, res.data.data());
+            for (int i = 0; i < want.size(); ++i) {
+                if (std::fabs(got[i] - want[i]) > 1e-4f) {
+                    std::cerr << "Fused conv epilogue differs (algo " << algo << ", N=" << n << ")" << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+
+    // A fused head equals conv -> relu -> Linear -> relu done layer by layer
+    Conv2d conv = random_conv(rng, 8, 4, 1, 1, 0);
+    std::normal_distribution<float> dist(0.0f, 0.2f);
+    std::vector<float> w(100 * 7), b(7);
+    for (auto& v : w) v = dist(rng);
+    for (auto& v : b) v = dist(rng);
+    Linear fc(100, 7);
+    fc.load_weights(w, b);
+    for (int n : {1, 4}) {
+        Tensor x = random_input(rng, n, 8, 5, 5);
+        Tensor hidden = relu(conv.forward_reference(x));
+        hidden.shape = {n, 100};
+        Tensor want = relu(fc.forward(hidden));
+
+        std::vector<float> got(n * 7);
+        Arena arena(conv_relu_linear_workspace(conv, fc, n, 5, 5));
+        conv_relu_linear(conv, fc, x.data.data(), n, 5, 5, got.data(), arena, true);
+        for (int i = 0; i < n * 7; ++i) {
+            if (std::fabs(got[i] - want[i]) > 1e-4f) {
+                std::cerr << "Fused conv+linear head differs (N=" << n << ")" << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// INT8 path: exact integer kernels across SIMD variants, quantized layers
+// close to fp32, and a calibrated network close to fp32 without allocating
+static bool test_int8(ContrastDualPolicyNet& net) {
+    std::cout << "Checking INT8 inference..." << std::endl;
+    std::mt19937 rng(8);
+
+    for (const SimdKernels* k : simd_available()) {
+        for (int n : {16, 64, 592}) {
+            std::vector<int16_t> x(n), w(4 * n + 3);
+            for (auto& v : x) v = rng() % (QUANT_ACT_MAX + 1);
+            for (auto& v : w) v = (int)(rng() % (2 * QUANT_WEIGHT_MAX + 1)) - QUANT_WEIGHT_MAX;
+            int32_t got[4], want[4];
+            k->dot4_i16(x.data(), w.data(), n + 1, n, got); // Odd stride: unaligned rows
+            SIMD_SCALAR.dot4_i16(x.data(), w.data(), n + 1, n, want);
+            if (!std::equal(got, got + 4, want)) {
+                std::cerr << k->name << " dot4_i16 differs (n=" << n << ")" << std::endl;
+                return false;
+            }
+        }
+    }
+
+    struct Shape { int in_c, out_c, k, stride, pad; };
+    const Shape shapes[] = {{66, 64, 3, 1, 1}, {64, 64, 3, 1, 1}, {64, 32, 1, 1, 0}, {20, 6, 1, 1, 0}, {8, 5, 3, 2, 1}};
+    for (const Shape& sh : shapes) {
+        Conv2d conv = random_conv(rng, sh.in_c, sh.out_c, sh.k, sh.stride, sh.pad);
+        Tensor x = random_input(rng, 3, sh.in_c, 5, 5);
+        Tensor want = conv.forward_reference(x);
+        conv.quant.begin_calibration();
+        conv.forward(x);
+        conv.quant.end_calibration();
+        if (!conv.set_algorithm(CONV_INT8)) {
+            std::cerr << "Calibrated conv rejected CONV_INT8" << std::endl;
+            return false;
+        }
+        Tensor got = conv.forward(x);
+        float max_out = 0.0f, max_err = 0.0f;
+        for (int i = 0; i < want.size(); ++i) {
+            max_out = std::max(max_out, std::fabs(want[i]));
+            max_err = std::max(max_err, std::fabs(got[i] - want[i]));
+        }
+        if (max_err > 0.02f * max_out) {
+            std::cerr << "INT8 conv " << sh.in_c << "->" << sh.out_c << " k" << sh.k << " error " << max_err
+                      << " of " << max_out << std::endl;
+            return false;
+        }
+    }
+
+    // Whole network, calibrated on one set of positions and checked on another
+    auto encode_playouts = [&](int count) {
+        std::vector<float> planes((size_t)count * ENCODED_STATE_SIZE);
+        ContrastGame game;
+        for (int i = 0; i < count; ++i) {
+            if (game.game_over || game.move_count >= MAX_STEPS) game.reset();
+            game.encode_state_into(&planes[(size_t)i * ENCODED_STATE_SIZE]);
+            auto actions = game.get_all_legal_actions();
+            game.step(actions[rng() % actions.size()]);
+        }
+        return planes;
+    };
+    std::vector<float> calib = encode_playouts(64), check = encode_playouts(8);
+    if (net.set_int8(true)) {
+        std::cerr << "Uncalibrated network accepted int8" << std::endl;
+        return false;
+    }
+    ContrastDualPolicyNet::Output want, got;
+    Arena arena;
+    net.forward(check.data(), 8, want, arena);
+    net.calibrate(calib.data(), 64);
+    if (!net.set_int8(true)) {
+        std::cerr << "Calibrated network rejected int8" << std::endl;
+        return false;
+    }
+    net.forward(check.data(), 8, got, arena);
+    long long before = g_allocations;
+    net.forward(check.data(), 8, got, arena);
+    net.forward(check.data(), 1, got, arena);
+    bool ok = g_allocations == before;
+    if (!ok) std::cerr << "INT8 forward pass allocated" << std::endl;
+    net.forward(check.data(), 8, got, arena);
+
+    float max_logit = 0.0f, logit_err = 0.0f, value_err = 0.0f;
+    for (int i = 0; i < want.move_logits.size(); ++i) {
+        max_logit = std::max(max_logit, std::fabs(want.move_logits[i]));
+        logit_err = std::max(logit_err, std::fabs(got.move_logits[i] - want.move_logits[i]));
+    }
+    for (int n = 0; n < 8; ++n) value_err = std::max(value_err, std::fabs(got.values[n] - want.values[n]));
+    if (logit_err > 0.05f * max_logit || value_err > 0.05f) {
+        std::cerr << "INT8 network differs from fp32: logits " << logit_err << " of " << max_logit << ", value "
+                  << value_err << std::endl;
+        ok = false;
+    }
+
+    net.set_int8(false);
+    net.forward(check.data(), 8, got, arena);
+    if (got.move_logits.data != want.move_logits.data) {
+        std::cerr << "Network did not return to fp32" << std::endl;
+        ok = false;
+    }
+    return ok;
+}
+
+// Networks of other shapes build from their architecture, and the compiled
+// fast path matches the generic one
+static bool test_architectures(ContrastDualPolicyNet& net) {
+    std::cout << "Checking network architectures..." << std::endl;
+    std::mt19937 rng(18);
+    std::normal_distribution<float> normal(0.0f, 0.05f);
+    Tensor batch = random_input(rng, 3, ENCODED_PLANES, 5, 5);
+    bool ok = true;
+
+    ModelArch small_arch;
+    small_arch.res_blocks = 2;
+    small_arch.filters = 24;
+    small_arch.move_head_filters = 8;
+    small_arch.value_hidden = 16;
+    for (const ModelArch& arch : {net.arch(), small_arch}) {
+        ContrastDualPolicyNet n(arch);
+        for (const auto& spec : ContrastDualPolicyNet::layer_specs(arch)) {
+            for (const auto& l : n.named_layers()) {
+                if (l.name != spec.name) continue;
+                std::vector<float> w(Parameter::count(spec.weight_shape)), b(spec.bias_shape[0]);
+                for (auto& v : w) v = normal(rng);
+                for (auto& v : b) v = normal(rng);
+                if (l.conv) l.conv->load_weights(w, b);
+                else l.fc->load_weights(w, b);
+            }
+        }
+        if (n.has_fast_path() != (arch == net.arch())) {
+            std::cerr << "Unexpected fast path selection for " << arch.describe() << std::endl;
+            ok = false;
+        }
+        for (ConvAlgo algo : {CONV_GEMM, CONV_WINOGRAD_2X2, CONV_WINOGRAD_4X4}) {
+            n.set_backbone_algorithm(algo);
+            ContrastDualPolicyNet::Output fast, generic;
+            n.use_fast_path = true;
+            n.forward(batch.data.data(), 3, fast);
+            n.use_fast_path = false;
+            n.forward(batch.data.data(), 3, generic);
+            if (fast.move_logits.data != generic.move_logits.data || fast.values != generic.values) {
+                std::cerr << "Fast path differs from generic (algo " << algo << ")" << std::endl;
+                ok = false;
+            }
+            if ((int)fast.move_logits.size() != 3 * arch.move_actions || fast.values.size() != 3) ok = false;
+        }
+    }
+    return ok;
+}
+
+// Model files round-trip through save_to_file(), the int8 variant is about a
+// quarter of the size, and damaged or mismatched files are rejected without
+// touching the loaded weights
+static bool test_model_file(ContrastDualPolicyNet& net) {
+    std::cout << "Checking model files..." << std::endl;
+    std::string dir = std::filesystem::temp_directory_path().string();
+    std::string fp32_path = dir + "/contrast_test_fp32.bin", int8_path = dir + "/contrast_test_int8.bin";
+    std::string bad_path = dir + "/contrast_test_bad.bin";
+    std::mt19937 rng(17);
+    Tensor batch = random_input(rng, 4, ENCODED_PLANES, 5, 5);
+    ContrastDualPolicyNet::Output want, got;
+    net.forward(batch.data.data(), 4, want);
+
+    bool ok = true;
+    auto fail = [&](const std::string& what) {
+        std::cerr << what << std::endl;
+        ok = false;
+    };
+    auto max_diff = [](const ContrastDualPolicyNet::Output& a, const ContrastDualPolicyNet::Output& b) {
+        float d = 0.0f;
+        for (int i = 0; i < a.move_logits.size(); ++i) d = std::max(d, std::fabs(a.move_logits[i] - b.move_logits[i]));
+        for (int i = 0; i < a.tile_logits.size(); ++i) d = std::max(d, std::fabs(a.tile_logits[i] - b.tile_logits[i]));
+        for (size_t i = 0; i < a.values.size(); ++i) d = std::max(d, std::fabs(a.values[i] - b.values[i]));
+        return d;
+    };
+    auto write_bytes = [&](const std::vector<uint8_t>& bytes) {
+        std::ofstream f(bad_path, std::ios::binary);
+        f.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    };
+
+    if (!net.save_to_file(fp32_path) || !net.save_to_file(int8_path, true)) return false;
+
+    ContrastDualPolicyNet copy;
+    if (!copy.load_from_file(fp32_path)) return false;
+    copy.forward(batch.data.data(), 4, got);
+    if (max_diff(got, want) != 0.0f) fail("Reloaded fp32 model differs");
+#if MODEL_FILE_MMAP
+    if (copy.conv_input->weight.owns() || copy.move_fc->weight.owns()) fail("Mapped weights were copied");
+#endif
+
+    // Int8 weights: dequantized for fp32, and the stored activation scales
+    // make int8 available without calibrating again
+    ContrastDualPolicyNet small;
+    if (!small.load_from_file(int8_path)) return false;
+    size_t fp32_bytes = std::filesystem::file_size(fp32_path), int8_bytes = std::filesystem::file_size(int8_path);
+    if (int8_bytes * 3 > fp32_bytes) fail("Int8 model file is not much smaller");
+    small.forward(batch.data.data(), 4, got);
+    float max_logit = 0.0f;
+    for (int i = 0; i < want.move_logits.size(); ++i) max_logit = std::max(max_logit, std::fabs(want.move_logits[i]));
+    if (max_diff(got, want) > 0.05f * std::max(max_logit, 1.0f)) fail("Int8 model file differs from fp32");
+    if (!small.set_int8(true) || !net.set_int8(true)) {
+        fail("Int8 model file lost its activation scales");
+    } else {
+        ContrastDualPolicyNet::Output want_q;
+        net.forward(batch.data.data(), 4, want_q);
+        small.forward(batch.data.data(), 4, got);
+        if (max_diff(got, want_q) > 1e-4f * std::max(max_logit, 1.0f)) fail("Int8 weights changed on reload");
+    }
+    net.set_int8(false);
+
+    // Each damaged file fails with a message naming the problem
+    std::ifstream in(fp32_path, std::ios::binary);
+    std::vector<uint8_t> good((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    struct Case { const char* what; std::function<void(std::vector<uint8_t>&)> damage; const char* expect; };
+    const Case cases[] = {
+        {"truncated", [](std::vector<uint8_t>& b) { b.resize(b.size() - 100); }, "truncated"},
+        {"corrupted", [](std::vector<uint8_t>& b) { b[b.size() / 2] ^= 0x40; }, "checksum"},
+        {"newer version", [](std::vector<uint8_t>& b) { b[8] = 2; }, "version"},
+        {"not a model", [](std::vector<uint8_t>& b) { b.assign(1000, 0x7f); }, "not a model"},
+        {"missing", [](std::vector<uint8_t>& b) { b.clear(); }, "cannot open"},
+    };
+    for (const Case& c : cases) {
+        std::vector<uint8_t> bytes = good;
+        c.damage(bytes);
+        std::filesystem::remove(bad_path);
+        if (c.expect != std::string("cannot open")) write_bytes(bytes);
+        if (copy.load_from_file(bad_path) || copy.load_error.find(c.expect) == std::string::npos)
+            fail(std::string("Damaged model file (") + c.what + ") gave: " + copy.load_error);
+    }
+    {
+        // Tensors that do not fit the architecture section
+        ModelArch arch = net.arch();
+        arch.filters = 48;
+        ModelFileWriter writer(arch);
+        for (const auto& l : net.named_layers()) {
+            const Parameter& w = l.conv ? l.conv->weight : l.fc->weight;
+            const Parameter& b = l.conv ? l.conv->bias : l.fc->bias;
+            writer.add(l.name + "_w", w.shape, w.data());
+            writer.add(l.name + "_b", b.shape, b.data());
+        }
+        write_bytes(writer.bytes());
+        if (copy.load_from_file(bad_path) || copy.load_error.find("input_conv_w has shape") == std::string::npos)
+            fail("Tensors not matching the architecture gave: " + copy.load_error);
+    }
+    {
+        // A header whose architecture would need absurd layers
+        ModelArch arch = net.arch();
+        arch.filters = 65536;
+        write_bytes(ModelFileWriter(arch).bytes());
+        if (copy.load_from_file(bad_path) || copy.load_error.find("filters is 65536") == std::string::npos)
+            fail("Oversized architecture gave: " + copy.load_error);
+
+        // A shape whose byte count wraps to the declared 0 bytes, with a valid checksum
+        std::vector<uint8_t> bytes = good;
+        ModelTensorEntry e;
+        size_t at = sizeof(ModelFileHeader) + sizeof(ModelArch);
+        std::memcpy(&e, &bytes[at], sizeof(e));
+        e.ndims = 4;
+        for (int d = 0; d < 4; ++d) e.dims[d] = 65536;
+        e.bytes = 0;
+        std::memcpy(&bytes[at], &e, sizeof(e));
+        ModelFileHeader h;
+        std::memcpy(&h, bytes.data(), sizeof(h));
+        h.checksum = crc32(bytes.data() + sizeof(h), bytes.size() - sizeof(h));
+        std::memcpy(bytes.data(), &h, sizeof(h));
+        write_bytes(bytes);
+        if (copy.load_from_file(bad_path) || copy.load_error.find("larger than the file") == std::string::npos)
+            fail("Overflowing tensor shape gave: " + copy.load_error);
+    }
+    copy.forward(batch.data.data(), 4, got);
+    if (max_diff(got, want) != 0.0f) fail("Failed load changed the weights");
+
+    // The file's architecture section rebuilds a network built for another one
+    ContrastDualPolicyNet shallow(4);
+    if (!shallow.load_from_file(fp32_path) || shallow.arch() != net.arch()) return false;
+    shallow.forward(batch.data.data(), 4, got);
+    if (max_diff(got, want) != 0.0f) fail("Rebuilt network differs");
+
+    // Legacy files: bare (ndims, dims, floats) records in layer order
+    std::vector<uint8_t> legacy;
+    auto append = [&](const void* p, size_t n) {
+        legacy.insert(legacy.end(), (const uint8_t*)p, (const uint8_t*)p + n);
+    };
+    for (const auto& l : net.named_layers()) {
+        for (const Parameter* p : {l.conv ? &l.conv->weight : &l.fc->weight, l.conv ? &l.conv->bias : &l.fc->bias}) {
+            int32_t ndims = (int32_t)p->shape.size();
+            append(&ndims, sizeof(ndims));
+            append(p->shape.data(), ndims * sizeof(int32_t));
+            append(p->data(), p->size() * sizeof(float));
+        }
+    }
+    write_bytes(legacy);
+    ContrastDualPolicyNet old;
+    if (!old.load_from_file(bad_path)) return false;
+    old.forward(batch.data.data(), 4, got);
+    if (max_diff(got, want) != 0.0f) fail("Legacy model file differs");
+    legacy.resize(legacy.size() - 4);
+    write_bytes(legacy);
+    if (old.load_from_file(bad_path)) fail("Truncated legacy model file loaded");
+
+    for (const std::string& path : {fp32_path, int8_path, bad_path}) std::filesystem::remove(path);
+    return ok;
+}
+
+// Once its arena and output have seen the largest batch, a forward pass makes
+// no heap allocations, for every backbone algorithm
+static bool test_forward_allocations(ContrastDualPolicyNet& net) {
+    std::cout << "Checking forward pass allocations..." << std::endl;
+    std::mt19937 rng(5);
+    Tensor batch = random_input(rng, 8, ENCODED_PLANES, 5, 5);
+    ConvAlgo saved = net.backbone_algo;
+    bool ok = true;
+    for (ConvAlgo algo : {CONV_GEMM, CONV_WINOGRAD_2X2, CONV_WINOGRAD_4X4}) {
+        net.set_backbone_algorithm(algo);
+        Arena arena;
+        ContrastDualPolicyNet::Output out;
+        net.forward(batch.data.data(), 8, out, arena);
+
+        long long before = g_allocations;
+        for (int n : {1, 8, 3, 8}) net.forward(batch.data.data(), n, out, arena);
+        long long allocations = g_allocations - before;
+        if (allocations != 0) {
+            std::cerr << "Forward pass (algo " << algo << ") made " << allocations << " allocations" << std::endl;
+            ok = false;
+        }
+
+        auto want = net.forward(batch);
+        for (int i = 0; i < want.move_logits.size(); ++i) {
+            if (std::fabs(out.move_logits[i] - want.move_logits[i]) > 1e-5f) {
+                std::cerr << "Arena forward differs from tensor forward (algo " << algo << ")" << std::endl;
+                ok = false;
+                break;
+            }
+        }
+        if (arena.peak_use() > net.arena_floats(8)) {
+            std::cerr << "Forward pass used more arena than arena_floats()" << std::endl;
+            ok = false;
+        }
+    }
+    net.set_backbone_algorithm(saved);
+    return ok;
+}
+
+// Tree statistics stay consistent when several threads share the tree
+static bool test_parallel_search(ContrastDualPolicyNet& net) {
+    std::cout << "Checking tree-parallel search..." << std::endl;
+    MCTS mcts(&net, 1); // Small table so the search also collects between rounds
+    mcts.num_threads = 4;
+    ContrastGame game;
+    const int sims = 200;
+    mcts.search(game, sims);
+
+    const Node& root = mcts.tree.node(mcts.find_node(mcts.get_key(game)));
+    if (root.visits != sims) {
+        std::cerr << "Parallel search ran " << root.visits << " of " << sims << " simulations" << std::endl;
+        return false;
+    }
+    for (size_t i = 0; i < mcts.tree.size(); ++i) {
+        const Node& n = mcts.tree.node(i);
+        if (n.state == NODE_DEAD) continue;
+        if (n.state != NODE_READY) {
+            std::cerr << "Node left unpublished" << std::endl;
+            return false;
+        }
+        const Edge* edges = mcts.tree.edges_of(n);
+        int visits = 0;
+        for (int e = 0; e < n.num_edges; ++e) {
+            visits += edges[e].visits;
+            if (std::fabs(edges[e].value_sum) > edges[e].visits + 1e-3f) {
+                std::cerr << "Virtual loss left on an edge" << std::endl;
+                return false;
+            }
+        }
+        if (visits != n.visits) {
+            std::cerr << "Node visits do not match its edges" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Time-budgeted search keeps to its budget in every search mode, reports
+// the simulations it ran, and stops early only when the best move is decided
+static bool test_timed_search(ContrastDualPolicyNet& net) {
+    std::cout << "Checking time-budgeted search..." << std::endl;
+    MCTS mcts(&net);
+    ContrastGame game;
+    if (mcts.search(game, 30) != 30 || mcts.last_search.simulations != 30 || mcts.last_search.stopped_early) {
+        std::cerr << "Fixed-count search misreported its simulations" << std::endl;
+        return false;
+    }
+
+    // Budget of ~40 network calls; a search may overrun by one simulation (or batch)
+    auto t0 = std::chrono::steady_clock::now();
+    mcts.search(game, 1);
+    double call_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    double budget = 40 * std::max(call_ms, 0.5);
+    for (int mode = 0; mode < 3; ++mode) {
+        mcts.clear();
+        mcts.batch_size = (mode == 1) ? 8 : 1;
+        mcts.num_threads = (mode == 2) ? 4 : 1;
+        SearchLimits limits = SearchLimits::timed(budget);
+        limits.early_stop = false;
+        int sims = mcts.search(game, limits);
+        const SearchReport& r = mcts.last_search;
+        const Node& root = mcts.tree.node(mcts.find_node(mcts.get_key(game)));
+        std::cout << "  mode " << mode << ": " << sims << " simulations in " << r.elapsed_ms << " of " << budget
+                  << " ms" << std::endl;
+        if (sims <= 0 || sims != r.simulations || root.visits != sims || r.elapsed_ms < budget ||
+            r.elapsed_ms > 2 * budget + 20 * call_ms) {
+            std::cerr << "Timed search ran " << sims << " simulations in " << r.elapsed_ms << " ms" << std::endl;
+            return false;
+        }
+    }
+    mcts.batch_size = 1;
+    mcts.num_threads = 1;
+
+    // Early stop: the leading root move keeps its lead over the simulations that were skipped
+    mcts.dirichlet_epsilon = 0.0f;
+    bool stopped = false;
+    for (int i = 0; i < 6 && !game.game_over; ++i) {
+        mcts.clear();
+        const int cap = 300;
+        SearchLimits limits = SearchLimits::count(cap);
+        limits.early_stop = true;
+        int sims = mcts.search(game, limits);
+        int best = mcts.get_best_action(game);
+        if (mcts.last_search.stopped_early) {
+            stopped = true;
+            mcts.search(game, cap - sims);
+            if (mcts.get_best_action(game) != best) {
+                std::cerr << "Early stop after " << sims << " simulations picked a move that was overtaken" << std::endl;
+                return false;
+            }
+        } else if (sims != cap) {
+            std::cerr << "Search stopped at " << sims << " of " << cap << " without stopping early" << std::endl;
+            return false;
+        }
+        game.step(best);
+    }
+    if (!stopped) {
+        std::cerr << "Early stop never triggered" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Resumable search: chunks add up to the same tree as one search, the root
+// noise is applied once per session, and the principal variation is legal
+static bool test_chunked_search(ContrastDualPolicyNet& net) {
+    std::cout << "Checking chunked search..." << std::endl;
+    MCTS whole(&net), chunked(&net);
+    whole.dirichlet_epsilon = chunked.dirichlet_epsilon = 0.0f;
+    ContrastGame game;
+    std::mt19937 rng(22);
+    for (int i = 0; i < 6; ++i) {
+        auto actions = game.get_all_legal_actions();
+        game.step(actions[rng() % actions.size()]);
+    }
+
+    whole.search(game, 60);
+    if (!chunked.begin_search(game)) {
+        std::cerr << "begin_search found nothing to search" << std::endl;
+        return false;
+    }
+    for (int chunk : {1, 7, 20, 32})
+        chunked.continue_search(chunk);
+    if (chunked.session.simulations != 60 || chunked.last_search.simulations != 32) {
+        std::cerr << "Chunked search counted " << chunked.session.simulations << " simulations" << std::endl;
+        return false;
+    }
+    const Node& a = whole.tree.node(whole.find_node(whole.get_key(game)));
+    const Node& b = chunked.tree.node(chunked.find_node(chunked.get_key(game)));
+    for (uint32_t i = 0; i < a.num_edges; ++i) {
+        const Edge& ea = whole.tree.edges_of(a)[i];
+        const Edge& eb = chunked.tree.edges_of(b)[i];
+        if (ea.action != eb.action || ea.visits != eb.visits) {
+            std::cerr << "Chunked search visited the root differently from one search" << std::endl;
+            return false;
+        }
+    }
+
+    std::vector<int> pv = chunked.principal_variation(game, 8);
+    if (pv.empty() || pv[0] != chunked.get_best_action(game)) {
+        std::cerr << "Principal variation does not start with the best move" << std::endl;
+        return false;
+    }
+    ContrastGame line = game.copy();
+    for (int action : pv) {
+        ActionList legal;
+        line.generate_legal_actions(legal);
+        if (!legal.contains(action)) {
+            std::cerr << "Principal variation plays an illegal move" << std::endl;
+            return false;
+        }
+        line.step(action);
+    }
+    chunked.end_search();
+    if (chunked.continue_search(10) != 0) {
+        std::cerr << "continue_search ran without a session" << std::endl;
+        return false;
+    }
+
+    // With noise: the priors change at begin_search only
+    MCTS noisy(&net);
+    noisy.search(game, 1);
+    noisy.begin_search(game);
+    const Node& root = noisy.tree.node(noisy.find_node(noisy.get_key(game)));
+    std::vector<float> priors;
+    for (uint32_t i = 0; i < root.num_edges; ++i) priors.push_back(noisy.tree.edges_of(root)[i].prior);
+    noisy.continue_search(10);
+    noisy.continue_search(10);
+    const Node& searched = noisy.tree.node(noisy.find_node(noisy.get_key(game)));
+    for (uint32_t i = 0; i < searched.num_edges; ++i) {
+        if (noisy.tree.edges_of(searched)[i].prior != priors[i]) {
+            std::cerr << "continue_search re-applied the root noise" << std::endl;
+            return false;
+        }
+    }
+
+    // A real move ends the session
+    noisy.advance(line);
+    if (noisy.session.active) {
+        std::cerr << "advance() left the session open" << std::endl;
+        return false;
+    }
+
+    // Chunks keep to the session's limits and end it as the whole search would:
+    // at the count, or once early stopping finds the best move decided
+    MCTS limited(&net);
+    limited.begin_search(game, false, SearchLimits::count(50));
+    int chunks = 0;
+    while (!limited.session_done() && chunks++ < 10) limited.continue_search(16);
+    if (limited.session.simulations != 50 || limited.session.stopped_early) {
+        std::cerr << "Chunked search ran " << limited.session.simulations << " of a 50-simulation limit" << std::endl;
+        return false;
+    }
+    limited.end_search();
+    SearchLimits decided = SearchLimits::count(2000);
+    decided.early_stop = true;
+    limited.begin_search(game, false, decided);
+    chunks = 0;
+    while (!limited.session_done() && chunks++ < 200) limited.continue_search(16);
+    const Node& decided_root = limited.tree.node(limited.find_node(limited.get_key(game)));
+    int best = 0, second = 0;
+    for (uint32_t i = 0; i < decided_root.num_edges; ++i) {
+        int v = limited.tree.edges_of(decided_root)[i].visits;
+        if (v > best) second = best, best = v;
+        else if (v > second) second = v;
+    }
+    if (limited.session.simulations < 2000 &&
+        (!limited.session.stopped_early || best - second <= 2000 - limited.session.simulations)) {
+        std::cerr << "Chunked search stopped early with the best move still open" << std::endl;
+        return false;
+    }
+    if (!limited.session.stopped_early) {
+        std::cerr << "Chunked search never stopped early" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Pondering: the background search stops on request, leaves the root's
+// priors without noise, and its subtree for the reply it expected survives
+// advance() into the next search
+static bool test_pondering(ContrastDualPolicyNet& net) {
+    std::cout << "Checking pondering..." << std::endl;
+    MCTS mcts(&net);
+    ContrastGame game;
+    mcts.search(game, 1);
+    const Node& before = mcts.tree.node(mcts.find_node(mcts.get_key(game)));
+    std::vector<float> priors;
+    for (uint32_t i = 0; i < before.num_edges; ++i) priors.push_back(mcts.tree.edges_of(before)[i].prior);
+
+    // Waits for a ponder search to reach its limit by itself; the limit, not
+    // the machine's speed, decides how much it searched
+    auto wait_for_limit = [&] {
+        auto start = std::chrono::steady_clock::now();
+        while (mcts.ponder_searching()) {
+            if (std::chrono::steady_clock::now() - start > std::chrono::seconds(120)) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    };
+
+    // A stop request interrupts the search within a simulation
+    mcts.start_pondering(game);
+    if (!mcts.is_pondering()) {
+        std::cerr << "Pondering did not start" << std::endl;
+        return false;
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    mcts.stop_pondering();
+    double stop_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "  stopped in " << stop_ms << " ms after " << mcts.session.simulations << " simulations" << std::endl;
+    if (mcts.is_pondering() || mcts.session.active || mcts.session.simulations >= mcts.ponder_limit) {
+        std::cerr << "Pondering did not stop on request" << std::endl;
+        return false;
+    }
+
+    mcts.ponder_limit = 400;
+    mcts.start_pondering(game);
+    if (!wait_for_limit()) {
+        std::cerr << "Pondering did not stop at its limit" << std::endl;
+        return false;
+    }
+    mcts.stop_pondering();
+    int pondered = mcts.last_search.simulations;
+    if (mcts.is_pondering() || mcts.session.active || pondered != mcts.ponder_limit) {
+        std::cerr << "Pondering ran " << pondered << " simulations with a limit of " << mcts.ponder_limit << std::endl;
+        return false;
+    }
+    const Node& root = mcts.tree.node(mcts.find_node(mcts.get_key(game)));
+    if (root.visits < pondered) {
+        std::cerr << "Pondered visits missing from the root" << std::endl;
+        return false;
+    }
+    int reply = mcts.get_best_action(game);
+    int reply_visits = 0;
+    for (uint32_t i = 0; i < root.num_edges; ++i) {
+        const Edge& e = mcts.tree.edges_of(root)[i];
+        if (e.prior != priors[i]) {
+            std::cerr << "Pondering changed the root priors" << std::endl;
+            return false;
+        }
+        if (e.action == reply) reply_visits = e.visits;
+    }
+
+    // The expected reply's subtree holds its edge's visits but the one that
+    // expanded it, and advance() keeps them for the next search
+    ContrastGame next = game.copy();
+    next.step(reply);
+    int kept = mcts.get_root_visits(next);
+    std::cout << "  " << pondered << " simulations pondered, " << kept << " kept for the reply" << std::endl;
+    if (kept != std::max(reply_visits - 1, 0)) {
+        std::cerr << "Reply subtree holds " << kept << " visits, its edge " << reply_visits << std::endl;
+        return false;
+    }
+    mcts.advance(next);
+    if (mcts.get_root_visits(next) != kept) {
+        std::cerr << "advance() kept " << mcts.get_root_visits(next) << " of " << kept << " pondered visits" << std::endl;
+        return false;
+    }
+    mcts.search(next, 10);
+    if (mcts.get_root_visits(next) != kept + 10) {
+        std::cerr << "Search after pondering did not build on its tree" << std::endl;
+        return false;
+    }
+
+    // The destructor joins a running ponder search
+    MCTS running(&net);
+    running.start_pondering(game);
+    return true;
+}
+
+// The evaluation cache: history_hash() separates every pair of positions
+// whose network inputs differ, cached priors and values match fresh ones,
+// and repeated searches are served from the cache in every search mode
+static bool test_eval_cache(ContrastDualPolicyNet& net) {
+    std::cout << "Checking the evaluation cache..." << std::endl;
+    std::mt19937 rng(2020);
+    std::unordered_map<uint64_t, std::vector<float>> inputs;
+    std::vector<float> planes(ENCODED_STATE_SIZE);
+    ActionList actions;
+    int distinct = 0;
+    for (int g = 0; g < 200; ++g) {
+        ContrastGame game;
+        while (!game.game_over && game.move_count < 40) {
+            game.encode_state_into(planes.data());
+            auto it = inputs.find(game.history_hash());
+            if (it == inputs.end()) {
+                inputs.emplace(game.history_hash(), planes);
+                distinct++;
+            } else if (it->second != planes) {
+                std::cerr << "history_hash() collision between different network inputs" << std::endl;
+                return false;
+            }
+            game.generate_legal_actions(actions);
+            game.step(actions[rng() % actions.size()]);
+        }
+    }
+    if (distinct < 1000) {
+        std::cerr << "Too few distinct positions hashed: " << distinct << std::endl;
+        return false;
+    }
+
+    // Priors from a cache hit against priors from the network output
+    EvalCache cache(1);
+    MCTS mcts(&net);
+    mcts.eval_cache = &cache;
+    ContrastGame game;
+    for (int i = 0; i < 9; ++i) {
+        game.generate_legal_actions(actions);
+        game.step(actions[rng() % actions.size()]);
+    }
+    game.generate_legal_actions(actions);
+    auto out = net.forward(game.encode_state());
+    cache.store(game.history_hash(), actions, game.current_player == P2, out.move_logits.data.data(),
+                out.tile_logits.data.data(), out.value);
+    MCTS::Evaluator eval;
+    float value = 0.0f;
+    if (!mcts.probe_cache(game, eval, value) || value != out.value) {
+        std::cerr << "Stored evaluation not found" << std::endl;
+        return false;
+    }
+    std::vector<Edge> fresh(actions.size()), cached(actions.size());
+    mcts.fill_edges(game, actions, out.move_logits.data.data(), out.tile_logits.data.data(), fresh.data());
+    mcts.fill_edges(game, actions, eval.cached_move_logits, eval.cached_tile_logits, cached.data());
+    for (int i = 0; i < actions.size(); ++i) {
+        const Edge& c = *std::find_if(cached.begin(), cached.end(), [&](const Edge& e) { return e.action == fresh[i].action; });
+        if (std::fabs(c.prior - fresh[i].prior) > 0.01f * fresh[i].prior + 1e-6f) {
+            std::cerr << "Cached prior " << c.prior << " differs from " << fresh[i].prior << std::endl;
+            return false;
+        }
+    }
+    game.step(actions[0]);
+    if (mcts.probe_cache(game, eval, value)) {
+        std::cerr << "Evaluation cache hit for a position never stored" << std::endl;
+        return false;
+    }
+
+    // A single-threaded search replays exactly from the cache: the same
+    // positions, every lookup a hit, the same root visits. The table is
+    // direct-mapped and always replaces, so it is sized for the ~100
+    // positions of a search not to share a slot. The threaded search
+    // interleaves differently on every run, so it only has to account for
+    // each evaluation with a store.
+    cache.resize(64);
+    auto root_visits = [&](const ContrastGame& g) {
+        std::vector<int> visits;
+        const Node& n = mcts.tree.node(mcts.find_node(mcts.get_key(g)));
+        for (uint32_t e = 0; e < n.num_edges; ++e) visits.push_back(mcts.tree.edges_of(n)[e].visits);
+        return visits;
+    };
+    for (int mode = 0; mode < 3; ++mode) {
+        cache.clear();
+        mcts.batch_size = (mode == 1) ? 8 : 1;
+        mcts.num_threads = (mode == 2) ? 4 : 1;
+        mcts.dirichlet_epsilon = 0.0f;
+        ContrastGame root;
+        mcts.clear();
+        mcts.search(root, 100);
+        std::vector<int> visits = root_visits(root);
+        uint64_t first_misses = cache.stats.misses(), first_lookups = cache.stats.lookups;
+        mcts.clear();
+        mcts.search(root, 100);
+        uint64_t lookups = cache.stats.lookups - first_lookups, misses = cache.stats.misses() - first_misses;
+        std::cout << "  mode " << mode << ": " << first_misses << " evaluations, then " << misses << " misses of "
+                  << lookups << " lookups" << std::endl;
+        if (cache.stats.stores + cache.stats.busy != first_misses + misses) {
+            std::cerr << "Evaluations were not stored in the evaluation cache" << std::endl;
+            return false;
+        }
+        if (mode != 2 && (lookups == 0 || misses != 0 || root_visits(root) != visits)) {
+            std::cerr << "Repeated search was not replayed from the evaluation cache" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
 
 // Simple verification runner
 int main(int argc, char** argv) {
-    if (argc < 2) {
-        std::cerr << "Usage: ./test_main <model.bin>" << std::endl;
-        return 1;
+    int positions = 1000000;
+    std::string model_path;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--positions" && i + 1 < argc) positions = std::stoi(argv[++i]);
+        else model_path = arg;
+    }
+
+    bool ok = test_bitboard_movegen(positions);
+    ok = test_movegen_allocations(positions / 10) && ok;
+    ok = test_zobrist(positions / 100) && ok;
+    ok = test_copy_and_history(positions / 1000) && ok;
+    ok = test_make_unmake(positions / 1000) && ok;
+    ok = test_transposition_table() && ok;
+    ok = test_conv_gemm() && ok;
+    ok = test_simd_kernels() && ok;
+    ok = test_action_tables() && ok;
+    ok = test_prior_order() && ok;
+    ok = test_winograd() && ok;
+    ok = test_fixed_geometry(positions / 10000) && ok;
+    ok = test_fused_epilogues() && ok;
+
+    if (model_path.empty()) {
+        std::cout << "No model given, skipping inference checks (usage: ./test_main [model.bin] [--positions N])" << std::endl;
+        std::cout << (ok ? "All checks passed." : "FAILED") << std::endl;
+        return ok ? 0 : 1;
     }
-    
-    std::string model_path = argv[1];
-    
+
     ContrastDualPolicyNet net;
-    net.load_from_file(model_path);
-    
+    if (!net.load_from_file(model_path) || !network_fits_game(net.arch())) {
+        std::cerr << "Cannot run inference checks on " << model_path << std::endl;
+        return 1;
+    }
+
+    ok = test_simd_network(net) && ok;
+    ok = test_forward_allocations(net) && ok;
+    ok = test_int8(net) && ok;
+    ok = test_architectures(net) && ok;
+    ok = test_model_file(net) && ok;
+    ok = test_batched_search(net) && ok;
+    ok = test_parallel_search(net) && ok;
+    ok = test_timed_search(net) && ok;
+    ok = test_chunked_search(net) && ok;
+    ok = test_pondering(net) && ok;
+    ok = test_eval_cache(net) && ok;
+
     ContrastGame game;
     MCTS mcts(&net);
-    
+
     // 1. Check Inference
     std::cout << "Checking Inference..." << std::endl;
     Tensor input = game.encode_state();
     auto out = net.forward(input);
     std::cout << "Value: " << out.value << std::endl;
     std::cout << "Move Logits[0]: " << out.move_logits[0] << std::endl;
-    
+
     // 2. Play a few random moves
     std::cout << "Playing verify game..." << std::endl;
     game.reset();
-    
+
     for(int i=0; i<10; ++i) {
         mcts.search(game, 50); // Small sim count
         int action = mcts.get_best_action(game);
+
+        // Every simulation passes through the root, and edges stay sorted by prior
+        const Node& root = mcts.tree.node(mcts.find_node(mcts.get_key(game)));
+        const Edge* root_edges = mcts.tree.edges_of(root);
+        int edge_visits = 0;
+        for (uint32_t e = 0; e < root.num_edges; ++e) {
+            edge_visits += root_edges[e].visits;
+            if (e > 0 && root_edges[e].prior > root_edges[e - 1].prior) ok = false;
+        }
+        if (root.visits < 50 || root.visits != edge_visits) {
+            std::cerr << "Root visit count mismatch: " << root.visits << " vs " << edge_visits << std::endl;
+            ok = false;
+        }
         std::cout << "Step " << i << ": Action " << action << std::endl;
+
+        int child_visits = 0;
+        for (uint32_t e = 0; e < root.num_edges; ++e)
+            if (root_edges[e].action == action) child_visits = root_edges[e].visits;
+
+        size_t nodes_before = mcts.tree.size();
         game.step(action);
         if(game.game_over) break;
+
+        // Re-rooting keeps the played subtree (the first visit only expands the child)
+        mcts.advance(game);
+        uint32_t new_root = mcts.find_node(mcts.get_key(game));
+        if (new_root == NO_NODE || mcts.tree.node(new_root).visits < child_visits - 1 ||
+            mcts.tree.size() >= nodes_before) {
+            std::cerr << "Tree reuse lost the played subtree at step " << i << std::endl;
+            ok = false;
+        }
     }
-    
+
     std::cout << "Test Finished. Winner: " << game.winner << std::endl;
-    
-    return 0;
+    std::cout << (ok ? "All checks passed." : "FAILED") << std::endl;
+
+    return ok ? 0 : 1;
 }
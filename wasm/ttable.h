@@ -0,0 +1,344 @@
+#ifndef TTABLE_H
+#define TTABLE_H
+
+#include "bitboard.h"
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <algorithm>
+
+// Lock-free helpers for statistics shared by search threads. Node and Edge
+// stay plain structs (compaction memmoves them), so the GCC/Clang __atomic
+// builtins operate on their fields directly. Relaxed loads compile to plain
+// loads, so single-threaded callers lose nothing by using them.
+inline int load_relaxed(const int &v) { return __atomic_load_n(&v, __ATOMIC_RELAXED); }
+inline float load_relaxed(const float &v)
+{
+    float r;
+    __atomic_load(&v, &r, __ATOMIC_RELAXED);
+    return r;
+}
+inline void add_relaxed(int &v, int d) { __atomic_fetch_add(&v, d, __ATOMIC_RELAXED); }
+inline void add_relaxed(uint64_t &v, uint64_t d) { __atomic_fetch_add(&v, d, __ATOMIC_RELAXED); }
+inline void add_relaxed(float &v, float d)
+{
+    float expected = load_relaxed(v);
+    float desired;
+    do
+        desired = expected + d;
+    while (!__atomic_compare_exchange(&v, &expected, &desired, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+// One (action, prior, visits, value-sum) entry of a node.
+// A node's edges are contiguous in the edge pool, sorted by descending prior.
+struct Edge
+{
+    int action;
+    float prior;
+    int visits;
+    float value_sum;
+};
+
+enum NodeState : uint8_t
+{
+    NODE_READY = 0,     // Edges filled in
+    NODE_EXPANDING = 1, // Inserted by insert_shared(), owner still filling the edges
+    NODE_DEAD = 2,      // Lost an insert race; never linked, dropped by compact()
+};
+
+struct Node
+{
+    uint64_t key;
+    uint32_t first_edge; // Index into the edge pool
+    uint32_t generation; // Search generation that last created or visited this node (never wraps in practice)
+    uint16_t num_edges;  // 0 for positions without legal actions
+    uint8_t state;       // NodeState
+    int visits;          // Sum of edge visits
+};
+
+constexpr uint32_t NO_NODE = 0xFFFFFFFFu;
+
+struct TTStats
+{
+    uint64_t lookups = 0;
+    uint64_t hits = 0;
+    uint64_t inserts = 0;
+    uint64_t evictions = 0;
+    uint64_t collections = 0;
+
+    double hit_rate() const { return lookups ? (double)hits / lookups : 0.0; }
+};
+
+// Fixed-capacity transposition table holding the MCTS tree.
+//
+// Nodes and edges live in pools sized once from a megabyte budget and are
+// handed out by bumping a counter. Lookups go through an open-addressing
+// index of node slots keyed by the (already well mixed) position key.
+// When the pools run low, collect() keeps the most valuable nodes -- those
+// visited in the current generation first, then by visit count -- compacts
+// both pools in place and rebuilds the index. Indices are therefore only
+// stable between collections; callers must not hold them across one.
+//
+// find_shared() and insert_shared() may be called concurrently by search
+// threads. Everything else, collect() in particular, needs exclusive access.
+class TranspositionTable
+{
+public:
+    // Expected edges per node, used to split the budget between the pools
+    static constexpr size_t AVG_EDGES_PER_NODE = 64;
+    // Fraction of each pool collect() keeps, leaving room for new nodes
+    static constexpr double KEEP_FRACTION = 0.5;
+
+    TTStats stats;
+    uint32_t generation = 0;
+
+    explicit TranspositionTable(size_t megabytes = 32)
+    {
+        resize(megabytes);
+    }
+
+    void resize(size_t megabytes)
+    {
+        size_t bytes = std::max<size_t>(megabytes, 1) << 20;
+        size_t per_node = sizeof(Node) + 2 * sizeof(uint32_t) + AVG_EDGES_PER_NODE * sizeof(Edge);
+
+        node_capacity = std::max<size_t>(bytes / per_node, 64);
+        edge_capacity = node_capacity * AVG_EDGES_PER_NODE;
+        index_size = 1;
+        while (index_size < 2 * node_capacity)
+            index_size <<= 1;
+
+        nodes.reset(new Node[node_capacity]);
+        edges.reset(new Edge[edge_capacity]);
+        index.reset(new uint32_t[index_size]);
+        clear();
+    }
+
+    void clear()
+    {
+        used = 0;
+        std::fill_n(index.get(), index_size, NO_NODE);
+    }
+
+    // Called at the start of every search; nodes touched from now on are "young"
+    void new_generation() { ++generation; }
+
+    uint32_t find(uint64_t key)
+    {
+        uint32_t idx = probe(key);
+        stats.lookups++;
+        if (idx != NO_NODE)
+            stats.hits++;
+        return idx;
+    }
+
+    // find() for concurrent searchers
+    uint32_t find_shared(uint64_t key)
+    {
+        uint32_t idx = probe(key);
+        add_relaxed(stats.lookups, 1);
+        if (idx != NO_NODE)
+            add_relaxed(stats.hits, 1);
+        return idx;
+    }
+
+    // find() without touching the stats, for maintenance walks
+    uint32_t probe(uint64_t key) const
+    {
+        for (size_t slot = key & (index_size - 1);; slot = (slot + 1) & (index_size - 1))
+        {
+            uint32_t idx = __atomic_load_n(&index[slot], __ATOMIC_ACQUIRE);
+            if (idx == NO_NODE || nodes[idx].key == key)
+                return idx;
+        }
+    }
+
+    // True if `count` nodes with up to MAX_ACTIONS edges each still fit
+    bool can_insert(int count = 1) const
+    {
+        return free_slots() >= (size_t)count;
+    }
+
+    // Nodes with up to MAX_ACTIONS edges each that still fit
+    size_t free_slots() const
+    {
+        return std::min(node_capacity - num_nodes(), (edge_capacity - num_edges()) / MAX_ACTIONS);
+    }
+
+    // Allocates a node with an uninitialised span of `edge_count` edges.
+    // The caller must have checked can_insert() and must fill the edges.
+    uint32_t insert(uint64_t key, int edge_count)
+    {
+        uint32_t idx = num_nodes();
+        init_node(idx, key, num_edges(), edge_count, NODE_READY);
+        used += (uint64_t(1) << 32) + edge_count;
+        link(idx);
+        stats.inserts++;
+        return idx;
+    }
+
+    // Concurrent insert(). Returns NO_NODE when the pools are full. Otherwise
+    // returns the node for `key` and sets `owner` if this call created it; the
+    // owner fills the edges and then calls publish(). Until then the node is
+    // NODE_EXPANDING and other threads must not read its edges. If another
+    // thread inserted the key first, its node is returned instead; the span
+    // this call allocated stays used as NODE_DEAD until the next compact().
+    uint32_t insert_shared(uint64_t key, int edge_count, bool &owner)
+    {
+        owner = false;
+
+        // Nodes and edges come from one packed counter, so both pools stay in
+        // the same order under concurrent allocation; compact() relies on it.
+        // The counter only moves by a compare-exchange that fits, so it never
+        // passes the capacity and no span is handed out twice.
+        uint64_t amount = (uint64_t(1) << 32) + edge_count;
+        uint64_t start = __atomic_load_n(&used, __ATOMIC_RELAXED);
+        uint32_t idx, first;
+        do
+        {
+            idx = (uint32_t)(start >> 32);
+            first = (uint32_t)start;
+            if (idx >= node_capacity || first + (size_t)edge_count > edge_capacity)
+                return NO_NODE;
+        } while (!__atomic_compare_exchange_n(&used, &start, start + amount, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+        init_node(idx, key, first, edge_count, NODE_EXPANDING);
+
+        for (size_t slot = key & (index_size - 1);; slot = (slot + 1) & (index_size - 1))
+        {
+            uint32_t seen = NO_NODE;
+            if (__atomic_compare_exchange_n(&index[slot], &seen, idx, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            {
+                owner = true;
+                add_relaxed(stats.inserts, 1);
+                return idx;
+            }
+            if (nodes[seen].key == key)
+            {
+                nodes[idx].state = NODE_DEAD;
+                return seen;
+            }
+        }
+    }
+
+    // Makes the edges of a node from insert_shared() visible to other threads
+    void publish(uint32_t idx) { __atomic_store_n(&nodes[idx].state, (uint8_t)NODE_READY, __ATOMIC_RELEASE); }
+    bool is_ready(uint32_t idx) const { return __atomic_load_n(&nodes[idx].state, __ATOMIC_ACQUIRE) == NODE_READY; }
+    // Marks a node as visited in the current generation
+    void touch(uint32_t idx) { __atomic_store_n(&nodes[idx].generation, generation, __ATOMIC_RELAXED); }
+
+    Node &node(uint32_t idx) { return nodes[idx]; }
+    const Node &node(uint32_t idx) const { return nodes[idx]; }
+    Edge *edges_of(const Node &n) { return &edges[n.first_edge]; }
+    const Edge *edges_of(const Node &n) const { return &edges[n.first_edge]; }
+
+    size_t size() const { return num_nodes(); }
+    size_t edges_used() const { return num_edges(); }
+    size_t capacity() const { return node_capacity; }
+    double occupancy() const
+    {
+        return std::max((double)num_nodes() / node_capacity, (double)num_edges() / edge_capacity);
+    }
+    size_t memory_bytes() const
+    {
+        return node_capacity * sizeof(Node) + edge_capacity * sizeof(Edge) + index_size * sizeof(uint32_t);
+    }
+
+    // Replacement: keep the best nodes (young generation first, then most
+    // visited) within KEEP_FRACTION of both pools, evict the rest in bulk.
+    // `pinned_key` (the search root) is always kept.
+    void collect(uint64_t pinned_key)
+    {
+        uint32_t count = num_nodes();
+        std::vector<uint32_t> order(count);
+        for (uint32_t i = 0; i < count; ++i)
+            order[i] = i;
+        auto score = [&](uint32_t i) -> int64_t
+        {
+            const Node &n = nodes[i];
+            if (n.key == pinned_key)
+                return INT64_MAX;
+            int64_t young = (n.generation == generation) ? (int64_t(1) << 32) : 0;
+            return young + n.visits;
+        };
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+                  { return score(a) > score(b); });
+
+        std::vector<bool> keep(count, false);
+        size_t node_budget = (size_t)(node_capacity * KEEP_FRACTION);
+        size_t edge_budget = (size_t)(edge_capacity * KEEP_FRACTION);
+        size_t kept_nodes = 0, kept_edges = 0;
+        for (uint32_t i : order)
+        {
+            if (kept_nodes + 1 > node_budget || kept_edges + nodes[i].num_edges > edge_budget)
+                break;
+            keep[i] = true;
+            kept_nodes++;
+            kept_edges += nodes[i].num_edges;
+        }
+        compact(keep);
+    }
+
+    // Drop every node for which keep[idx] is false, along with nodes that lost
+    // an insert race, preserving the order of the rest. Node order equals edge
+    // order (both are bump-allocated together), so both pools compact in place
+    // in a single forward pass.
+    void compact(const std::vector<bool> &keep)
+    {
+        uint32_t count = num_nodes();
+        uint32_t n_out = 0, e_out = 0;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (!keep[i] || nodes[i].state == NODE_DEAD)
+                continue;
+            Node n = nodes[i];
+            if (n.num_edges > 0 && n.first_edge != e_out)
+                std::memmove(&edges[e_out], &edges[n.first_edge], n.num_edges * sizeof(Edge));
+            n.first_edge = e_out;
+            e_out += n.num_edges;
+            nodes[n_out++] = n;
+        }
+
+        stats.evictions += count - n_out;
+        stats.collections++;
+        used = (uint64_t(n_out) << 32) | e_out;
+
+        std::fill_n(index.get(), index_size, NO_NODE);
+        for (uint32_t i = 0; i < n_out; ++i)
+            link(i);
+    }
+
+private:
+    std::unique_ptr<Node[]> nodes;
+    std::unique_ptr<Edge[]> edges;
+    std::unique_ptr<uint32_t[]> index;
+    size_t node_capacity = 0;
+    size_t edge_capacity = 0;
+    size_t index_size = 0;
+    uint64_t used = 0; // Nodes allocated in the high 32 bits, edges in the low 32 bits
+
+    uint32_t num_nodes() const { return (uint32_t)(__atomic_load_n(&used, __ATOMIC_RELAXED) >> 32); }
+    uint32_t num_edges() const { return (uint32_t)__atomic_load_n(&used, __ATOMIC_RELAXED); }
+
+    void init_node(uint32_t idx, uint64_t key, uint32_t first, int edge_count, uint8_t state)
+    {
+        Node &n = nodes[idx];
+        n.key = key;
+        n.first_edge = first;
+        n.num_edges = edge_count;
+        n.generation = generation;
+        n.state = state;
+        n.visits = 0;
+    }
+
+    void link(uint32_t idx)
+    {
+        size_t slot = nodes[idx].key & (index_size - 1);
+        while (index[slot] != NO_NODE)
+            slot = (slot + 1) & (index_size - 1);
+        index[slot] = idx;
+    }
+};
+
+#endif // TTABLE_H
@@ -0,0 +1,240 @@
+#ifndef WINOGRAD_H
+#define WINOGRAD_H
+
+#include "gemm.h"
+#include <vector>
+#include <algorithm>
+#include <cassert>
+
+// Winograd minimal filtering F(m x m, 3 x 3) for stride-1 3x3 convolutions.
+//
+// The output is covered by m x m tiles; each reads an alpha x alpha input
+// patch (alpha = m + 2). Per tile and channel pair the direct convolution
+// needs 9 m^2 multiplies, Winograd alpha^2:
+//   U = G g G^T        (weights, transformed once when they are loaded)
+//   V = B^T d B        (input patch)
+//   Y = A^T (U . V) A  (output tile)
+// Summed over input channels, the elementwise product U . V becomes alpha^2
+// independent GEMMs [tiles x C_in] x [C_in x C_out], which run on sgemm().
+//
+// On the 5x5 board F(2x2) uses 3x3 tiles and F(4x4) 2x2 tiles; both need
+// 144 multiplies per channel pair against 225 for the direct convolution.
+
+template <int M> struct WinogradTiles;
+
+// F(2x2, 3x3)
+//   B^T = [1  0 -1  0]   G = [  1    0    0 ]   A^T = [1  1  1  0]
+//         [0  1  1  0]       [ 1/2  1/2  1/2]         [0  1 -1 -1]
+//         [0 -1  1  0]       [ 1/2 -1/2  1/2]
+//         [0  1  0 -1]       [  0    0    1 ]
+// input() and output() apply B^T and A^T to a strided vector, written out
+// because the compiler may not drop zero coefficients under IEEE semantics.
+template <> struct WinogradTiles<2> {
+    static constexpr float G[4][3] = {
+        {1, 0, 0},
+        {0.5f, 0.5f, 0.5f},
+        {0.5f, -0.5f, 0.5f},
+        {0, 0, 1},
+    };
+
+    static void input(const float* d, int ds, float* out, int os) {
+        float d0 = d[0], d1 = d[ds], d2 = d[2 * ds], d3 = d[3 * ds];
+        out[0] = d0 - d2;
+        out[os] = d1 + d2;
+        out[2 * os] = d2 - d1;
+        out[3 * os] = d1 - d3;
+    }
+    static void output(const float* m, int ms, float* out, int os) {
+        float m0 = m[0], m1 = m[ms], m2 = m[2 * ms], m3 = m[3 * ms];
+        out[0] = m0 + m1 + m2;
+        out[os] = m1 - m2 - m3;
+    }
+};
+
+// F(4x4, 3x3)
+//   B^T = [4  0 -5  0  1  0]   G = [ 1/4    0     0  ]   A^T = [1  1  1  1  1  0]
+//         [0 -4 -4  1  1  0]       [-1/6 -1/6  -1/6 ]         [0  1 -1  2 -2  0]
+//         [0  4 -4 -1  1  0]       [-1/6  1/6  -1/6 ]         [0  1  1  4  4  0]
+//         [0 -2 -1  2  1  0]       [1/24  1/12  1/6 ]         [0  1 -1  8 -8  1]
+//         [0  2 -1 -2  1  0]       [1/24 -1/12  1/6 ]
+//         [0  4  0 -5  0  1]       [  0     0     1  ]
+template <> struct WinogradTiles<4> {
+    static constexpr float G[6][3] = {
+        {1.0f / 4, 0, 0},
+        {-1.0f / 6, -1.0f / 6, -1.0f / 6},
+        {-1.0f / 6, 1.0f / 6, -1.0f / 6},
+        {1.0f / 24, 1.0f / 12, 1.0f / 6},
+        {1.0f / 24, -1.0f / 12, 1.0f / 6},
+        {0, 0, 1},
+    };
+
+    static void input(const float* d, int ds, float* out, int os) {
+        float d0 = d[0], d1 = d[ds], d2 = d[2 * ds], d3 = d[3 * ds], d4 = d[4 * ds], d5 = d[5 * ds];
+        out[0] = 4 * d0 - 5 * d2 + d4;
+        out[os] = -4 * (d1 + d2) + d3 + d4;
+        out[2 * os] = 4 * (d1 - d2) - d3 + d4;
+        out[3 * os] = 2 * (d3 - d1) - d2 + d4;
+        out[4 * os] = 2 * (d1 - d3) - d2 + d4;
+        out[5 * os] = 4 * d1 - 5 * d3 + d5;
+    }
+    static void output(const float* m, int ms, float* out, int os) {
+        float m0 = m[0], m1 = m[ms], m2 = m[2 * ms], m3 = m[3 * ms], m4 = m[4 * ms], m5 = m[5 * ms];
+        float p12 = m1 + m2, n12 = m1 - m2, p34 = m3 + m4, n34 = m3 - m4;
+        out[0] = m0 + p12 + p34;
+        out[os] = n12 + 2 * n34;
+        out[2 * os] = p12 + 4 * p34;
+        out[3 * os] = n12 + 8 * n34 + m5;
+    }
+};
+
+// U[xi][ic][oc] = (G g G^T)[xi] for weights g = [C_out, C_in, 3, 3]
+template <int M>
+std::vector<float> winograd_transform_weights(const float* weight, int out_c, int in_c) {
+    constexpr int a = M + 2;
+    const auto& G = WinogradTiles<M>::G;
+    std::vector<float> U((size_t)a * a * in_c * out_c);
+    for (int oc = 0; oc < out_c; ++oc) {
+        for (int ic = 0; ic < in_c; ++ic) {
+            const float* g = weight + (oc * in_c + ic) * 9;
+            float tmp[a][3]; // G g
+            for (int i = 0; i < a; ++i)
+                for (int j = 0; j < 3; ++j)
+                    tmp[i][j] = G[i][0] * g[j] + G[i][1] * g[3 + j] + G[i][2] * g[6 + j];
+            for (int i = 0; i < a; ++i)
+                for (int j = 0; j < a; ++j)
+                    U[((size_t)(i * a + j) * in_c + ic) * out_c + oc] =
+                        tmp[i][0] * G[j][0] + tmp[i][1] * G[j][1] + tmp[i][2] * G[j][2];
+        }
+    }
+    return U;
+}
+
+// Tiles over a batch of N images for the F(M x M, 3 x 3) transform
+template <int M>
+int winograd_tiles(int N, int H, int W, int pad) {
+    int H_out = H + 2 * pad - 2;
+    int W_out = W + 2 * pad - 2;
+    return N * ((H_out + M - 1) / M) * ((W_out + M - 1) / M);
+}
+
+// Arena floats winograd_conv() needs
+template <int M>
+size_t winograd_workspace(int N, int in_c, int H, int W, int pad, int out_c) {
+    constexpr int aa = (M + 2) * (M + 2);
+    int P = winograd_tiles<M>(N, H, W, pad);
+    return Arena::rounded((size_t)P * aa * in_c) + Arena::rounded((size_t)P * aa * out_c) +
+           sgemm_workspace(P, out_c, in_c);
+}
+
+// Stride-1 3x3 convolution of [N, C_in, H, W] with `pad` zero padding into
+// [N, C_out, H_out, W_out], using weights from winograd_transform_weights()
+// for the F(M x M, 3 x 3) transform. Scratch comes from `arena`. The output
+// transform also adds the bias and, if given, `residual` (output-shaped),
+// and applies ReLU if `relu`. Nonzero IN_C and OUT_C replace in_c and out_c
+// with compile-time constants (the network's fast paths); nonzero H_C and
+// W_C fix the plane size of a "same" convolution (padding 1), and each plane
+// is then padded once so the tiles transform straight out of it.
+template <int M, int IN_C = 0, int OUT_C = 0, int H_C = 0, int W_C = 0>
+void winograd_conv(const float* input, int N, int in_channels, int height, int width, int padding,
+                   const float* U, int out_channels, const float* bias, float* output, Arena& arena,
+                   bool relu = false, const float* residual = nullptr) {
+    constexpr int m = M, a = M + 2, aa = a * a;
+    constexpr bool fixed = H_C && W_C;
+    assert(!fixed || (height == H_C && width == W_C && padding == 1));
+    const int in_c = IN_C ? IN_C : in_channels;
+    const int out_c = OUT_C ? OUT_C : out_channels;
+    const int H = fixed ? H_C : height;
+    const int W = fixed ? W_C : width;
+    const int pad = fixed ? 1 : padding;
+    using Tiles = WinogradTiles<M>;
+    int H_out = H + 2 * pad - 2;
+    int W_out = W + 2 * pad - 2;
+    int tiles_h = (H_out + m - 1) / m;
+    int tiles_w = (W_out + m - 1) / m;
+    int tiles = tiles_h * tiles_w;
+    int P = N * tiles; // Tiles over the batch
+    size_t arena_mark = arena.mark();
+
+    // V[p][xi][ic]: GEMM rows are tiles, so the wide dimension is C_out.
+    // The alpha^2 values of a tile sit together; a [xi][p] layout would put
+    // them a multiple of 4KB apart, all in the same L1 set.
+    float* V = arena.alloc((size_t)P * aa * in_c);
+    for (int n = 0; n < N; ++n) {
+        for (int ic = 0; ic < in_c; ++ic) {
+            const float* plane = input + (n * in_c + ic) * H * W;
+            if constexpr (fixed) {
+                constexpr int TH = (H_C + M - 1) / M, TW = (W_C + M - 1) / M;
+                constexpr int HP = TH * m + 2, WP = TW * m + 2;
+                float padded[HP * WP];
+                pad_plane<H_C, W_C, 1, HP, WP>(plane, padded);
+                for (int th = 0; th < TH; ++th) {
+                    for (int tw = 0; tw < TW; ++tw) {
+                        const float* d = padded + th * m * WP + tw * m;
+                        float tmp[a * a];
+                        for (int j = 0; j < a; ++j) Tiles::input(d + j, WP, tmp + j, a);
+                        float* v = V + (size_t)(n * tiles + th * TW + tw) * aa * in_c + ic;
+                        for (int i = 0; i < a; ++i) Tiles::input(tmp + i * a, 1, v + i * a * in_c, in_c);
+                    }
+                }
+                continue;
+            }
+            for (int th = 0; th < tiles_h; ++th) {
+                for (int tw = 0; tw < tiles_w; ++tw) {
+                    float d[a * a];
+                    for (int i = 0; i < a; ++i) {
+                        int y = th * m + i - pad;
+                        for (int j = 0; j < a; ++j) {
+                            int x = tw * m + j - pad;
+                            d[i * a + j] = (y >= 0 && y < H && x >= 0 && x < W) ? plane[y * W + x] : 0.0f;
+                        }
+                    }
+                    float tmp[a * a]; // B^T d, column by column
+                    for (int j = 0; j < a; ++j) Tiles::input(d + j, a, tmp + j, a);
+                    float* v = V + (size_t)(n * tiles + th * tiles_w + tw) * aa * in_c + ic;
+                    for (int i = 0; i < a; ++i) Tiles::input(tmp + i * a, 1, v + i * a * in_c, in_c);
+                }
+            }
+        }
+    }
+
+    // M[p][xi] = V[p][xi] x U[xi], one [P x C_out] GEMM per xi
+    float* Mt = arena.alloc((size_t)P * aa * out_c);
+    for (int xi = 0; xi < aa; ++xi) {
+        sgemm(P, out_c, in_c, V + xi * in_c, aa * in_c, U + (size_t)xi * in_c * out_c, out_c,
+              Mt + xi * out_c, aa * out_c, arena);
+    }
+
+    const SimdKernels& k = simd_kernels();
+    int hw_out = H_out * W_out;
+    for (int n = 0; n < N; ++n) {
+        float* out_image = output + (size_t)n * out_c * hw_out;
+        for (int th = 0; th < tiles_h; ++th) {
+            for (int tw = 0; tw < tiles_w; ++tw) {
+                const float* mp = Mt + (size_t)(n * tiles + th * tiles_w + tw) * aa * out_c;
+                for (int oc = 0; oc < out_c; ++oc) {
+                    float b_val = bias ? bias[oc] : 0.0f;
+                    float* out_plane = out_image + oc * hw_out;
+                    float tmp[m * a]; // A^T M, column by column
+                    for (int j = 0; j < a; ++j) Tiles::output(mp + j * out_c + oc, a * out_c, tmp + j, a);
+                    float y_tile[m * m];
+                    for (int i = 0; i < m; ++i) Tiles::output(tmp + i * a, 1, y_tile + i * m, 1);
+
+                    for (int i = 0; i < m && th * m + i < H_out; ++i) {
+                        for (int j = 0; j < m && tw * m + j < W_out; ++j) {
+                            out_plane[(th * m + i) * W_out + tw * m + j] = y_tile[i * m + j] + b_val;
+                        }
+                    }
+                }
+            }
+        }
+
+        // Residual and ReLU over the image just written, while it is still in L1
+        if (relu || residual) {
+            const float* res_image = residual ? residual + (size_t)n * out_c * hw_out : nullptr;
+            k.epilogue(out_image, out_image, 0.0f, res_image, relu, out_c * hw_out);
+        }
+    }
+    arena.release(arena_mark);
+}
+
+#endif // WINOGRAD_H
@@ -0,0 +1,48 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <cstdint>
+
+// Zobrist keys for ContrastGame positions.
+// A position key is the XOR of one key per occupied square, per non-white
+// tile, per tile-stock value and the side to move, so step() can update it
+// in O(1) by XOR-ing out the old feature and XOR-ing in the new one.
+
+constexpr int ZOBRIST_MAX_STOCK = 4; // tile_counts values are 0..3
+
+struct ZobristTable
+{
+    uint64_t piece[2][25];                     // [PlayerIdx][Square]
+    uint64_t tile[2][25];                      // [0=Black, 1=Gray][Square]
+    uint64_t stock[2][2][ZOBRIST_MAX_STOCK];   // [PlayerIdx][0=Black, 1=Gray][Count]
+    uint64_t side;                             // Set when P2 is to move
+
+    constexpr ZobristTable() : piece{}, tile{}, stock{}, side(0)
+    {
+        uint64_t s = 0x5DEECE66DULL;
+        for (int p = 0; p < 2; ++p)
+            for (int i = 0; i < 25; ++i)
+                piece[p][i] = next(s);
+        for (int c = 0; c < 2; ++c)
+            for (int i = 0; i < 25; ++i)
+                tile[c][i] = next(s);
+        for (int p = 0; p < 2; ++p)
+            for (int c = 0; c < 2; ++c)
+                for (int n = 0; n < ZOBRIST_MAX_STOCK; ++n)
+                    stock[p][c][n] = next(s);
+        side = next(s);
+    }
+
+    // splitmix64
+    static constexpr uint64_t next(uint64_t &s)
+    {
+        uint64_t z = (s += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+};
+
+inline constexpr ZobristTable ZOBRIST{};
+
+#endif // ZOBRIST_H
@@ -11,7 +11,7 @@ import { useLanguage } from '@/contexts/LanguageContext';
 import { cn } from '@/lib/utils';
 import { useGameStore } from '@/store/useGameStore';
 import { cva } from 'class-variance-authority';
-import React, { useState } from 'react';
+import React, { useEffect, useState } from 'react';
 
 // Props removed - using store
 interface BoardProps { }
@@ -70,6 +70,16 @@ const Board: React.FC<BoardProps> = () => {
     const [placingTileType, setPlacingTileType] = useState<number | null>(null); // 1=Black, 2=Gray
     const [isPlacementOpen, setIsPlacementOpen] = useState(false);
 
+    // A finished game lists no legal moves; drop a selection made before it ended
+    useEffect(() => {
+        if (!game_over) return;
+        setSelected(null);
+        setValidMoves([]);
+        setPendingMove(null);
+        setPlacingTileType(null);
+        setIsPlacementOpen(false);
+    }, [game_over]);
+
     const handleCellClick = async (idx: number) => {
         if (game_over) return;
         if (current_player !== humanPlayer) return;
@@ -17,6 +17,10 @@ const GameSettings: React.FC<GameSettingsProps> = ({ className = "" }) => {
     const setHumanPlayer = useGameStore(state => state.setHumanPlayer);
     const simulationCount = useGameStore(state => state.simulationCount);
     const setSimulationCount = useGameStore(state => state.setSimulationCount);
+    const thinkTimeMs = useGameStore(state => state.thinkTimeMs);
+    const setThinkTime = useGameStore(state => state.setThinkTime);
+    const ponder = useGameStore(state => state.ponder);
+    const setPonder = useGameStore(state => state.setPonder);
 
     const handleSimChange = (e: React.ChangeEvent<HTMLInputElement>) => {
         const val = parseInt(e.target.value);
@@ -25,6 +29,14 @@ const GameSettings: React.FC<GameSettingsProps> = ({ className = "" }) => {
         }
     };
 
+    // 0 searches simulationCount instead
+    const handleTimeChange = (e: React.ChangeEvent<HTMLInputElement>) => {
+        const val = parseInt(e.target.value);
+        if (!isNaN(val) && val >= 0) {
+            setThinkTime(val);
+        }
+    };
+
     return (
         <div className={cn("space-y-6", className)}>
             {/* Language Settings */}
@@ -68,6 +80,31 @@ const GameSettings: React.FC<GameSettingsProps> = ({ className = "" }) => {
                             <span className="text-xs text-gray-600">sims</span>
                         </div>
                     </div>
+                    <div className="flex items-center gap-2 mt-2">
+                        <span className="text-xs text-gray-500 w-16">{t.settings.thinkTime}:</span>
+                        <div className="flex-1 flex items-center gap-2">
+                            <Input
+                                type="number"
+                                min={0}
+                                step={100}
+                                value={thinkTimeMs}
+                                onChange={handleTimeChange}
+                                className="h-8 bg-black/30 border-white/10 text-white text-xs font-mono focus-visible:ring-cyan-500"
+                            />
+                            <span className="text-xs text-gray-600">ms</span>
+                        </div>
+                    </div>
+                    <Button
+                        onClick={() => setPonder(!ponder)}
+                        variant={ponder ? "default" : "outline"}
+                        className={cn("w-full h-8 mt-3 text-xs font-bold border-transparent",
+                            ponder
+                                ? "bg-cyan-500/20 border-cyan-500 text-cyan-300 hover:bg-cyan-500/30 hover:text-cyan-200"
+                                : "bg-black/20 text-gray-500 hover:bg-white/5 hover:text-gray-300"
+                        )}
+                    >
+                        {t.settings.ponder}
+                    </Button>
                 </CardContent>
             </Card>
 
@@ -4,7 +4,7 @@ import { cn } from "@/lib/utils";
 import React from 'react';
 
 interface PlayerResourcesProps {
-    tileCounts: number[]; // [P1_Black, P1_Gray, P2_Black, P2_Gray]
+    tileCounts: ArrayLike<number>; // [P1_Black, P1_Gray, P2_Black, P2_Gray]
     targetPlayer: number; // 1 or 2
     label?: string;       // "You", "Opponent", "Player 1", etc.
     className?: string;   // Extra classes
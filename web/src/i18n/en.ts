@@ -32,6 +32,8 @@ export const en = {
         normal: "Normal",
         strong: "Strong",
         custom: "Custom",
+        thinkTime: "Time limit",
+        ponder: "Think on your time",
         selectSide: "SELECT SIDE",
         first: "First (P1)",
         second: "Second (P2)"
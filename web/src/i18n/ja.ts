@@ -32,6 +32,8 @@ export const ja = {
         normal: "普通",
         strong: "強い",
         custom: "カスタム",
+        thinkTime: "思考時間",
+        ponder: "相手の手番中も思考",
         selectSide: "手番選択",
         first: "先手 (赤)",
         second: "後手 (青)"
@@ -1,4 +1,4 @@
-import { type GameState, INITIAL_STATE, type Player } from '@/types';
+import { type GameState, INITIAL_STATE, type Player, validMovesFrom } from '@/types';
 import { create } from 'zustand';
 
 // No WasmModule interface needed here anymore as it's hidden in store/worker
@@ -14,7 +14,11 @@ interface GameStore {
     gameState: GameState;
     humanPlayer: Player | 0; // 0 = Spectator (AI vs AI)
     aiValue: number;
+    aiPV: number[]; // Principal variation of the search in progress (action hashes)
+    searchedSimulations: number;
     simulationCount: number;
+    thinkTimeMs: number; // Search for this long instead of simulationCount (0 = off)
+    ponder: boolean; // Search on the human's time
     isThinking: boolean;
     error: string | null;
     isReady: boolean;
@@ -22,6 +26,8 @@ interface GameStore {
     // Actions
     setHumanPlayer: (p: Player | 0) => void;
     setSimulationCount: (n: number) => void;
+    setThinkTime: (ms: number) => void;
+    setPonder: (on: boolean) => void;
     initialize: () => Promise<void>;
     resetGame: (startPlayer?: Player) => void;
     move: (from: number, to: number, tile?: { type: number, x: number, y: number }) => void;
@@ -33,20 +39,26 @@ interface GameStore {
 // Module instance replaced by Worker instance
 let worker: Worker | null = null;
 
-// Helper to handle async requests to worker (valid moves)
-const requestQueue: Record<string, (data: any) => void> = {};
-
 export const useGameStore = create<GameStore>((set, get) => ({
     gameState: INITIAL_STATE,
     humanPlayer: 1, // Default to Player 1
     aiValue: 0,
+    aiPV: [],
+    searchedSimulations: 0,
     simulationCount: 200,
+    thinkTimeMs: 0,
+    ponder: false,
     isThinking: false,
     error: null,
     isReady: false,
 
     setHumanPlayer: (p) => set({ humanPlayer: p }),
     setSimulationCount: (n) => set({ simulationCount: n }),
+    setThinkTime: (ms) => set({ thinkTimeMs: ms }),
+    setPonder: (on) => {
+        set({ ponder: on });
+        worker?.postMessage({ type: 'SET_PONDER', payload: { enabled: on } });
+    },
 
     initialize: async () => {
         if (worker) return; // Already initialized
@@ -57,23 +69,24 @@ export const useGameStore = create<GameStore>((set, get) => ({
 
         // Setup Listener
         worker.onmessage = (e) => {
-            const { type, payload, id } = e.data;
+            const { type, payload } = e.data;
             switch (type) {
                 case 'INIT_COMPLETE':
                     set({ isReady: true });
+                    if (get().ponder) worker?.postMessage({ type: 'SET_PONDER', payload: { enabled: true } });
                     break;
                 case 'STATE_UPDATE':
                     set({
-                        gameState: payload.state,
+                        gameState: payload.state ?? get().gameState, // null: unchanged
                         aiValue: payload.aiValue ?? get().aiValue,
                         error: null,
                         isThinking: false // Any state update implies logic done
                     });
                     break;
-                case 'VALID_MOVES':
-                    if (id && requestQueue[id]) {
-                         requestQueue[id](payload);
-                         delete requestQueue[id];
+                case 'SEARCH_PROGRESS':
+                    // Ignore progress of a search already abandoned
+                    if (get().isThinking) {
+                        set({ aiValue: payload.value, aiPV: payload.pv, searchedSimulations: payload.simulations });
                     }
                     break;
                 case 'ERROR':
@@ -92,7 +105,7 @@ export const useGameStore = create<GameStore>((set, get) => ({
         const { humanPlayer } = get();
         const targetPlayer = startPlayer ?? (humanPlayer === 0 ? 1 : humanPlayer);
         worker.postMessage({ type: 'RESET', payload: { humanPlayer: targetPlayer } });
-        set({ aiValue: 0, error: null });
+        set({ aiValue: 0, aiPV: [], error: null });
         
          // Auto-trigger handled by App effect or explicit logic?
          // App.tsx has effect: if (gameState.current_player === aiPlayer) triggerAI()
@@ -122,12 +135,16 @@ export const useGameStore = create<GameStore>((set, get) => ({
     undo: () => {
         if (!worker) return;
         const { isThinking, humanPlayer, gameState } = get();
-        
-        // Prevent undo while AI is thinking to avoid state corruption
-        if (isThinking) return;
 
         let steps = 1;
 
+        // The worker drops the search in progress on UNDO; only our last
+        // move needs taking back. isThinking clears with the state update.
+        if (isThinking) {
+            worker.postMessage({ type: 'UNDO', payload: { steps } });
+            return;
+        }
+
         // If playing against AI (humanPlayer is 1 or 2, not 0)
         // We typically want to undo 2 steps to get back to our turn (Undo AI move + Undo our move)
         // Unless it's Game Over or special case, but usually 2 is safe for "Tyro/Retry" feel.
@@ -151,22 +168,18 @@ export const useGameStore = create<GameStore>((set, get) => ({
 
     triggerAI: async () => {
         if (!worker) return;
-        const { isThinking, simulationCount } = get();
+        const { isThinking, simulationCount, thinkTimeMs } = get();
         if (isThinking) return;
 
-        set({ isThinking: true });
+        set({ isThinking: true, aiPV: [], searchedSimulations: 0 });
         
         // Send AI Think command
-        worker.postMessage({ type: 'AI_THINK', payload: { simulations: simulationCount } });
+        worker.postMessage({ type: 'AI_THINK', payload: { simulations: simulationCount, timeMs: thinkTimeMs || undefined } });
     },
 
+    // Answered from the legal actions in the last state update, without
+    // asking the worker
     getValidMoves: async (x, y) => {
-        if (!worker) return [];
-        
-        return new Promise<number[]>((resolve) => {
-            const id = Math.random().toString(36).substring(7);
-            requestQueue[id] = resolve;
-            worker?.postMessage({ type: 'GET_VALID_MOVES', id, payload: { x, y } });
-        });
+        return validMovesFrom(get().gameState, y * 5 + x);
     }
 }));
@@ -1,22 +1,40 @@
 export type Player = 1 | 2;
 export type TileType = 0 | 1 | 2; // White, Black, Gray
 
+// Typed arrays over one buffer, a copy of the engine's packed state
 export interface GameState {
-  pieces: number[]; // Flat 25
-  tiles: number[]; // Flat 25
-  tile_counts: number[]; // [P1_B, P1_G, P2_B, P2_G]
+  pieces: Int8Array; // Flat 25
+  tiles: Int8Array; // Flat 25
+  tile_counts: Int8Array; // [P1_B, P1_G, P2_B, P2_G]
   current_player: Player;
   game_over: boolean;
   winner: number;
   move_count: number;
+  legal_actions: Uint16Array; // Action hashes, (from * 25 + to) * 51 + tile; empty once the game is over
+  version: number; // Of the packed state this was read from
 }
 
 export const INITIAL_STATE: GameState = {
-  pieces: Array(25).fill(0),
-  tiles: Array(25).fill(0),
-  tile_counts: [3, 1, 3, 1],
+  pieces: new Int8Array(25),
+  tiles: new Int8Array(25),
+  tile_counts: Int8Array.of(3, 1, 3, 1),
   current_player: 1,
   game_over: false,
   winner: 0,
-  move_count: 0
+  move_count: 0,
+  legal_actions: new Uint16Array(0),
+  version: 0
 };
+
+// Destination squares of the legal moves from square `from`; none once the
+// game is over, as the engine lists no legal actions then
+export function validMovesFrom(state: GameState, from: number): number[] {
+  const moves: number[] = [];
+  if (state.game_over) return moves;
+  for (const action of state.legal_actions) {
+    const move = Math.floor(action / 51);
+    const to = move % 25;
+    if (Math.floor(move / 25) === from && !moves.includes(to)) moves.push(to);
+  }
+  return moves;
+}
@@ -1,15 +1,63 @@
 /* eslint-disable no-restricted-globals */
+import type { GameState, Player } from '../types';
+
+// Result of ai_think / ai_think_time
+interface SearchResult {
+    action: number;
+    value: number;
+    simulations: number;
+    elapsed_ms: number;
+    stopped_early: boolean;
+}
+
+// Result of continue_search / finish_search: the search so far
+interface SearchProgress extends SearchResult {
+    pv: number[]; // Principal variation, from the move to play
+    total_simulations: number;
+    total_elapsed_ms: number;
+    root_visits: number; // Including those from earlier searches and pondering
+    done: boolean; // The limits given to begin_search are reached, or the best move is decided
+}
+
+// Byte offsets of the fields in the packed state (get_state_layout)
+interface StateLayout {
+    size: number;
+    version: number;
+    move_count: number;
+    num_actions: number;
+    pieces: number;
+    tiles: number;
+    tile_counts: number;
+    current_player: number;
+    game_over: number;
+    winner: number;
+    actions: number;
+}
 
 // Define the Wasm module interface (simplified for worker)
 interface WasmModule {
-    init_game: (model_path: string) => void;
+    init_game: (model_path: string) => boolean;
     reset_game: (human_player: number) => void;
     get_state: () => any;
-    get_valid_moves: (x: number, y: number) => any; // Returns vector or array
+    get_state_view: () => Uint8Array; // The packed state in wasm memory
+    get_state_layout: () => StateLayout;
     step: (action: number) => { success: boolean, game_over: boolean, winner: number, error?: string };
     undo: () => boolean;
-    ai_think: (sims: number) => { action: number, value: number };
+    ai_think: (sims: number) => SearchResult;
+    ai_think_time: (timeMs: number) => SearchResult;
+    begin_search: (sims: number, timeMs: number) => boolean;
+    continue_search: (sims: number) => SearchProgress | null;
+    finish_search: () => SearchProgress | null;
+    cancel_search: () => void;
+    set_ponder: (on: boolean) => void;
+    start_ponder: () => boolean;
+    ponder: (sims: number) => boolean;
     decode_action: (hash: number) => any;
+    set_tt_size: (megabytes: number) => void;
+    set_batch_size: (batchSize: number) => void;
+    get_tt_stats: () => { nodes: number, capacity: number, occupancy: number, memory_bytes: number, lookups: number, hits: number, hit_rate: number, evictions: number, collections: number };
+    set_eval_cache_size: (megabytes: number) => void;
+    get_eval_cache_stats: () => { capacity: number, memory_bytes: number, lookups: number, hits: number, misses: number, hit_rate: number, stores: number } | null;
     FS: any;
 }
 
@@ -25,9 +73,24 @@ const ctx: Worker = self as any;
 
 // Initial state definition removed (unused)
 
+// Simulations per continue_search call: small enough that a queued message
+// (undo, new game) waits at most a few tens of milliseconds
+const SEARCH_CHUNK = 16;
+
+// Incremented whenever a search starts or is abandoned; a chunk scheduled
+// for an older id does nothing
+let searchId = 0;
+
+// Search the position while the human thinks (SET_PONDER)
+let ponderEnabled = false;
+
+// The packed state in wasm memory
+let stateView: Uint8Array | null = null;
+let stateLayout: StateLayout | null = null;
+
 // Handle Messages from Main Thread
 ctx.onmessage = async (e: MessageEvent) => {
-    const { type, payload, id } = e.data;
+    const { type, payload } = e.data;
 
     try {
         switch (type) {
@@ -39,64 +102,58 @@ ctx.onmessage = async (e: MessageEvent) => {
 
             case 'RESET':
                 if (!module) throw new Error("Module not initialized");
+                searchId++; // reset_game cancels the search in progress
                 module.reset_game(payload.humanPlayer); // 0 or 1 or 2
                 postState();
+                startPonder();
                 break;
 
             case 'MOVE':
                 if (!module) throw new Error("Module not initialized");
+                searchId++;
                 const res = module.step(payload.action);
                 if (!res.success) {
                     ctx.postMessage({ type: 'ERROR', payload: res.error || "Illegal Move" });
                 } else {
                     postState();
+                    startPonder(); // Until AI_THINK arrives, if it is the AI's turn
                 }
                 break;
 
             case 'UNDO':
                 if (!module) throw new Error("Module not initialized");
+                searchId++;
                 const steps = payload?.steps || 1;
                 for (let i = 0; i < steps; i++) {
                     module.undo();
                 }
                 postState();
+                startPonder();
                 break;
 
             case 'AI_THINK':
                 if (!module) throw new Error("Module not initialized");
-                // This is the heavy operation that blocks, now it runs here
-                const aiRes = module.ai_think(payload.simulations);
-                if (aiRes && aiRes.action >= 0) {
-                    // Apply the move immediately in the worker state
-                    module.step(aiRes.action);
-                    postState(aiRes.value); // Send back value too
-                }
+                // Searched in chunks so progress reaches the evaluation bar and
+                // UNDO/RESET/CANCEL_SEARCH are handled between them.
+                // A time budget (timeMs) keeps latency the same on slow devices;
+                // the search stops sooner once the best move cannot change.
+                startSearch(payload.simulations, payload.timeMs);
                 break;
 
-            case 'GET_VALID_MOVES':
-                if (!module) {
-                    ctx.postMessage({ type: 'VALID_MOVES', id, payload: [] });
-                    return;
-                }
-                const moves = module.get_valid_moves(payload.x, payload.y);
-                // Convert WASM vector to array if needed (Embind usually returns vector object)
-                // Assuming get_valid_moves returns a JS array or compatible vector
-                // If it returns a vector, we might need code to convert it.
-                // Assuming Embind returns a specialized vector object that is iterable or has .get(i)
-                // Let's assume it returns a vector and convert it safely.
-                const movesArray = [];
-                if (moves && typeof moves.size === 'number') {
-                    for(let i=0; i<moves.size(); i++) {
-                        movesArray.push(moves.get(i));
-                    }
-                    moves.delete(); // Important: delete C++ vector!!!
-                } else if (Array.isArray(moves)) {
-                     movesArray.push(...moves);
-                }
-                
-                ctx.postMessage({ type: 'VALID_MOVES', id, payload: movesArray });
+            case 'SET_PONDER':
+                if (!module) throw new Error("Module not initialized");
+                ponderEnabled = !!payload.enabled;
+                module.set_ponder(ponderEnabled);
+                if (ponderEnabled) startPonder();
+                else searchId++;
+                break;
+
+            case 'CANCEL_SEARCH':
+                if (!module) throw new Error("Module not initialized");
+                searchId++;
+                module.cancel_search();
                 break;
-                
+
             default:
                 console.warn("Unknown worker message:", type);
         }
@@ -106,6 +163,54 @@ ctx.onmessage = async (e: MessageEvent) => {
     }
 };
 
+function startSearch(simulations: number, timeMs?: number) {
+    if (!module) return;
+    const id = ++searchId;
+    // The module keeps the limits and counts visits kept from pondering
+    // towards the simulations
+    if (!module.begin_search(simulations, timeMs ?? 0)) {
+        postState();
+        return;
+    }
+
+    const runChunk = () => {
+        if (!module || id !== searchId) return; // Abandoned: step/undo/reset already dropped it
+        const progress = module.continue_search(SEARCH_CHUNK);
+        if (progress) {
+            const total = ponderEnabled ? progress.root_visits : progress.total_simulations;
+            if (progress.simulations > 0 && !progress.done) {
+                ctx.postMessage({ type: 'SEARCH_PROGRESS', payload: { value: progress.value, action: progress.action, pv: progress.pv, simulations: total } });
+                // Yield so messages that arrived meanwhile run before the next chunk
+                setTimeout(runChunk, 0);
+                return;
+            }
+        }
+
+        const result = module.finish_search();
+        if (result && result.action >= 0) {
+            // Apply the move immediately in the worker state
+            module.step(result.action);
+        }
+        postState(result ? result.value : 0); // Send back value too
+        startPonder();
+    };
+    runChunk();
+}
+
+// Ponders the current position in chunks until another message moves the
+// game on. Builds with threads ponder on their own and need no chunks.
+function startPonder() {
+    if (!module || !ponderEnabled) return;
+    const id = ++searchId;
+    if (!module.start_ponder()) return;
+
+    const runChunk = () => {
+        if (!module || id !== searchId) return;
+        if (module.ponder(SEARCH_CHUNK)) setTimeout(runChunk, 0);
+    };
+    setTimeout(runChunk, 0);
+}
+
 async function initialize(baseUrl: string) {
     if (module) return;
 
@@ -143,26 +248,50 @@ async function initialize(baseUrl: string) {
     const data = new Uint8Array(buffer);
 
     mod.FS.writeFile('/model.bin', data);
-    mod.init_game('/model.bin');
+    if (!mod.init_game('/model.bin')) throw new Error('Failed to load model.bin (see console for the reason)');
 
     module = mod;
     console.log("Worker: Module Initialized");
 }
 
-function postState(aiValue: number = 0) {
-    if (!module) return;
-    const raw = module.get_state();
-    
-    // Make sure we send a clean JS object
-    const state = {
-        pieces: Array.from(raw.pieces as Uint8Array), // Convert TypedArray/Vector
-        tiles: Array.from(raw.tiles as Uint8Array),
-        tile_counts: Array.from(raw.tile_counts as Uint8Array), // Assuming these are arrays/vectors
-        current_player: raw.current_player,
-        game_over: raw.game_over,
-        winner: raw.winner,
-        move_count: raw.move_count
+// The current position: one copy of the packed state out of wasm memory,
+// with typed-array views over the copy. Only the view and layout cross
+// embind, and postState() transfers the copy's buffer to the main thread
+// instead of cloning it.
+function readState(): GameState {
+    const mod = module!;
+    // A view is detached (byteLength 0) once wasm memory has grown
+    if (!stateView || stateView.byteLength === 0) stateView = mod.get_state_view();
+    if (!stateLayout) stateLayout = mod.get_state_layout();
+    const L = stateLayout;
+
+    const buffer = stateView.slice(0, L.size).buffer;
+    const view = new DataView(buffer);
+    return {
+        pieces: new Int8Array(buffer, L.pieces, 25),
+        tiles: new Int8Array(buffer, L.tiles, 25),
+        tile_counts: new Int8Array(buffer, L.tile_counts, 4),
+        current_player: view.getInt8(L.current_player) as Player,
+        game_over: view.getInt8(L.game_over) !== 0,
+        winner: view.getInt8(L.winner),
+        move_count: view.getUint16(L.move_count, true),
+        legal_actions: new Uint16Array(buffer, L.actions, view.getUint16(L.num_actions, true)),
+        version: view.getUint32(L.version, true)
     };
+}
+
+// Version of the last state posted. An unchanged state is neither copied
+// nor sent again (state: null).
+let postedVersion = -1;
 
-    ctx.postMessage({ type: 'STATE_UPDATE', payload: { state, aiValue } });
+function postState(aiValue: number = 0) {
+    if (!module) return;
+    if (stateView && stateView.byteLength > 0 && stateLayout &&
+        new DataView(stateView.buffer, stateView.byteOffset).getUint32(stateLayout.version, true) === postedVersion) {
+        ctx.postMessage({ type: 'STATE_UPDATE', payload: { state: null, aiValue } });
+        return;
+    }
+    const state = readState();
+    postedVersion = state.version;
+    ctx.postMessage({ type: 'STATE_UPDATE', payload: { state, aiValue } }, [state.pieces.buffer]);
 }